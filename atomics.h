@@ -0,0 +1,227 @@
+#pragma once
+
+/* portable atomics with explicit memory orders on plain integers & pointers:
+ *
+ * - atomic_{load|store|exchange}_{u32|u64|ptr}(ptr, ..., order)
+ * - atomic_cas_{u32|u64|ptr}(ptr, &expected, desired, order): strong compare
+ *   and swap, returns 1 on success, otherwise writes the current value into
+ *   expected. atomic_cas_weak_*() can fail spuriously (use it in loops)
+ * - atomic_fetch_{add|sub|and|or}_{u32|u64}(ptr, val, order): return the previous value
+ * - atomic_fence(order): thread fence, atomic_compiler_barrier(): compiler-only fence
+ * - CACHE_LINE_SIZE, CACHE_LINE_ALIGNED, CACHE_LINE_PAD(used): to keep hot
+ *   atomics on their own cache line (no false sharing)
+ *
+ * Memory orders are ATOMIC_{RELAXED|ACQUIRE|RELEASE|ACQ_REL|SEQ_CST}. They
+ * should be compile-time constants, unoptimized builds can fall back to
+ * seq_cst. The failure order of a CAS is derived from the success order.
+ *
+ * Backends: __atomic builtins (gcc, clang, mingw), _Interlocked intrinsics
+ * (msvc, read-modify-writes are always full barriers there) and <stdatomic.h>
+ * (tcc, or C11 with ATOMICS_USE_STDATOMIC).
+ *
+ * NOTE: variables have to be naturally aligned, u64 atomics on 32 bit targets
+ * can be slow (lock cmpxchg8b) or not lock-free at all.
+ */
+
+/* Example usage code:
+
+       typedef struct counter_t { u64 value; CACHE_LINE_PAD(sizeof(u64)); } counter_t;
+       counter_t counters[4];
+       atomic_fetch_add_u64(&counters[thread_idx].value, 1, ATOMIC_RELAXED);
+
+       // publish data: the release store orders the writes before it
+       data->x = 42;
+       atomic_store_ptr((void**) &shared, data, ATOMIC_RELEASE);
+       ...
+       data_t* d = (data_t*) atomic_load_ptr((void**) &shared, ATOMIC_ACQUIRE);
+       if (d) { ASSERT(d->x == 42); }
+*/
+
+#if defined(COMPILER_TCC) || defined(ATOMICS_USE_STDATOMIC)
+  #if defined(LANGUAGE_CPP)
+    #error "ATOMICS_USE_STDATOMIC is for C only"
+  #endif
+  #define ATOMICS_STDATOMIC
+  #include <stdatomic.h>
+  #define ATOMIC_RELAXED memory_order_relaxed
+  #define ATOMIC_ACQUIRE memory_order_acquire
+  #define ATOMIC_RELEASE memory_order_release
+  #define ATOMIC_ACQ_REL memory_order_acq_rel
+  #define ATOMIC_SEQ_CST memory_order_seq_cst
+#elif defined(COMPILER_MSVC)
+  #define ATOMICS_MSVC
+  #include <intrin.h>
+  #define ATOMIC_RELAXED 0
+  #define ATOMIC_ACQUIRE 2
+  #define ATOMIC_RELEASE 3
+  #define ATOMIC_ACQ_REL 4
+  #define ATOMIC_SEQ_CST 5
+#else
+  #define ATOMICS_BUILTIN
+  #define ATOMIC_RELAXED __ATOMIC_RELAXED
+  #define ATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+  #define ATOMIC_RELEASE __ATOMIC_RELEASE
+  #define ATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+  #define ATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+#endif
+typedef int atomic_order_t;
+
+/* a CAS can't release on failure (nothing is written) */
+#define ATOMICS_FAILURE_ORDER(order) ((order) == ATOMIC_RELEASE ? ATOMIC_RELAXED : \
+                                      (order) == ATOMIC_ACQ_REL ? ATOMIC_ACQUIRE : (order))
+
+/* cache lines */
+#ifndef CACHE_LINE_SIZE
+  #if defined(PLATFORM_MACOS) && defined(ARCH_ARM64)
+    #define CACHE_LINE_SIZE 128 /* apple silicon */
+  #else
+    #define CACHE_LINE_SIZE 64
+  #endif
+#endif
+#if defined(COMPILER_MSVC)
+  #define CACHE_LINE_ALIGNED __declspec(align(CACHE_LINE_SIZE))
+#else
+  #define CACHE_LINE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+#endif
+#define ATOMICS_CONCAT_(a, b)  a##b
+#define ATOMICS_CONCAT(a, b)   ATOMICS_CONCAT_(a, b)
+/* fills up the rest of a cache line after used bytes (a whole line if used is a multiple) */
+#define CACHE_LINE_PAD(used)   u8 ATOMICS_CONCAT(_cache_line_pad, __LINE__)[CACHE_LINE_SIZE - ((used) % CACHE_LINE_SIZE)]
+
+#if defined(ATOMICS_BUILTIN)
+  #define ATOMICS_DEFINE(type, suffix)                                                                        \
+    static inline type atomic_load_##suffix(type const* ptr, atomic_order_t order)                            \
+    { return __atomic_load_n(ptr, order); }                                                                   \
+    static inline void atomic_store_##suffix(type* ptr, type val, atomic_order_t order)                       \
+    { __atomic_store_n(ptr, val, order); }                                                                    \
+    static inline type atomic_exchange_##suffix(type* ptr, type val, atomic_order_t order)                    \
+    { return __atomic_exchange_n(ptr, val, order); }                                                          \
+    static inline b32 atomic_cas_##suffix(type* ptr, type* expected, type desired, atomic_order_t order)      \
+    { return __atomic_compare_exchange_n(ptr, expected, desired, 0, order, ATOMICS_FAILURE_ORDER(order)); }   \
+    static inline b32 atomic_cas_weak_##suffix(type* ptr, type* expected, type desired, atomic_order_t order) \
+    { return __atomic_compare_exchange_n(ptr, expected, desired, 1, order, ATOMICS_FAILURE_ORDER(order)); }
+  #define ATOMICS_DEFINE_ARITH(type, suffix)                                                \
+    static inline type atomic_fetch_add_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return __atomic_fetch_add(ptr, val, order); }                                         \
+    static inline type atomic_fetch_sub_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return __atomic_fetch_sub(ptr, val, order); }                                         \
+    static inline type atomic_fetch_and_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return __atomic_fetch_and(ptr, val, order); }                                         \
+    static inline type atomic_fetch_or_##suffix(type* ptr, type val, atomic_order_t order)  \
+    { return __atomic_fetch_or(ptr, val, order); }
+
+  static inline void atomic_fence(atomic_order_t order) { __atomic_thread_fence(order); }
+  static inline void atomic_compiler_barrier(void)      { __atomic_signal_fence(__ATOMIC_SEQ_CST); }
+
+#elif defined(ATOMICS_STDATOMIC)
+  /* NOTE: casts plain integers to _Atomic, fine as long as they have the same size & alignment (untested on tcc) */
+  #define ATOMICS_DEFINE(type, suffix)                                                                                     \
+    static inline type atomic_load_##suffix(type const* ptr, atomic_order_t order)                                         \
+    { return atomic_load_explicit((_Atomic(type)*) ptr, (memory_order) order); }                                           \
+    static inline void atomic_store_##suffix(type* ptr, type val, atomic_order_t order)                                    \
+    { atomic_store_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }                                            \
+    static inline type atomic_exchange_##suffix(type* ptr, type val, atomic_order_t order)                                 \
+    { return atomic_exchange_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }                                  \
+    static inline b32 atomic_cas_##suffix(type* ptr, type* expected, type desired, atomic_order_t order)                   \
+    { return atomic_compare_exchange_strong_explicit((_Atomic(type)*) ptr, expected, desired,                              \
+                                                     (memory_order) order, (memory_order) ATOMICS_FAILURE_ORDER(order)); } \
+    static inline b32 atomic_cas_weak_##suffix(type* ptr, type* expected, type desired, atomic_order_t order)              \
+    { return atomic_compare_exchange_weak_explicit((_Atomic(type)*) ptr, expected, desired,                                \
+                                                   (memory_order) order, (memory_order) ATOMICS_FAILURE_ORDER(order)); }
+  #define ATOMICS_DEFINE_ARITH(type, suffix)                                                \
+    static inline type atomic_fetch_add_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return atomic_fetch_add_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }  \
+    static inline type atomic_fetch_sub_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return atomic_fetch_sub_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }  \
+    static inline type atomic_fetch_and_##suffix(type* ptr, type val, atomic_order_t order) \
+    { return atomic_fetch_and_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }  \
+    static inline type atomic_fetch_or_##suffix(type* ptr, type val, atomic_order_t order)  \
+    { return atomic_fetch_or_explicit((_Atomic(type)*) ptr, val, (memory_order) order); }
+
+  static inline void atomic_fence(atomic_order_t order) { atomic_thread_fence((memory_order) order); }
+  static inline void atomic_compiler_barrier(void)      { atomic_signal_fence(memory_order_seq_cst); }
+
+#elif defined(ATOMICS_MSVC)
+  /* x86/x64: plain loads are acquire & plain stores are release (with a compiler barrier),
+   * arm64: ldar/stlr. Read-modify-writes are full barriers on both */
+  #if defined(ARCH_ARM64)
+    #define ATOMICS_MSVC_LOAD(bits, ptr, order)                                                       \
+        (((order) == ATOMIC_RELAXED) ? __iso_volatile_load##bits((const volatile __int##bits*) (ptr)) \
+                                     : (__int##bits) __ldar##bits((volatile unsigned __int##bits*) (ptr)))
+    #define ATOMICS_MSVC_STORE(bits, ptr, val, order)                                                                      \
+        if ((order) == ATOMIC_RELAXED) { __iso_volatile_store##bits((volatile __int##bits*) (ptr), (__int##bits) (val)); } \
+        else                           { __stlr##bits((volatile unsigned __int##bits*) (ptr), (unsigned __int##bits) (val)); }
+    static inline void atomic_fence(atomic_order_t order) { (void) order; __dmb(_ARM64_BARRIER_ISH); }
+  #else
+    #define ATOMICS_MSVC_LOAD(bits, ptr, order) \
+        ((void) (order), atomics_msvc_load##bits((const volatile __int##bits*) (ptr)))
+    #define ATOMICS_MSVC_STORE(bits, ptr, val, order)                         \
+        if ((order) == ATOMIC_SEQ_CST) { ATOMICS_MSVC_XCHG##bits(ptr, val); } \
+        else { _ReadWriteBarrier(); *(volatile __int##bits*) (ptr) = (__int##bits) (val); _ReadWriteBarrier(); }
+    static inline __int32 atomics_msvc_load32(const volatile __int32* ptr) { __int32 v = *ptr; _ReadWriteBarrier(); return v; }
+    static inline __int64 atomics_msvc_load64(const volatile __int64* ptr) { __int64 v = *ptr; _ReadWriteBarrier(); return v; }
+    static inline void atomic_fence(atomic_order_t order)
+    {
+        if (order == ATOMIC_SEQ_CST) { _mm_mfence(); }  /* only store-load reordering needs a real fence */
+        else                         { _ReadWriteBarrier(); }
+    }
+  #endif
+  #define ATOMICS_MSVC_XCHG32(ptr, val) _InterlockedExchange((volatile long*) (ptr), (long) (val))
+  #define ATOMICS_MSVC_XCHG64(ptr, val) _InterlockedExchange64((volatile __int64*) (ptr), (__int64) (val))
+  static inline void atomic_compiler_barrier(void) { _ReadWriteBarrier(); }
+
+  #define ATOMICS_DEFINE_MSVC(type, bits, itype, xchg, cmpxchg, add, and_, or_)                             \
+    static inline type atomic_load_##type(type const* ptr, atomic_order_t order)                            \
+    { return (type) ATOMICS_MSVC_LOAD(bits, ptr, order); }                                                  \
+    static inline void atomic_store_##type(type* ptr, type val, atomic_order_t order)                       \
+    { ATOMICS_MSVC_STORE(bits, ptr, val, order) }                                                           \
+    static inline type atomic_exchange_##type(type* ptr, type val, atomic_order_t order)                    \
+    { (void) order; return (type) xchg((volatile itype*) ptr, (itype) val); }                               \
+    static inline b32 atomic_cas_##type(type* ptr, type* expected, type desired, atomic_order_t order)      \
+    {                                                                                                       \
+        (void) order;                                                                                       \
+        type prev = (type) cmpxchg((volatile itype*) ptr, (itype) desired, (itype) *expected);              \
+        if (prev == *expected) { return 1; }                                                                \
+        *expected = prev;                                                                                   \
+        return 0;                                                                                           \
+    }                                                                                                       \
+    static inline b32 atomic_cas_weak_##type(type* ptr, type* expected, type desired, atomic_order_t order) \
+    { return atomic_cas_##type(ptr, expected, desired, order); }                                            \
+    static inline type atomic_fetch_add_##type(type* ptr, type val, atomic_order_t order)                   \
+    { (void) order; return (type) add((volatile itype*) ptr, (itype) val); }                                \
+    static inline type atomic_fetch_sub_##type(type* ptr, type val, atomic_order_t order)                   \
+    { (void) order; return (type) add((volatile itype*) ptr, (itype) (0 - val)); }                          \
+    static inline type atomic_fetch_and_##type(type* ptr, type val, atomic_order_t order)                   \
+    { (void) order; return (type) and_((volatile itype*) ptr, (itype) val); }                               \
+    static inline type atomic_fetch_or_##type(type* ptr, type val, atomic_order_t order)                    \
+    { (void) order; return (type) or_((volatile itype*) ptr, (itype) val); }
+
+  ATOMICS_DEFINE_MSVC(u32, 32, long,    _InterlockedExchange,   _InterlockedCompareExchange,   _InterlockedExchangeAdd,   _InterlockedAnd,   _InterlockedOr)
+  ATOMICS_DEFINE_MSVC(u64, 64, __int64, _InterlockedExchange64, _InterlockedCompareExchange64, _InterlockedExchangeAdd64, _InterlockedAnd64, _InterlockedOr64)
+
+  /* pointers go through the integer of the same size */
+  #if defined(ARCH_X64) || defined(ARCH_ARM64)
+    #define ATOMICS_PTR_INT u64
+  #else
+    #define ATOMICS_PTR_INT u32
+  #endif
+  #define ATOMICS_PTR_CALL(op, ptr, ...) ATOMICS_CONCAT(op, ATOMICS_PTR_INT)((ATOMICS_PTR_INT*) (ptr), __VA_ARGS__)
+  static inline void* atomic_load_ptr(void* const* ptr, atomic_order_t order)
+  { return (void*) ATOMICS_CONCAT(atomic_load_, ATOMICS_PTR_INT)((const ATOMICS_PTR_INT*) ptr, order); }
+  static inline void  atomic_store_ptr(void** ptr, void* val, atomic_order_t order)
+  { ATOMICS_PTR_CALL(atomic_store_, ptr, (ATOMICS_PTR_INT) val, order); }
+  static inline void* atomic_exchange_ptr(void** ptr, void* val, atomic_order_t order)
+  { return (void*) ATOMICS_PTR_CALL(atomic_exchange_, ptr, (ATOMICS_PTR_INT) val, order); }
+  static inline b32 atomic_cas_ptr(void** ptr, void** expected, void* desired, atomic_order_t order)
+  { return ATOMICS_PTR_CALL(atomic_cas_, ptr, (ATOMICS_PTR_INT*) expected, (ATOMICS_PTR_INT) desired, order); }
+  static inline b32 atomic_cas_weak_ptr(void** ptr, void** expected, void* desired, atomic_order_t order)
+  { return atomic_cas_ptr(ptr, expected, desired, order); }
+#endif
+
+#if !defined(ATOMICS_MSVC)
+  ATOMICS_DEFINE(u32,   u32)
+  ATOMICS_DEFINE(u64,   u64)
+  ATOMICS_DEFINE(void*, ptr) /* NOTE: T** has to be cast to void** */
+  ATOMICS_DEFINE_ARITH(u32, u32)
+  ATOMICS_DEFINE_ARITH(u64, u64)
+#endif
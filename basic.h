@@ -7,9 +7,17 @@
  * [-] dynamic array
  * [ ] hashtable
  * [ ] strings & string api
+ *     [x] string interning
+ *     [x] owning string w/ small string optimization
+ *     [x] string views
+ *     [x] string builder & printf
  * [ ] (pseudo) random number generator
- * [ ] file & filepath operations
- * [ ] threads
+ * [-] file & filepath operations
+ *     [x] memory mapped files
+ *     [x] async i/o
+ *     [x] whole file reads & directory walks into arenas
+ * [x] threads
+ *     [x] job system
  *
  * for what else to add and how to do it, see
    https://nullprogram.com/blog/2023/02/11/
@@ -47,7 +55,10 @@
   //WARNING_TO_IGNORE("-Wunknown-pragmas", 4068)
 #endif
 
-#ifdef ENABLE_LOGGING /* NOTE: unused */
+#ifndef ENABLE_LOGGING
+  #ifndef LOG_COMPILE_MASK
+    #define LOG_COMPILE_MASK 0 /* strips all LOG(...) calls that have a severity */
+  #endif
 #endif
 
 #ifndef ENABLE_ASSERTS
@@ -56,6 +67,7 @@
 #endif
 
 #include "maths.h"     /* depends on typedefs from platform.h */
+#include "atomics.h"   /* depends on typedefs from platform.h */
 
 #ifdef BASIC_IMPLEMENTATION
   #define MEMORY_IMPLEMENTATION
@@ -74,8 +86,22 @@
 #include "memory/mem_arena.h"
 
 #include "dynarr.h"    /* depends on memory.h */
+#include "strintern.h" /* depends on memory.h & mem_arena.h */
+#include "str8.h"      /* depends on mem_arena.h */
+#include "strbuild.h"  /* depends on mem_arena.h & str8.h */
+#include "string_t.h"  /* depends on mem_arena.h & str8.h */
 
 /* standalones: these do not depend on other headers or on each other */
 #include "macros.h"
 #include "ext/utlist.h"      /* linked list macros (thirdparty) */
+#ifdef BASIC_IMPLEMENTATION
+  #define LOG_IMPLEMENTATION
+#endif
 #include "log/log.h"
+
+#include "profile.h"         /* depends on memory.h & macros.h */
+#include "metrics.h"         /* depends on memory.h, mem_arena.h, atomics.h & log.h */
+#include "job.h"             /* depends on mem_arena.h & atomics.h */
+#include "queue.h"           /* depends on memory.h, mem_arena.h & atomics.h */
+#include "file.h"            /* depends on memory.h */
+#include "platform/aio.h"    /* depends on platform.h */
@@ -0,0 +1,648 @@
+#pragma once
+
+/* file i/o, either through memory mappings (no read() into a buffer & no copy):
+ *
+ * - file_map():        maps a whole file, either read-only, copy-on-write
+ *                      (private, writes never reach the file) or shared
+ *                      (writes go to the file, flush with file_map_sync())
+ * - file_map_create(): creates/truncates a file of a given size & maps it shared
+ * - file_window_t:     sliding window over files that are too big to map at
+ *                      once (or that we don't want to spend address space on),
+ *                      only window_size bytes are mapped at a time
+ *
+ * Hints are passed to madvise() (FILE_HINT_WILLNEED starts readahead right away)
+ * & to CreateFile() on windows. Mapping an empty file succeeds with ptr == NULL.
+ *
+ * or into arenas, for loading/scanning lots of small files without malloc():
+ *
+ * - file_read_all():   one open, fstat & read per file, straight into a buffer
+ *                      pushed onto the arena (no growing & copying)
+ * - file_dir_t:        directory iterator, entries are read in batches into a
+ *                      caller provided buffer (getdents64() on linux, readdir()
+ *                      on other posix, FindFirstFile() on windows)
+ * - file_dir_walk():   recursive walk, one arena buffer per depth is reused for
+ *                      every directory at that depth & children are opened
+ *                      relative to their parent (openat() on linux)
+ */
+
+/* Example usage code:
+
+       file_map_t map;
+       if (file_map(&map, "assets/level.bin", FILE_MAPPING_READONLY, FILE_HINT_SEQUENTIAL))
+       {
+           parse_level(map.ptr, map.size);
+           file_unmap(&map);
+       }
+
+       file_window_t w;
+       file_window_open(&w, "huge.log", MEGABYTES(64), FILE_HINT_SEQUENTIAL);
+       u64 available;
+       for (u64 off = 0; off < w.file_size; off += available)
+       {
+           u8* ptr = file_window_map(&w, off, 1, &available); // ptr[0..available) is mapped
+           ...
+       }
+       file_window_close(&w);
+
+       str8 text = file_read_all(arena, "shaders/basic.glsl"); // text.ptr is NUL terminated
+       if (!text.ptr) { ... } // NULL: couldn't be read, len 0 is an empty file
+
+       file_walk_e on_entry(void* user, str8 path, const file_dir_entry_t* entry)
+       {
+           if (str8_equal(entry->name, S(".git"))) { return FILE_WALK_SKIP; }
+           if (entry->type == FILE_TYPE_REGULAR)    { index_file(user, path); }
+           return FILE_WALK_CONTINUE;
+       }
+       file_dir_walk(arena, "assets", on_entry, &index);
+*/
+
+typedef enum file_mapping_e
+{
+    FILE_MAPPING_READONLY,
+    FILE_MAPPING_PRIVATE,  /* copy-on-write, changes are discarded on unmap */
+    FILE_MAPPING_SHARED,   /* read/write, changes are written back to the file */
+} file_mapping_e;
+
+typedef enum file_hint_e
+{
+    FILE_HINT_NONE       = 0,
+    FILE_HINT_SEQUENTIAL = 1 << 0, /* aggressive readahead, pages can be dropped after access */
+    FILE_HINT_RANDOM     = 1 << 1, /* no readahead */
+    FILE_HINT_WILLNEED   = 1 << 2, /* start reading the whole mapping in now */
+} file_hint_e;
+
+typedef struct file_map_t
+{
+    u8*            ptr;    /* NULL for empty files */
+    u64            size;
+    file_mapping_e mapping;
+    void*          handle; /* windows: file handle of shared mappings (for flushing) */
+} file_map_t;
+
+typedef struct file_window_t
+{
+    u8*   ptr;         /* current view: file bytes [offset, offset + size) */
+    u64   offset;
+    u64   size;
+    u64   file_size;
+    u64   window_size; /* multiple of the mapping granularity */
+    u32   hints;
+    i32   fd;          /* posix */
+    void* handle;      /* windows: file & mapping handle */
+    void* mapping;
+} file_window_t;
+
+b32  file_map         (file_map_t* map, const char* path, file_mapping_e mapping, u32 hints);
+b32  file_map_create  (file_map_t* map, const char* path, u64 size);
+b32  file_map_sync    (file_map_t* map, u64 offset, u64 size, b32 wait); /* wait: until it's on disk */
+void file_unmap       (file_map_t* map);
+
+b32  file_window_open (file_window_t* w, const char* path, u64 window_size, u32 hints);
+u8*  file_window_map  (file_window_t* w, u64 offset, u64 min_size, u64* available); /* NULL past the end */
+void file_window_close(file_window_t* w);
+
+/* whole file into a buffer pushed onto arena, with a NUL byte after the
+ * contents. ptr is NULL if the file can't be opened/read or doesn't fit into
+ * the arena, files that report a size of 0 (pipes, /proc) are read in chunks */
+#ifndef FILE_READ_CHUNK
+  #define FILE_READ_CHUNK     KILOBYTES(4)
+#endif
+str8 file_read_all(mem_arena_t* arena, const char* path);
+
+#ifndef FILE_DIR_BUFFER_SIZE
+  #define FILE_DIR_BUFFER_SIZE KILOBYTES(32) /* ~1000 entries per getdents64() */
+#endif
+#ifndef FILE_WALK_MAX_DEPTH
+  #define FILE_WALK_MAX_DEPTH  64  /* deeper directories are reported, not entered */
+#endif
+#define FILE_PATH_MAX          4096
+
+typedef enum file_type_e
+{
+    FILE_TYPE_UNKNOWN,
+    FILE_TYPE_REGULAR,
+    FILE_TYPE_DIRECTORY,
+    FILE_TYPE_SYMLINK,   /* not followed by file_dir_walk() */
+    FILE_TYPE_OTHER,     /* devices, pipes, sockets */
+} file_type_e;
+
+typedef struct file_dir_entry_t
+{
+    str8        name; /* NUL terminated, points into the dir buffer: valid until the next file_dir_next() */
+    file_type_e type;
+} file_dir_entry_t;
+
+typedef struct file_dir_t
+{
+    u8*   buffer;   /* caller provided, e.g. FILE_DIR_BUFFER_SIZE bytes pushed onto an arena */
+    u64   capacity;
+    u64   pos;      /* linux: unread entries are buffer[pos, end) */
+    u64   end;
+    i32   fd;       /* linux */
+    void* handle;   /* windows: find handle, other posix: DIR* */
+} file_dir_t;
+
+/* "." & ".." are skipped */
+b32  file_dir_open (file_dir_t* dir, const char* path, u8* buffer, u64 capacity);
+b32  file_dir_next (file_dir_t* dir, file_dir_entry_t* entry);
+void file_dir_close(file_dir_t* dir);
+
+typedef enum file_walk_e
+{
+    FILE_WALK_CONTINUE,
+    FILE_WALK_SKIP,     /* don't enter this directory */
+    FILE_WALK_STOP,
+} file_walk_e;
+
+/* path is root/.../name (NUL terminated, valid during the call) */
+typedef file_walk_e (*file_walk_func_t)(void* user, str8 path, const file_dir_entry_t* entry);
+
+/* returns 0 if root can't be opened, the arena runs out of space for a
+ * directory buffer (the walk ends there) or func stopped the walk. The buffers
+ * are popped off the arena afterwards, unless func pushed onto the same arena */
+b32  file_dir_walk (mem_arena_t* arena, const char* root, file_walk_func_t func, void* user);
+
+#ifdef BASIC_IMPLEMENTATION
+#include <string.h> /* for memset */
+#if defined(PLATFORM_WIN32)
+  #include <windows.h>
+#else
+  #include <errno.h>    /* for errno, EINTR */
+  #include <fcntl.h>    /* for open, openat */
+  #include <sys/mman.h> /* for mmap, madvise, msync */
+  #include <sys/stat.h> /* for fstat, fstatat */
+  #include <unistd.h>   /* for close, ftruncate, read */
+  #include <dirent.h>   /* for DT_*, opendir, readdir */
+  #if defined(PLATFORM_LINUX)
+    #include <sys/syscall.h> /* for SYS_getdents64 */
+  #endif
+#endif
+
+/* offsets of mapped views have to be aligned to this */
+static u64 file_map_granularity()
+{
+#if defined(PLATFORM_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return mem_pagesize();
+#endif
+}
+
+#if !defined(PLATFORM_WIN32)
+static void file_advise(void* ptr, u64 size, u32 hints)
+{
+    if (hints & FILE_HINT_SEQUENTIAL) { madvise(ptr, size, MADV_SEQUENTIAL); }
+    if (hints & FILE_HINT_RANDOM)     { madvise(ptr, size, MADV_RANDOM);     }
+    if (hints & FILE_HINT_WILLNEED)   { madvise(ptr, size, MADV_WILLNEED);   }
+}
+#else
+static DWORD file_hint_flags(u32 hints)
+{
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hints & FILE_HINT_SEQUENTIAL) { flags |= FILE_FLAG_SEQUENTIAL_SCAN; }
+    if (hints & FILE_HINT_RANDOM)     { flags |= FILE_FLAG_RANDOM_ACCESS;   }
+    return flags; /* NOTE: FILE_HINT_WILLNEED would need PrefetchVirtualMemory (win8) */
+}
+#endif
+
+b32 file_map(file_map_t* map, const char* path, file_mapping_e mapping, u32 hints)
+{
+    memset(map, 0, sizeof(*map));
+    map->mapping = mapping;
+#if defined(PLATFORM_WIN32)
+    DWORD access = (mapping == FILE_MAPPING_SHARED) ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+    HANDLE file  = CreateFileA(path, access, FILE_SHARE_READ, NULL, OPEN_EXISTING, file_hint_flags(hints), NULL);
+    if (file == INVALID_HANDLE_VALUE) { return 0; }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return 0; }
+    map->size = (u64) size.QuadPart;
+    if (map->size)
+    {
+        DWORD protect = (mapping == FILE_MAPPING_SHARED) ? PAGE_READWRITE : (mapping == FILE_MAPPING_PRIVATE) ? PAGE_WRITECOPY : PAGE_READONLY;
+        DWORD view    = (mapping == FILE_MAPPING_SHARED) ? FILE_MAP_WRITE : (mapping == FILE_MAPPING_PRIVATE) ? FILE_MAP_COPY  : FILE_MAP_READ;
+        HANDLE section = CreateFileMappingA(file, NULL, protect, 0, 0, NULL);
+        if (section) { map->ptr = (u8*) MapViewOfFile(section, view, 0, 0, 0); CloseHandle(section); } /* the view keeps it alive */
+        if (!map->ptr) { CloseHandle(file); return 0; }
+    }
+    if (mapping == FILE_MAPPING_SHARED) { map->handle = file; }
+    else                                { CloseHandle(file);  }
+#else
+    int fd = open(path, (mapping == FILE_MAPPING_SHARED) ? O_RDWR : O_RDONLY);
+    if (fd < 0) { return 0; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return 0; }
+    map->size = (u64) st.st_size;
+    if (map->size)
+    {
+        int prot  = (mapping == FILE_MAPPING_READONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+        int flags = (mapping == FILE_MAPPING_SHARED)   ? MAP_SHARED : MAP_PRIVATE;
+        void* ptr = mmap(NULL, map->size, prot, flags, fd, 0);
+        if (ptr == MAP_FAILED) { close(fd); return 0; }
+        map->ptr = (u8*) ptr;
+        file_advise(ptr, map->size, hints);
+    }
+    close(fd); /* the mapping holds its own reference to the file */
+#endif
+    return 1;
+}
+
+b32 file_map_create(file_map_t* map, const char* path, u64 size)
+{
+    memset(map, 0, sizeof(*map));
+    map->mapping = FILE_MAPPING_SHARED;
+    map->size    = size;
+#if defined(PLATFORM_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return 0; }
+    if (size)
+    {
+        /* the mapping extends the file to its size */
+        HANDLE section = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD) (size >> 32), (DWORD) size, NULL);
+        if (section) { map->ptr = (u8*) MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, 0); CloseHandle(section); }
+        if (!map->ptr) { CloseHandle(file); return 0; }
+    }
+    map->handle = file;
+#else
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { return 0; }
+    if (size)
+    {
+        void* ptr = (ftruncate(fd, (off_t) size) == 0) ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (ptr == MAP_FAILED) { close(fd); return 0; }
+        map->ptr = (u8*) ptr;
+    }
+    close(fd);
+#endif
+    return 1;
+}
+
+b32 file_map_sync(file_map_t* map, u64 offset, u64 size, b32 wait)
+{
+    if (map->mapping != FILE_MAPPING_SHARED) { return 0; }
+    if (!map->ptr || offset >= map->size)    { return 1; }
+    if (size > map->size - offset)           { size = map->size - offset; }
+#if defined(PLATFORM_WIN32)
+    b32 flushed = FlushViewOfFile(map->ptr + offset, (SIZE_T) size) != 0;
+    if (flushed && wait) { flushed = FlushFileBuffers((HANDLE) map->handle) != 0; }
+    return flushed;
+#else
+    u64 aligned = PREV_ALIGN_POW2(offset, file_map_granularity()); /* msync wants a page aligned address */
+    return msync(map->ptr + aligned, size + (offset - aligned), wait ? MS_SYNC : MS_ASYNC) == 0;
+#endif
+}
+
+void file_unmap(file_map_t* map)
+{
+#if defined(PLATFORM_WIN32)
+    if (map->ptr)    { UnmapViewOfFile(map->ptr); }
+    if (map->handle) { CloseHandle((HANDLE) map->handle); }
+#else
+    if (map->ptr)    { munmap(map->ptr, map->size); }
+#endif
+    memset(map, 0, sizeof(*map));
+}
+
+b32 file_window_open(file_window_t* w, const char* path, u64 window_size, u32 hints)
+{
+    memset(w, 0, sizeof(*w));
+    u64 granularity = file_map_granularity();
+    w->window_size  = (window_size > granularity) ? NEXT_ALIGN_POW2(window_size, granularity) : granularity;
+    w->hints        = hints;
+#if defined(PLATFORM_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, file_hint_flags(hints), NULL);
+    if (file == INVALID_HANDLE_VALUE) { return 0; }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return 0; }
+    w->file_size = (u64) size.QuadPart;
+    w->handle    = file;
+    if (w->file_size)
+    {
+        w->mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!w->mapping) { CloseHandle(file); return 0; }
+    }
+#else
+    w->fd = open(path, O_RDONLY);
+    if (w->fd < 0) { return 0; }
+    struct stat st;
+    if (fstat(w->fd, &st) != 0) { close(w->fd); return 0; }
+    w->file_size = (u64) st.st_size;
+#endif
+    return 1;
+}
+
+u8* file_window_map(file_window_t* w, u64 offset, u64 min_size, u64* available)
+{
+    *available = 0;
+    if (offset >= w->file_size) { return NULL; }
+    u64 end = offset + ((min_size > 0) ? min_size : 1);
+    if (end > w->file_size) { end = w->file_size; }
+
+    /* remap if the requested range isn't in the current view */
+    if (!w->ptr || offset < w->offset || end > w->offset + w->size)
+    {
+        u64 granularity = file_map_granularity();
+        u64 base        = PREV_ALIGN_POW2(offset, granularity);
+        u64 size        = NEXT_ALIGN_POW2(end - base, granularity);
+        if (size < w->window_size)       { size = w->window_size;       }
+        if (size > w->file_size - base)  { size = w->file_size - base;  }
+    #if defined(PLATFORM_WIN32)
+        if (w->ptr) { UnmapViewOfFile(w->ptr); }
+        w->ptr = (u8*) MapViewOfFile((HANDLE) w->mapping, FILE_MAP_READ, (DWORD) (base >> 32), (DWORD) base, (SIZE_T) size);
+    #else
+        if (w->ptr) { munmap(w->ptr, w->size); }
+        void* ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, w->fd, (off_t) base);
+        w->ptr    = (ptr == MAP_FAILED) ? NULL : (u8*) ptr;
+        if (w->ptr) { file_advise(w->ptr, size, w->hints); }
+    #endif
+        w->offset = base;
+        w->size   = w->ptr ? size : 0;
+        if (!w->ptr) { return NULL; }
+    }
+    *available = w->offset + w->size - offset;
+    return w->ptr + (offset - w->offset);
+}
+
+void file_window_close(file_window_t* w)
+{
+#if defined(PLATFORM_WIN32)
+    if (w->ptr)     { UnmapViewOfFile(w->ptr); }
+    if (w->mapping) { CloseHandle((HANDLE) w->mapping); }
+    if (w->handle)  { CloseHandle((HANDLE) w->handle); }
+#else
+    if (w->ptr)     { munmap(w->ptr, w->size); }
+    if (w->fd >= 0) { close(w->fd); }
+#endif
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+}
+
+str8 file_read_all(mem_arena_t* arena, const char* path)
+{
+    str8 result = str8_make(NULL, 0);
+#if defined(PLATFORM_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return result; }
+    LARGE_INTEGER file_size;
+    u64 size = GetFileSizeEx(file, &file_size) ? (u64) file_size.QuadPart : 0;
+    if (size + 1 <= (u64) (arena->end - arena->pos))
+    {
+        u8* buf = (u8*) mem_arena_push(arena, size + 1);
+        u64 len = 0;
+        for (DWORD n = 1; len < size && n > 0; len += n) /* ReadFile() takes a DWORD */
+        {
+            DWORD to_read = (size - len > GIGABYTES(1)) ? (DWORD) GIGABYTES(1) : (DWORD) (size - len);
+            if (!ReadFile(file, buf + len, to_read, &n, NULL)) { len = ~0ull; break; }
+        }
+        if (len == ~0ull) { mem_arena_pop_to(arena, (char*) buf); }
+        else              { buf[len] = 0; mem_arena_pop_to(arena, (char*) buf + len + 1); result = str8_make(buf, len); }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return result; }
+    struct stat st;
+    u64 size = (fstat(fd, &st) == 0) ? (u64) st.st_size : 0;
+    u64 cap  = size ? size : FILE_READ_CHUNK;
+    if (cap + 1 <= (u64) (arena->end - arena->pos))
+    {
+        /* the buffer grows in place: nothing else pushes onto the arena until we return */
+        u8* buf = (u8*) mem_arena_push(arena, cap + 1);
+        u64 len = 0;
+        b32 ok  = 1;
+        for (;;)
+        {
+            ssize_t n = read(fd, buf + len, (size_t) (cap - len)); /* regular files: the only read */
+            if (n < 0)  { if (errno == EINTR) { continue; } ok = 0; break; }
+            len += (u64) n;
+            if (n == 0 || (size && len == size)) { break; } /* no extra read to see EOF */
+            if (len == cap)
+            {
+                if (FILE_READ_CHUNK > (u64) (arena->end - arena->pos)) { ok = 0; break; }
+                mem_arena_push(arena, FILE_READ_CHUNK);
+                cap += FILE_READ_CHUNK;
+            }
+        }
+        if (!ok) { mem_arena_pop_to(arena, (char*) buf); }
+        else     { buf[len] = 0; mem_arena_pop_to(arena, (char*) buf + len + 1); result = str8_make(buf, len); } /* file shrank: give back the rest */
+    }
+    close(fd);
+#endif
+    return result;
+}
+
+#if !defined(PLATFORM_WIN32)
+static file_type_e file_type_from_mode(mode_t mode)
+{
+    if (S_ISREG(mode)) { return FILE_TYPE_REGULAR;   }
+    if (S_ISDIR(mode)) { return FILE_TYPE_DIRECTORY; }
+    if (S_ISLNK(mode)) { return FILE_TYPE_SYMLINK;   }
+    return FILE_TYPE_OTHER;
+}
+
+static file_type_e file_type_from_dirent(unsigned char type)
+{
+    switch (type)
+    {
+        case DT_REG:     { return FILE_TYPE_REGULAR;   }
+        case DT_DIR:     { return FILE_TYPE_DIRECTORY; }
+        case DT_LNK:     { return FILE_TYPE_SYMLINK;   }
+        case DT_UNKNOWN: { return FILE_TYPE_UNKNOWN;   } /* filesystem doesn't fill in d_type */
+        default:         { return FILE_TYPE_OTHER;     }
+    }
+}
+#endif
+
+/* entries are 8 byte aligned relative to the start of the buffer */
+static void file_dir_init(file_dir_t* dir, u8* buffer, u64 capacity)
+{
+    u64 pad = NEXT_ALIGN_POW2((uintptr_t) buffer, 8) - (uintptr_t) buffer;
+    memset(dir, 0, sizeof(*dir));
+    dir->buffer   = buffer + pad;
+    dir->capacity = (capacity > pad) ? capacity - pad : 0;
+}
+
+#if defined(PLATFORM_LINUX)
+typedef struct file_dirent64_t /* what getdents64() writes, glibc has no declaration before 2.30 */
+{
+    u64  ino;
+    i64  off;
+    u16  reclen;
+    u8   type;
+    char name[1];
+} file_dirent64_t;
+
+static b32 file_dir_open_fd(file_dir_t* dir, int fd, u8* buffer, u64 capacity)
+{
+    file_dir_init(dir, buffer, capacity);
+    dir->fd = fd;
+    return fd >= 0;
+}
+#endif
+
+b32 file_dir_open(file_dir_t* dir, const char* path, u8* buffer, u64 capacity)
+{
+#if defined(PLATFORM_LINUX)
+    return file_dir_open_fd(dir, open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC), buffer, capacity);
+#elif defined(PLATFORM_WIN32)
+    file_dir_init(dir, buffer, capacity);
+    char pattern[FILE_PATH_MAX];
+    u64  len = strlen(path);
+    if (dir->capacity < sizeof(WIN32_FIND_DATAA) || len + 3 > sizeof(pattern)) { return 0; }
+    memcpy(pattern, path, len);
+    memcpy(pattern + len, "\\*", 3);
+    HANDLE find = FindFirstFileA(pattern, (WIN32_FIND_DATAA*) dir->buffer); /* the find data lives in the buffer */
+    if (find == INVALID_HANDLE_VALUE) { return 0; }
+    dir->handle = find;
+    dir->end    = 1; /* FindFirstFile() already returned the first entry */
+    return 1;
+#else
+    file_dir_init(dir, buffer, capacity);
+    dir->handle = opendir(path); /* readdir() batches entries on its own */
+    return dir->handle != NULL;
+#endif
+}
+
+b32 file_dir_next(file_dir_t* dir, file_dir_entry_t* entry)
+{
+    for (;;)
+    {
+        const char* name;
+    #if defined(PLATFORM_LINUX)
+        if (dir->pos >= dir->end)
+        {
+            long n = syscall(SYS_getdents64, dir->fd, dir->buffer, dir->capacity);
+            if (n <= 0) { return 0; }
+            dir->pos = 0;
+            dir->end = (u64) n;
+        }
+        file_dirent64_t* d = (file_dirent64_t*) (dir->buffer + dir->pos);
+        dir->pos   += d->reclen;
+        name        = d->name;
+        entry->type = file_type_from_dirent(d->type);
+        if (entry->type == FILE_TYPE_UNKNOWN)
+        {
+            struct stat st;
+            if (fstatat(dir->fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) { entry->type = file_type_from_mode(st.st_mode); }
+        }
+    #elif defined(PLATFORM_WIN32)
+        WIN32_FIND_DATAA* data = (WIN32_FIND_DATAA*) dir->buffer;
+        if (!dir->end && !FindNextFileA((HANDLE) dir->handle, data)) { return 0; }
+        dir->end    = 0;
+        name        = data->cFileName;
+        entry->type = (data->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) ? FILE_TYPE_SYMLINK   :
+                      (data->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)     ? FILE_TYPE_DIRECTORY :
+                      (data->dwFileAttributes & FILE_ATTRIBUTE_DEVICE)        ? FILE_TYPE_OTHER     : FILE_TYPE_REGULAR;
+    #else
+        struct dirent* d = readdir((DIR*) dir->handle);
+        if (!d) { return 0; }
+        name        = d->d_name;
+        entry->type = file_type_from_dirent(d->d_type);
+        if (entry->type == FILE_TYPE_UNKNOWN)
+        {
+            struct stat st;
+            if (fstatat(dirfd((DIR*) dir->handle), name, &st, AT_SYMLINK_NOFOLLOW) == 0) { entry->type = file_type_from_mode(st.st_mode); }
+        }
+    #endif
+        if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+        entry->name = str8_cstr(name);
+        return 1;
+    }
+}
+
+void file_dir_close(file_dir_t* dir)
+{
+#if defined(PLATFORM_LINUX)
+    if (dir->fd >= 0) { close(dir->fd); }
+#elif defined(PLATFORM_WIN32)
+    if (dir->handle) { FindClose((HANDLE) dir->handle); }
+#else
+    if (dir->handle) { closedir((DIR*) dir->handle); }
+#endif
+    memset(dir, 0, sizeof(*dir));
+    dir->fd = -1;
+}
+
+typedef struct file_walk_t
+{
+    mem_arena_t*     arena;
+    u8*              buffers[FILE_WALK_MAX_DEPTH]; /* one per depth, pushed when first needed */
+    char*            path;                         /* FILE_PATH_MAX bytes */
+    char*            top;                          /* end of the last buffer */
+    b32              contiguous;                   /* nothing but buffers since path, i.e. safe to pop */
+    file_walk_func_t func;
+    void*            user;
+} file_walk_t;
+
+static b32 file_walk_dir(file_walk_t* walk, file_dir_t* dir, u64 path_len, u32 depth)
+{
+    b32 keep_going = 1;
+    file_dir_entry_t entry;
+    while (keep_going && file_dir_next(dir, &entry))
+    {
+        if (path_len + 1 + entry.name.len >= FILE_PATH_MAX) { continue; } /* can't be opened anyway */
+        u64 len = path_len;
+        walk->path[len++] = '/';
+        memcpy(walk->path + len, entry.name.ptr, entry.name.len + 1);
+        len += entry.name.len;
+
+        file_walk_e action = walk->func(walk->user, str8_make((u8*) walk->path, len), &entry);
+        if (action == FILE_WALK_STOP) { keep_going = 0; }
+        else if (action == FILE_WALK_CONTINUE && entry.type == FILE_TYPE_DIRECTORY && depth + 1 < FILE_WALK_MAX_DEPTH)
+        {
+            mem_arena_t* arena = walk->arena;
+            if (!walk->buffers[depth + 1])
+            {
+                if (FILE_DIR_BUFFER_SIZE > (u64) (arena->end - arena->pos)) { keep_going = 0; break; } /* out of arena */
+                if (arena->pos != walk->top) { walk->contiguous = 0; } /* func pushed something in between */
+                walk->buffers[depth + 1] = (u8*) mem_arena_push(arena, FILE_DIR_BUFFER_SIZE);
+                walk->top                = arena->pos;
+            }
+            file_dir_t child;
+        #if defined(PLATFORM_LINUX)
+            b32 opened = file_dir_open_fd(&child, openat(dir->fd, (const char*) entry.name.ptr, O_RDONLY | O_DIRECTORY | O_CLOEXEC),
+                                          walk->buffers[depth + 1], FILE_DIR_BUFFER_SIZE);
+        #else
+            b32 opened = file_dir_open(&child, walk->path, walk->buffers[depth + 1], FILE_DIR_BUFFER_SIZE);
+        #endif
+            if (opened) { keep_going = file_walk_dir(walk, &child, len, depth + 1); file_dir_close(&child); }
+        }
+        walk->path[path_len] = 0;
+    }
+    return keep_going;
+}
+
+b32 file_dir_walk(mem_arena_t* arena, const char* root, file_walk_func_t func, void* user)
+{
+    u64 root_len = strlen(root);
+    while (root_len > 1 && (root[root_len - 1] == '/' || root[root_len - 1] == '\\')) { root_len--; }
+    if (root_len >= FILE_PATH_MAX || FILE_PATH_MAX + FILE_DIR_BUFFER_SIZE > (u64) (arena->end - arena->pos)) { return 0; }
+
+    file_walk_t walk;
+    memset(&walk, 0, sizeof(walk));
+    char* start     = arena->pos;
+    walk.arena      = arena;
+    walk.func       = func;
+    walk.user       = user;
+    walk.path       = (char*) mem_arena_push(arena, FILE_PATH_MAX);
+    walk.buffers[0] = (u8*) mem_arena_push(arena, FILE_DIR_BUFFER_SIZE);
+    walk.top        = arena->pos;
+    walk.contiguous = 1;
+    memcpy(walk.path, root, root_len);
+    walk.path[root_len] = 0;
+
+    file_dir_t dir;
+    b32 walked = 0;
+    if (file_dir_open(&dir, walk.path, walk.buffers[0], FILE_DIR_BUFFER_SIZE))
+    {
+        if (root_len == 1 && walk.path[0] == '/') { root_len = 0; } /* "/" + "/name" */
+        walked = file_walk_dir(&walk, &dir, root_len, 0);
+        file_dir_close(&dir);
+    }
+
+    /* only if the buffers are all that's on the arena since start, func's data stays */
+    if (walk.contiguous && arena->pos == walk.top) { mem_arena_pop_to(arena, start); }
+    return walked;
+}
+#endif // BASIC_IMPLEMENTATION
@@ -0,0 +1,368 @@
+#pragma once
+
+/* job system: a pool of worker threads that run small jobs (function +
+ * argument). Every worker owns a Chase-Lev deque, jobs are pushed to and
+ * popped from the bottom of the deque of the thread that created them (LIFO,
+ * cache friendly), idle workers steal from the top of other deques (FIFO, the
+ * oldest and usually biggest chunks of work).
+ *
+ * Jobs can be tracked with a job_counter_t: job_run() increments it and it is
+ * decremented once the job finished. job_wait() doesn't block the thread, it
+ * keeps running (or stealing) jobs until the counter reaches zero, so waiting
+ * inside a job is fine. Idle workers & waiting threads park on a futex.
+ *
+ * Every worker (and the thread that called job_system_init) has a scratch
+ * arena, job_scratch_arena() returns the one of the current thread. Anything
+ * pushed onto it inside a job is popped once the job returns.
+ *
+ * job_parallel_for() splits a range in halves until they are at most grain
+ * big, i.e. thieves always steal the largest remaining chunk.
+ *
+ * NOTE: only the thread that called job_system_init() and the workers can
+ * create jobs, other threads run them right away (synchronously)
+ * NOTE: there are no fibers, a waiting job occupies its thread's stack, i.e.
+ * deeply nested waits need correspondingly big stacks
+ */
+
+/* Example usage code:
+
+       job_system_init(0, MEGABYTES(1)); // one worker per cpu (minus the calling thread)
+
+       job_counter_t counter = {0};
+       for (int i = 0; i < entity_count; i++) { job_run(update_entity, &entities[i], &counter); }
+       job_wait(&counter);
+
+       // calls sum_range(data, begin, end) for chunks of at most 4096 elements
+       job_parallel_for(element_count, 4096, sum_range, data);
+
+       job_system_shutdown();
+*/
+
+#ifndef JOB_MAX_WORKERS
+  #define JOB_MAX_WORKERS 64   /* incl. the thread that called job_system_init */
+#endif
+#ifndef JOB_DEQUE_SIZE
+  #define JOB_DEQUE_SIZE  4096 /* max. queued jobs per thread, has to be a power of 2 */
+#endif
+#ifndef JOB_SPIN_COUNT
+  #define JOB_SPIN_COUNT  64   /* failed steal attempts before an idle thread parks */
+#endif
+
+typedef void (*job_func_t)(void* arg);
+typedef void (*job_for_func_t)(void* arg, u64 begin, u64 end);
+
+typedef struct job_counter_t { u32 value; } job_counter_t; /* nr of unfinished jobs, zero-init */
+
+/* api */
+b32          job_system_init    (u32 worker_count, u64 scratch_size); /* 0 workers: one per cpu - 1 */
+void         job_system_shutdown(void);                               /* NOTE: wait for your jobs first */
+u32          job_worker_count   (void);                               /* incl. the init thread */
+
+void         job_run            (job_func_t func, void* arg, job_counter_t* counter); /* counter can be NULL */
+void         job_wait           (job_counter_t* counter);                             /* runs jobs while waiting */
+void         job_parallel_for   (u64 count, u64 grain, job_for_func_t func, void* arg);
+
+u32          job_worker_index   (void); /* 0: init thread, 1..n: workers, U32_MAX: other threads */
+mem_arena_t* job_scratch_arena  (void); /* NULL on other threads */
+
+#ifdef BASIC_IMPLEMENTATION
+#if defined(PLATFORM_WIN32)
+  #include <windows.h>
+#else
+  #include <unistd.h> /* for sysconf */
+#endif
+
+typedef struct job_t
+{
+    job_func_t     func;
+    void*          arg;
+    job_counter_t* counter;
+    u32            queued;  /* slot is in use until the job got dequeued */
+} job_t;
+
+typedef struct job_worker_t
+{
+    u64               top;       /* stolen from here (other threads) */
+    CACHE_LINE_PAD(sizeof(u64));
+    u64               bottom;    /* pushed & popped here (owner) */
+    CACHE_LINE_PAD(sizeof(u64));
+    job_t*            deque[JOB_DEQUE_SIZE];
+    job_t             pool[JOB_DEQUE_SIZE];
+    u64               next_slot; /* next pool slot to hand out */
+    u32               index;
+    u32               rng;       /* for picking victims */
+    mem_arena_t*      scratch;
+    platform_thread_t thread;
+} job_worker_t;
+
+static struct
+{
+    job_worker_t* workers[JOB_MAX_WORKERS];
+    u32           worker_count;
+    u32           shutdown;
+    u32           wake_seq;  /* bumped when there is new work or a counter reached zero */
+    u32           sleepers;  /* parked threads, wakeups skip the syscall without them */
+} job_state;
+
+static thread_local job_worker_t* job_current = NULL;
+
+/* chase-lev deque, see "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al.) */
+static b32 job_deque_push(job_worker_t* w, job_t* job)
+{
+    u64 b = atomic_load_u64(&w->bottom, ATOMIC_RELAXED);
+    u64 t = atomic_load_u64(&w->top,    ATOMIC_ACQUIRE);
+    if (b - t >= JOB_DEQUE_SIZE) { return 0; }
+    atomic_store_ptr((void**) &w->deque[b & (JOB_DEQUE_SIZE - 1)], job, ATOMIC_RELAXED);
+    atomic_store_u64(&w->bottom, b + 1, ATOMIC_RELEASE);
+    return 1;
+}
+
+static job_t* job_deque_pop(job_worker_t* w)
+{
+    u64 b = atomic_load_u64(&w->bottom, ATOMIC_RELAXED) - 1;
+    atomic_store_u64(&w->bottom, b, ATOMIC_SEQ_CST); /* NOTE: seq_cst ops instead of fences (tsan) */
+    u64 t = atomic_load_u64(&w->top, ATOMIC_SEQ_CST);
+    if ((i64) (b - t) < 0) { atomic_store_u64(&w->bottom, b + 1, ATOMIC_RELAXED); return NULL; }
+
+    job_t* job = (job_t*) atomic_load_ptr((void**) &w->deque[b & (JOB_DEQUE_SIZE - 1)], ATOMIC_RELAXED);
+    if (b == t)
+    {
+        /* last job: race the thieves for it */
+        if (!atomic_cas_u64(&w->top, &t, t + 1, ATOMIC_SEQ_CST)) { job = NULL; }
+        atomic_store_u64(&w->bottom, b + 1, ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+static job_t* job_deque_steal(job_worker_t* w)
+{
+    u64 t = atomic_load_u64(&w->top,    ATOMIC_SEQ_CST);
+    u64 b = atomic_load_u64(&w->bottom, ATOMIC_SEQ_CST);
+    if ((i64) (b - t) <= 0) { return NULL; }
+    job_t* job = (job_t*) atomic_load_ptr((void**) &w->deque[t & (JOB_DEQUE_SIZE - 1)], ATOMIC_RELAXED);
+    if (!atomic_cas_u64(&w->top, &t, t + 1, ATOMIC_SEQ_CST)) { return NULL; } /* lost the race */
+    return job;
+}
+
+static b32 job_work_available(void)
+{
+    u32 count = atomic_load_u32(&job_state.worker_count, ATOMIC_ACQUIRE);
+    for (u32 i = 0; i < count; i++)
+    {
+        job_worker_t* w = job_state.workers[i];
+        if ((i64) (atomic_load_u64(&w->bottom, ATOMIC_SEQ_CST) - atomic_load_u64(&w->top, ATOMIC_SEQ_CST)) > 0) { return 1; }
+    }
+    return 0;
+}
+
+static void job_wake(b32 all)
+{
+    atomic_fetch_add_u32(&job_state.wake_seq, 1, ATOMIC_SEQ_CST);
+    if (atomic_load_u32(&job_state.sleepers, ATOMIC_SEQ_CST)) { platform_futex_wake(&job_state.wake_seq, all); }
+}
+
+/* parks until woken, unless there is work or the counter reached zero in the meantime */
+static void job_park(job_counter_t* counter)
+{
+    u32 seq = atomic_load_u32(&job_state.wake_seq, ATOMIC_SEQ_CST);
+    atomic_fetch_add_u32(&job_state.sleepers, 1, ATOMIC_SEQ_CST);
+    b32 done = counter ? (atomic_load_u32(&counter->value, ATOMIC_SEQ_CST) == 0)
+                       : (atomic_load_u32(&job_state.shutdown, ATOMIC_SEQ_CST) != 0);
+    if (!done && !job_work_available()) { platform_futex_wait(&job_state.wake_seq, seq); }
+    atomic_fetch_sub_u32(&job_state.sleepers, 1, ATOMIC_SEQ_CST);
+}
+
+static void job_execute(job_t* job)
+{
+    /* copy out & free the slot before running, the job might create new ones */
+    job_func_t     func    = job->func;
+    void*          arg     = job->arg;
+    job_counter_t* counter = job->counter;
+    atomic_store_u32(&job->queued, 0, ATOMIC_RELEASE);
+
+    job_worker_t* self = job_current;
+    char* scratch_pos  = self ? self->scratch->pos : NULL;
+    func(arg);
+    if (self) { mem_arena_pop_to(self->scratch, scratch_pos); }
+
+    if (counter && atomic_fetch_sub_u32(&counter->value, 1, ATOMIC_ACQ_REL) == 1)
+    {
+        job_wake(1); /* NOTE: the counter can be gone once it hit zero, only wake through the global futex */
+    }
+}
+
+/* runs one job from the own deque or steals one, returns 0 if there was nothing to do */
+static b32 job_run_one(job_worker_t* self)
+{
+    job_t* job = self ? job_deque_pop(self) : NULL;
+    if (!job)
+    {
+        u32 count = atomic_load_u32(&job_state.worker_count, ATOMIC_ACQUIRE);
+        u32 start = 0;
+        if (self)
+        {
+            /* xorshift to spread the thieves over the victims */
+            self->rng ^= self->rng << 13; self->rng ^= self->rng >> 17; self->rng ^= self->rng << 5;
+            start = self->rng;
+        }
+        for (u32 i = 0; i < count && !job; i++)
+        {
+            job_worker_t* victim = job_state.workers[(start + i) % count];
+            if (victim != self) { job = job_deque_steal(victim); }
+        }
+    }
+    if (!job) { return 0; }
+    job_execute(job);
+    return 1;
+}
+
+static void job_worker_main(void* arg)
+{
+    job_worker_t* self = (job_worker_t*) arg;
+    job_current = self;
+    for (;;)
+    {
+        if (job_run_one(self)) { continue; }
+        if (atomic_load_u32(&job_state.shutdown, ATOMIC_ACQUIRE)) { break; }
+        b32 found = 0;
+        for (u32 i = 0; i < JOB_SPIN_COUNT && !found; i++) { platform_cpu_relax(); found = job_run_one(self); }
+        if (!found) { job_park(NULL); }
+    }
+}
+
+static job_worker_t* job_worker_create(u32 index, u64 scratch_size)
+{
+    job_worker_t* w = (job_worker_t*) mem_alloc(sizeof(job_worker_t));
+    MEM_ASSERT(w);
+    memset(w, 0, sizeof(job_worker_t));
+    w->index   = index;
+    w->rng     = 0x9E3779B9u * (index + 1);
+    w->scratch = mem_arena_create(scratch_size);
+    MEM_ASSERT(w->scratch);
+    return w;
+}
+
+b32 job_system_init(u32 worker_count, u64 scratch_size)
+{
+    ASSERT(!job_current && "job system already initialized");
+    if (!worker_count)  { worker_count = platform_cpu_info()->logical_cores - 1; } /* logical_cores is at least 1 */
+    if (worker_count >= JOB_MAX_WORKERS) { worker_count = JOB_MAX_WORKERS - 1; }
+
+    job_state.shutdown = 0;
+    job_state.workers[0] = job_worker_create(0, scratch_size);
+    job_current = job_state.workers[0];
+    for (u32 i = 1; i <= worker_count; i++) { job_state.workers[i] = job_worker_create(i, scratch_size); }
+    /* publish the workers before starting them, thieves iterate the array */
+    atomic_store_u32(&job_state.worker_count, worker_count + 1, ATOMIC_RELEASE);
+
+    for (u32 i = 1; i <= worker_count; i++)
+    {
+        if (!platform_thread_create(&job_state.workers[i]->thread, job_worker_main, job_state.workers[i], NULL))
+        {
+            /* NOTE: all workers are visible to thieves already, hide the unstarted
+             * ones & join the running ones before freeing them */
+            atomic_store_u32(&job_state.worker_count, i, ATOMIC_RELEASE);
+            job_system_shutdown();
+            for (u32 j = i; j <= worker_count; j++)
+            {
+                mem_arena_destroy(&job_state.workers[j]->scratch);
+                mem_free(job_state.workers[j]);
+                job_state.workers[j] = NULL;
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void job_system_shutdown(void)
+{
+    u32 count = atomic_load_u32(&job_state.worker_count, ATOMIC_ACQUIRE);
+    atomic_store_u32(&job_state.shutdown, 1, ATOMIC_SEQ_CST);
+    job_wake(1);
+    for (u32 i = 1; i < count; i++) { platform_thread_join(&job_state.workers[i]->thread); }
+    atomic_store_u32(&job_state.worker_count, 0, ATOMIC_RELEASE);
+    for (u32 i = 0; i < count; i++)
+    {
+        mem_arena_destroy(&job_state.workers[i]->scratch);
+        mem_free(job_state.workers[i]);
+        job_state.workers[i] = NULL;
+    }
+    job_current = NULL;
+}
+
+u32 job_worker_count(void) { return atomic_load_u32(&job_state.worker_count, ATOMIC_ACQUIRE); }
+u32 job_worker_index(void) { return job_current ? job_current->index : U32_MAX; }
+mem_arena_t* job_scratch_arena(void) { return job_current ? job_current->scratch : NULL; }
+
+void job_run(job_func_t func, void* arg, job_counter_t* counter)
+{
+    job_worker_t* self = job_current;
+    if (!self) { func(arg); return; } /* not a job system thread */
+
+    if (counter) { atomic_fetch_add_u32(&counter->value, 1, ATOMIC_RELAXED); }
+
+    /* slots are freed out of order (thieves), help out until the next one is free */
+    job_t* job = &self->pool[self->next_slot & (JOB_DEQUE_SIZE - 1)];
+    while (atomic_load_u32(&job->queued, ATOMIC_ACQUIRE)) { if (!job_run_one(self)) { platform_cpu_relax(); } }
+    self->next_slot++;
+
+    job->func    = func;
+    job->arg     = arg;
+    job->counter = counter;
+    atomic_store_u32(&job->queued, 1, ATOMIC_RELAXED); /* published by the push */
+    if (job_deque_push(self, job)) { job_wake(0); }
+    else                           { job_execute(job); } /* deque is full */
+}
+
+void job_wait(job_counter_t* counter)
+{
+    job_worker_t* self = job_current;
+    u32 spins = 0;
+    while (atomic_load_u32(&counter->value, ATOMIC_ACQUIRE) != 0)
+    {
+        if (job_run_one(self))        { spins = 0; continue; }
+        if (spins++ < JOB_SPIN_COUNT) { platform_cpu_relax(); continue; }
+        job_park(counter);
+    }
+}
+
+typedef struct job_for_t
+{
+    job_for_func_t func;
+    void*          arg;
+    u64            begin;
+    u64            end;
+    u64            grain;
+} job_for_t;
+
+static void job_for_split(void* arg)
+{
+    job_for_t     range   = *(job_for_t*) arg;
+    job_counter_t counter = {0};
+    mem_arena_t*  scratch = job_scratch_arena();
+
+    /* hand the upper half to the job system until the rest is small enough */
+    while (scratch && range.end - range.begin > range.grain)
+    {
+        u64 mid          = range.begin + (range.end - range.begin) / 2;
+        job_for_t* upper = ARENA_PUSH_STRUCT(scratch, job_for_t);
+        *upper           = range;
+        upper->begin     = mid;
+        range.end        = mid;
+        job_run(job_for_split, upper, &counter);
+    }
+    range.func(range.arg, range.begin, range.end);
+    job_wait(&counter);
+}
+
+void job_parallel_for(u64 count, u64 grain, job_for_func_t func, void* arg)
+{
+    if (!count) { return; }
+    job_for_t range = { func, arg, 0, count, grain ? grain : 1 };
+    job_worker_t* self = job_current;
+    char* scratch_pos  = self ? self->scratch->pos : NULL;
+    job_for_split(&range);
+    if (self) { mem_arena_pop_to(self->scratch, scratch_pos); }
+}
+#endif // BASIC_IMPLEMENTATION
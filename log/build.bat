@@ -1,9 +1,11 @@
 echo >/dev/null # >nul & GOTO WINDOWS & rem ^
 
 clang main.c -o main && ./main
+clang log_decode.c -o log_decode
 
 exit 0
 :WINDOWS
 @ECHO off
 
 cl.exe main.c /OUT:main.exe && main.exe
+cl.exe log_decode.c /OUT:log_decode.exe
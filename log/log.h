@@ -1,5 +1,11 @@
 #pragma once
 
+/* strict -std=c99/c11 hides clock_gettime(), clockid_t & localtime_r()
+ * NOTE: only works if log.h comes before the first system header */
+#if !defined(_WIN32) && defined(__STRICT_ANSI__) && !defined(_GNU_SOURCE) && !defined(_DEFAULT_SOURCE)
+  #define _DEFAULT_SOURCE
+#endif
+
 #if defined(LOG_ENTRY_FILE) && !defined(LOG_USE_DEF_FILE)
   #include LOG_ENTRY_FILE
 #endif
@@ -7,11 +13,18 @@
 #if defined(_MSC_VER)
   __pragma(warning(disable : 4996)) /* 'localtime' is deprecated */
 #endif
+#if defined(LOG_USE_ASYNC) || defined(LOG_USE_BINARY) || defined(LOG_USE_SINKS)
+  #define _LOG_HAS_BACKEND /* needs LOG_IMPLEMENTATION in exactly one translation unit */
+#endif
+#if defined(_WIN32) && defined(LOG_IMPLEMENTATION) && defined(_LOG_HAS_BACKEND)
+  #include <windows.h> /* for the writer thread, locks & file mapping, before ERROR gets #undef'd */
+#endif
 #if defined (_WIN32)
   #undef ERROR /* defined in wingdi.h as 0 */
 #endif
 
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #if !defined(LOG_VARIABLE_NAME)
@@ -127,20 +140,338 @@ enum
 #if !defined(LOG_TIME_FORMAT)
   #define LOG_TIME_FORMAT "%H:%M:%S "
 #endif
+#if !defined(LOG_TIME_PRECISION) /* sub-second digits: 0, 3 (ms), 6 (us) or 9 (ns) */
+  #if defined(LOG_USE_MONOTONIC_TIME)
+    #define LOG_TIME_PRECISION 6
+  #else
+    #define LOG_TIME_PRECISION 0
+  #endif
+#endif
+
+#if defined(__cplusplus)
+  #define _LOG_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+  #define _LOG_THREAD_LOCAL __declspec(thread)
+#else
+  #define _LOG_THREAD_LOCAL __thread
+#endif
+
+#if defined(_WIN32)
+  #include <sys/timeb.h> /* NOTE: only millisecond precision on windows */
+#endif
+
+/* timestamps: wall clock (or monotonic clock with LOG_USE_MONOTONIC_TIME) in
+ * nanoseconds. Coarse clocks are used when no sub-second digits are printed */
+static inline unsigned long long _log_time_ns(void)
+{
+#if defined(_WIN32)
+  struct __timeb64 tb; _ftime64(&tb);
+  return (unsigned long long) tb.time * 1000000000ull + (unsigned long long) tb.millitm * 1000000ull;
+#else
+  #if defined(LOG_USE_MONOTONIC_TIME) && defined(CLOCK_MONOTONIC_COARSE) && LOG_TIME_PRECISION == 0
+    clockid_t clock = CLOCK_MONOTONIC_COARSE;
+  #elif defined(LOG_USE_MONOTONIC_TIME)
+    clockid_t clock = CLOCK_MONOTONIC;
+  #elif defined(CLOCK_REALTIME_COARSE) && LOG_TIME_PRECISION == 0
+    clockid_t clock = CLOCK_REALTIME_COARSE;
+  #else
+    clockid_t clock = CLOCK_REALTIME;
+  #endif
+  struct timespec ts; clock_gettime(clock, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+#endif
+}
+
+/* formats a timestamp from _log_time_ns(). The part that only changes every
+ * second (i.e. localtime() + strftime()) is cached per thread, the sub-second
+ * digits get inserted before the trailing spaces of LOG_TIME_FORMAT.
+ * NOTE: returns a thread-local buffer, valid until the next call */
+static inline const char* _log_time_string(unsigned long long ns, int monotonic)
+{
+  static _LOG_THREAD_LOCAL struct
+  {
+    unsigned long long sec;
+    int                monotonic;
+    size_t             frac_at; /* where the sub-second digits go */
+    char               buf[64];
+  } cache = { ~0ull, 0, 0, { 0 } };
+
+  unsigned long long sec = ns / 1000000000ull;
+  if (sec != cache.sec || monotonic != cache.monotonic)
+  {
+    char   head[48];
+    size_t len = 0;
+    if (monotonic) { len = (size_t) snprintf(head, sizeof(head), "%llu ", sec); } /* seconds since boot */
+    else
+    {
+      time_t t = (time_t) sec;
+      #if defined(_WIN32)
+        struct tm tm = *localtime(&t);
+      #else
+        struct tm tm; localtime_r(&t, &tm);
+      #endif
+      len = strftime(head, sizeof(head), LOG_TIME_FORMAT, &tm);
+    }
+    size_t frac_at = len;
+    while (frac_at > 0 && head[frac_at - 1] == ' ') { frac_at--; }
+
+    /* head, then '.' & digits (overwritten below), then the trailing spaces */
+    memcpy(cache.buf, head, frac_at);
+    size_t at = frac_at;
+    if (LOG_TIME_PRECISION > 0) { memset(cache.buf + at, '0', LOG_TIME_PRECISION + 1); cache.buf[at] = '.'; at += LOG_TIME_PRECISION + 1; }
+    memcpy(cache.buf + at, head + frac_at, len - frac_at);
+    cache.buf[at + len - frac_at] = '\0';
+
+    cache.sec       = sec;
+    cache.monotonic = monotonic;
+    cache.frac_at   = frac_at;
+  }
+
+  if (LOG_TIME_PRECISION > 0)
+  {
+    unsigned long long frac = ns % 1000000000ull;
+    for (int i = LOG_TIME_PRECISION; i < 9; i++) { frac /= 10; }
+    for (int i = LOG_TIME_PRECISION; i > 0; i--) { cache.buf[cache.frac_at + (size_t) i] = (char) ('0' + (frac % 10)); frac /= 10; }
+  }
+  return cache.buf;
+}
+
+#if defined(LOG_USE_MONOTONIC_TIME)
+  #define _LOG_TIMESTAMP() _log_time_string(_log_time_ns(), 1)
+#else
+  #define _LOG_TIMESTAMP() _log_time_string(_log_time_ns(), 0)
+#endif
+
+/* NOTE: log.h is standalone, so it brings its own minimal atomics */
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+  #define _LOG_LOAD(ptr)            _InterlockedOr64((volatile long long*) (ptr), 0)
+  #define _LOG_STORE(ptr, val)      _InterlockedExchange64((volatile long long*) (ptr), (val))
+  #define _LOG_CAS(ptr, exp, des)   (_InterlockedCompareExchange64((volatile long long*) (ptr), (des), (exp)) == (exp))
+  #define _LOG_ADD(ptr, val)        _InterlockedExchangeAdd64((volatile long long*) (ptr), (val))
+  #define _LOG_EXCHANGE(ptr, val)   _InterlockedExchange64((volatile long long*) (ptr), (val))
+  #define _LOG_LOAD_SC(ptr)         _LOG_LOAD(ptr) /* interlocked ops are full barriers */
+  #define _LOG_STORE_SC(ptr, val)   _LOG_STORE(ptr, val)
+  #define _LOG_ADD_SC(ptr, val)     _LOG_ADD(ptr, val)
+#else
+  #define _LOG_LOAD(ptr)            __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+  #define _LOG_STORE(ptr, val)      __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+  #define _LOG_CAS(ptr, exp, des)   _log_cas((ptr), (exp), (des))
+  #define _LOG_ADD(ptr, val)        __atomic_fetch_add((ptr), (val), __ATOMIC_RELAXED)
+  #define _LOG_EXCHANGE(ptr, val)   __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+  #define _LOG_LOAD_SC(ptr)         __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+  #define _LOG_STORE_SC(ptr, val)   __atomic_store_n((ptr), (val), __ATOMIC_SEQ_CST)
+  #define _LOG_ADD_SC(ptr, val)     __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+  static inline int _log_cas(long long* ptr, long long expected, long long desired)
+  {
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+#endif
+
+/* compile-time filter: calls with a severity that is not in LOG_COMPILE_MASK
+ * are constant-folded away, including the evaluation of their arguments. Calls
+ * without any severity bit are always compiled in. Names are resolved at the
+ * call site, so e.g. (WARN|ERROR|FATAL) works when using LOG_ENTRIES */
+#if !defined(LOG_COMPILE_MASK)
+  #define LOG_COMPILE_MASK LOG_EVERYTHING
+#endif
+#define LOG_COMPILED_IN(flags) (!((int) (flags) & (int) LOG_SEVERITY) || ((int) (flags) & (int) LOG_SEVERITY & (int) (LOG_COMPILE_MASK)))
 
 /* the core of the log macro */
+#if defined(LOG_USE_BINARY)
+/* binary mode: every call site registers a static descriptor (format, flags,
+ * file, line) once, after that only the descriptor id, a timestamp and the raw
+ * arguments are appended to a memory-mapped file (see log_binary_open() below)
+ * NOTE: flags have to be compile-time constants in this mode */
+#define _LOG(flags, format, ...)                                                                  \
+  if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                   \
+  {                                                                                               \
+    static _log_desc_t _log_desc = { "" format, __FILE__, __LINE__, (flags), 0 };                 \
+    _log_binary_write(&_log_desc, ##__VA_ARGS__);                                                 \
+  }
+#elif defined(LOG_USE_ASYNC)
+/* asynchronous mode: the calling thread only copies the format pointer, flags,
+ * file/line and the raw arguments into a lock-free ring buffer, a background
+ * thread does the formatting & writing (see log_async_start() below) */
+#define _LOG(flags, format, ...)                                                                  \
+  if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                   \
+  {                                                                                               \
+    _log_async_write((flags), __FILE__, __LINE__, "" format, ##__VA_ARGS__);                      \
+  }
+#elif defined(LOG_USE_SINKS)
 #define _LOG(flags, format, ...)                                                                  \
-  if ((flags) & LOG_VARIABLE_NAME)                                                                \
+  if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                   \
   {                                                                                               \
-    /* get a timestamp string */                                                                  \
-    time_t t = time(NULL); struct tm* time = localtime(&t);                                       \
-    char buf[32]; buf[strftime(buf, sizeof(buf), LOG_TIME_FORMAT, time)] = '\0';                  \
-    printf("%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i " format LOG_COLOR_OFF"\n", buf,                \
+    _log_write((flags), __FILE__, __LINE__, "" format, ##__VA_ARGS__);                            \
+  }
+#else
+#define _LOG(flags, format, ...)                                                                  \
+  if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                   \
+  {                                                                                               \
+    printf("%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i " format LOG_COLOR_OFF"\n", _LOG_TIMESTAMP(),   \
            _log_label((flags) & LOG_SEVERITY),                                                    \
            _log_label((flags) & LOG_SUBSYSTEMS),                                                  \
            _log_label((flags) & LOG_CATEGORIES),                                                  \
            __FILE__, __LINE__, ##__VA_ARGS__);                                                    \
   }
+#endif
+
+#if !defined(LOG_BATCH_SIZE)
+  #define LOG_BATCH_SIZE (64 * 1024) /* writer thread & decoder format into this buffer before writing */
+#endif
+
+#if defined(LOG_USE_ASYNC)
+  #if !defined(LOG_ASYNC_ARGS_SIZE)
+    #define LOG_ASYNC_ARGS_SIZE  192 /* bytes for raw arguments per record, rest gets truncated */
+  #endif
+
+  /* what to do when the ring buffer is full */
+  enum
+  {
+    LOG_OVERFLOW_DROP  = 0, /* drop the message */
+    LOG_OVERFLOW_COUNT = 1, /* drop the message, writer reports the nr of dropped messages */
+    LOG_OVERFLOW_BLOCK = 2, /* wait until the writer made room */
+  };
+
+  /* capacity gets rounded up to a power of 2, out == NULL means stdout. Messages
+   * with any of the bits in flush_mask set (e.g. LOG_SEVERITY_FATAL) block until
+   * everything logged so far is written. Logging before start/after stop is
+   * done synchronously. Returns 0 on failure. */
+  int                log_async_start  (FILE* out, unsigned int capacity, int overflow_policy, int flush_mask);
+  void               log_async_stop   (void); /* writes out all pending messages */
+  void               log_async_flush  (void);
+  unsigned long long log_async_dropped(void);
+
+  void _log_async_write(int flags, const char* file, int line, const char* format, ...);
+#endif
+
+#if defined(LOG_USE_SINKS)
+  #if !defined(LOG_MAX_SINKS)
+    #define LOG_MAX_SINKS        8
+  #endif
+  #if !defined(LOG_SINK_BUFFER_SIZE)
+    #define LOG_SINK_BUFFER_SIZE (64 * 1024) /* file & socket sinks write in batches of this size */
+  #endif
+
+  /* a sink receives formatted lines whose flags match its mask: for severity,
+   * subsystem & category, either the message has no bit of that kind or one of
+   * its bits is in the mask, e.g. LOG_SEVERITY_ERROR | LOG_SUBSYSTEMS | LOG_CATEGORIES
+   * accepts errors (and messages without severity) from everywhere. Custom sinks
+   * put this struct first. While no sink is added, LOG(...) prints to stdout.
+   * NOTE: sinks get called by the writer thread in async mode, otherwise under a
+   * lock by the logging thread */
+  typedef struct log_sink_t log_sink_t;
+  struct log_sink_t
+  {
+    int  mask;
+    void (*write)(log_sink_t* sink, int flags, const char* line, size_t len);
+    void (*flush)(log_sink_t* sink);  /* optional, see log_sinks_set_flush_mask() */
+    void (*close)(log_sink_t* sink);  /* flushes & frees the sink */
+  };
+
+  int         log_sink_add        (log_sink_t* sink); /* returns 0 if there are LOG_MAX_SINKS already */
+  void        log_sink_remove     (log_sink_t* sink); /* doesn't close the sink */
+  void        log_sinks_flush     (void);
+  void        log_sinks_close     (void);             /* removes & closes all sinks */
+  /* sinks batch their output & write it when their buffer is full. Messages
+   * with any of the bits in mask (e.g. LOG_SEVERITY_FATAL) flush all sinks right
+   * away, otherwise they're flushed by log_sinks_flush(), when removed/closed &
+   * in async mode whenever the writer thread goes idle. Default: 0 */
+  void        log_sinks_set_flush_mask(int mask);
+
+  /* buffered file, rotated when it would exceed max_size: path -> path.1 -> ...
+   * -> path.<max_files>, the oldest one gets deleted */
+  log_sink_t* log_sink_file       (const char* path, unsigned long long max_size, int max_files, int mask);
+  /* keeps the last size bytes of log output in memory and writes them to dump_to
+   * (stderr if NULL) when a message matching dump_mask (e.g. LOG_SEVERITY_FATAL)
+   * comes in. log_sink_crash_ring_dump() can also be called from a crash handler */
+  log_sink_t* log_sink_crash_ring (size_t size, int dump_mask, FILE* dump_to, int mask);
+  void        log_sink_crash_ring_dump(log_sink_t* sink, FILE* to);
+  /* stream socket at a unix domain socket path (syslog-like collector), lines get
+   * sent in batches, reconnects after errors. NULL on failure or on windows */
+  log_sink_t* log_sink_socket     (const char* path, int mask);
+
+  void _log_write(int flags, const char* file, int line, const char* format, ...);
+#endif
+
+#if defined(LOG_USE_BINARY)
+  #if !defined(LOG_BINARY_ARGS_SIZE)
+    #define LOG_BINARY_ARGS_SIZE 256 /* max. bytes for raw arguments per message, rest gets truncated */
+  #endif
+
+  typedef struct _log_desc_t
+  {
+    const char* format;
+    const char* file;
+    int         line;
+    int         flags;
+    long long   reg;     /* generation << 32 | id once registered in the current file */
+  } _log_desc_t;
+
+  /* maps a file of max_size bytes, messages that don't fit anymore are dropped.
+   * While no file is open, messages go to the async/synchronous path. Data
+   * written to the mapping survives a crash of the process. Returns 0 on failure.
+   * NOTE: no thread may log while the file gets closed */
+  int                log_binary_open   (const char* path, unsigned long long max_size);
+  void               log_binary_close  (void); /* truncates the file to the used size */
+  unsigned long long log_binary_dropped(void);
+
+  /* turns a binary log back into text, returns the nr of messages or -1. Works
+   * for any LOG_ENTRIES table, labels are stored in the file.
+   * NOTE: files have to be decoded on the architecture they were written on */
+  long long          log_binary_decode (const char* path, FILE* out);
+
+  void _log_binary_write(_log_desc_t* desc, ...);
+#endif
+
+/* structured logging: LOG_KV(flags, message, fields...) writes one logfmt or
+ * JSON line per message. Severity, subsystem & category become fields, so do
+ * time (ns, see LOG_USE_MONOTONIC_TIME), file & line. Needs LOG_IMPLEMENTATION
+ * in one translation unit. Keys are stored as pointers in async mode, so they
+ * should be string literals */
+#if !defined(LOG_KV_BUFFER_SIZE)
+  #define LOG_KV_BUFFER_SIZE 2048 /* per thread, fields that don't fit get dropped */
+#endif
+
+enum
+{
+  LOG_KV_LOGFMT = 0, /* time=... level=WARN msg="..." key=value */
+  LOG_KV_JSON   = 1, /* {"time":...,"level":"WARN","msg":"...","key":value} */
+};
+
+enum { _LOG_KV_INT, _LOG_KV_UINT, _LOG_KV_FLOAT, _LOG_KV_BOOL, _LOG_KV_STR };
+
+typedef struct log_kv_t
+{
+  const char* key;
+  int         type;
+  size_t      len; /* of string values */
+  union
+  {
+    long long          i;
+    unsigned long long u;
+    double             f;
+    const char*        s; /* NULL is written as null */
+  } value;
+} log_kv_t;
+
+static inline log_kv_t _log_kv(const char* key, int type) { log_kv_t kv; kv.key = key; kv.type = type; kv.len = 0; kv.value.u = 0; return kv; }
+static inline log_kv_t _log_kv_int  (const char* key, long long v)          { log_kv_t kv = _log_kv(key, _LOG_KV_INT);   kv.value.i = v; return kv; }
+static inline log_kv_t _log_kv_uint (const char* key, unsigned long long v) { log_kv_t kv = _log_kv(key, _LOG_KV_UINT);  kv.value.u = v; return kv; }
+static inline log_kv_t _log_kv_float(const char* key, double v)             { log_kv_t kv = _log_kv(key, _LOG_KV_FLOAT); kv.value.f = v; return kv; }
+static inline log_kv_t _log_kv_bool (const char* key, int v)                { log_kv_t kv = _log_kv(key, _LOG_KV_BOOL);  kv.value.i = v != 0; return kv; }
+static inline log_kv_t _log_kv_str  (const char* key, const char* v, size_t len) { log_kv_t kv = _log_kv(key, _LOG_KV_STR); kv.value.s = v; kv.len = len; return kv; }
+static inline log_kv_t _log_kv_cstr (const char* key, const char* v)             { return _log_kv_str(key, v, v ? strlen(v) : 0); }
+
+#define LOG_KV_INT(key, value)       _log_kv_int  (key, (long long) (value))
+#define LOG_KV_UINT(key, value)      _log_kv_uint (key, (unsigned long long) (value))
+#define LOG_KV_FLOAT(key, value)     _log_kv_float(key, (double) (value))
+#define LOG_KV_BOOL(key, value)      _log_kv_bool (key, (value) ? 1 : 0)
+#define LOG_KV_STR(key, value)       _log_kv_cstr (key, (value))
+#define LOG_KV_STRN(key, value, len) _log_kv_str  (key, (value), (size_t) (len)) /* doesn't need a NUL */
+
+void log_kv_set_format(int format); /* LOG_KV_LOGFMT (default) or LOG_KV_JSON */
+void _log_kv_write(int flags, const char* file, int line, const log_kv_t* kvs, int count);
 
 #if defined(LOG_USE_SHORT_NAMES_GLOBALLY) && defined(LOG_USE_DEF_FILE)
   /* NOTE fill the global namespace with unprefixed names of log entries (e.g. TRACE instead of LOG_SEVERITY_TRACE) */
@@ -159,6 +490,7 @@ enum
     }
 
   #define LOG_SET_MASK(flags) LOG_VARIABLE_NAME = flags;
+  #define _LOG_SHORT_NAMES
 #else
   #define LOG_SET_MASK(flags)               \
     {                                       \
@@ -173,12 +505,74 @@ enum
         enum { LOG_ENTRIES };               \
         _LOG(flags, format, ##__VA_ARGS__)  \
     }
+
+  #define _LOG_SHORT_NAMES enum { LOG_ENTRIES }; /* remove LOG_ prefix */
 #endif
+
+/* rate limiting per call site: when a message is suppressed, only a counter
+ * gets incremented (no formatting, no argument evaluation) */
+
+/* logs the 1st, (n+1)th, (2n+1)th, ... time the call site is reached */
+#define LOG_EVERY_N(flags, n, format, ...)                                                        \
+  {                                                                                               \
+    _LOG_SHORT_NAMES                                                                              \
+    static long long _log_count = 0;                                                              \
+    if (LOG_COMPILED_IN(flags) && (_LOG_ADD(&_log_count, 1) % (n)) == 0)                          \
+    {                                                                                             \
+      _LOG(flags, format, ##__VA_ARGS__)                                                          \
+    }                                                                                             \
+  }
+
+/* logs only the first n times the call site is reached */
+#define LOG_FIRST_N(flags, n, format, ...)                                                        \
+  {                                                                                               \
+    _LOG_SHORT_NAMES                                                                              \
+    static long long _log_count = 0;                                                              \
+    if (LOG_COMPILED_IN(flags) && _LOG_LOAD(&_log_count) < (n) && _LOG_ADD(&_log_count, 1) < (n)) \
+    {                                                                                             \
+      _LOG(flags, format, ##__VA_ARGS__)                                                          \
+    }                                                                                             \
+  }
+
+/* logs at most once every ms milliseconds. The next message that gets through
+ * after a burst is preceded by "last message repeated N times".
+ * NOTE: the count is reported when the call site is reached again, not on a timer */
+#define LOG_THROTTLED(flags, ms, format, ...)                                                     \
+  {                                                                                               \
+    _LOG_SHORT_NAMES                                                                              \
+    static long long _log_next = 0, _log_suppressed = 0;                                          \
+    if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                 \
+    {                                                                                             \
+      long long _log_now = (long long) _log_time_ns();                                            \
+      long long _log_due = _LOG_LOAD(&_log_next);                                                 \
+      if (_log_now < _log_due || !_LOG_CAS(&_log_next, _log_due, _log_now + (long long) (ms) * 1000000)) \
+      {                                                                                           \
+        _LOG_ADD(&_log_suppressed, 1);                                                            \
+      }                                                                                           \
+      else                                                                                        \
+      {                                                                                           \
+        long long _log_repeated = _LOG_EXCHANGE(&_log_suppressed, 0);                             \
+        if (_log_repeated) { _LOG(flags, "last message repeated %lld times", _log_repeated) }     \
+        _LOG(flags, format, ##__VA_ARGS__)                                                        \
+      }                                                                                           \
+    }                                                                                             \
+  }
+/* structured message, e.g. LOG_KV(WARN|NETWORK, "packet dropped", LOG_KV_INT("id", id), LOG_KV_STR("peer", name)) */
+#define LOG_KV(flags, message, ...)                                                               \
+  {                                                                                               \
+    _LOG_SHORT_NAMES                                                                              \
+    if (LOG_COMPILED_IN(flags) && ((flags) & LOG_VARIABLE_NAME))                                  \
+    {                                                                                             \
+      const log_kv_t _log_kvs[] = { LOG_KV_STR("msg", message), ##__VA_ARGS__ };                  \
+      _log_kv_write(flags, __FILE__, __LINE__, _log_kvs, (int) (sizeof(_log_kvs) / sizeof(_log_kvs[0]))); \
+    }                                                                                             \
+  }
+
 /* NOTE redefined to above #define at bottom of file */
 #undef LOG_ENTRY
 
 #define LOG_ENTRY(entry, name, value, string, color) case LOG_##entry##_##name: return color string LOG_COLOR_OFF;
-static const char* _log_label(int flags)
+static inline const char* _log_label(int flags)
 {
   switch (flags)
   {
@@ -194,3 +588,1503 @@ static const char* _log_label(int flags)
 
 /* NOTE this #define is used in the LOG macro, so we cannot keep it #undef'ed */
 #define LOG_ENTRY(entry, name, value, string, color)  name = LOG_##entry##_##name,
+
+#if defined(LOG_IMPLEMENTATION) && defined(_LOG_HAS_BACKEND)
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h> /* for ptrdiff_t */
+#include <stdint.h> /* for intmax_t */
+
+#if defined(LOG_USE_ASYNC) || defined(LOG_USE_BINARY)
+typedef struct _log_batch_t
+{
+  FILE*  out;
+  size_t len;
+  char   data[LOG_BATCH_SIZE];
+} _log_batch_t;
+
+/* format specifiers: the call site walks the format to pack the arguments, the
+ * writer walks it again to print them one by one */
+enum { _LOG_LEN_NONE, _LOG_LEN_HH, _LOG_LEN_H, _LOG_LEN_L, _LOG_LEN_LL, _LOG_LEN_Z, _LOG_LEN_J, _LOG_LEN_T, _LOG_LEN_BIG_L };
+
+typedef struct _log_spec_t
+{
+  char flags[8];
+  int  width;     /* -1 if not given */
+  int  precision; /* -1 if not given */
+  int  width_star, precision_star;
+  int  length;
+  char conversion;
+} _log_spec_t;
+
+/* p points after the '%', returns a pointer after the conversion char */
+static const char* _log_spec_parse(const char* p, _log_spec_t* spec)
+{
+  int n = 0;
+  memset(spec, 0, sizeof(*spec));
+  spec->width = spec->precision = -1;
+  while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+  {
+    if (n < (int) sizeof(spec->flags) - 1) { spec->flags[n++] = *p; }
+    p++;
+  }
+  if (*p == '*') { spec->width_star = 1; p++; }
+  else if (*p >= '0' && *p <= '9') { spec->width = 0; while (*p >= '0' && *p <= '9') { spec->width = spec->width * 10 + (*p++ - '0'); } }
+  if (*p == '.')
+  {
+    p++;
+    if (*p == '*') { spec->precision_star = 1; p++; }
+    else { spec->precision = 0; while (*p >= '0' && *p <= '9') { spec->precision = spec->precision * 10 + (*p++ - '0'); } }
+  }
+  switch (*p)
+  {
+    case 'h': spec->length = (p[1] == 'h') ? _LOG_LEN_HH : _LOG_LEN_H; p += (p[1] == 'h') ? 2 : 1; break;
+    case 'l': spec->length = (p[1] == 'l') ? _LOG_LEN_LL : _LOG_LEN_L; p += (p[1] == 'l') ? 2 : 1; break;
+    case 'z': spec->length = _LOG_LEN_Z;     p++; break;
+    case 'j': spec->length = _LOG_LEN_J;     p++; break;
+    case 't': spec->length = _LOG_LEN_T;     p++; break;
+    case 'L': spec->length = _LOG_LEN_BIG_L; p++; break;
+  }
+  spec->conversion = *p;
+  return (*p) ? p + 1 : p;
+}
+
+/* packs the arguments into args, returns the nr of bytes used */
+static unsigned int _log_args_pack(unsigned char* args, unsigned int cap, const char* format, va_list ap)
+{
+  unsigned int size = 0;
+  #define _LOG_PACK(value) { if (size + sizeof(value) > cap) { return size; } memcpy(args + size, &(value), sizeof(value)); size += sizeof(value); }
+  for (const char* p = format; *p; )
+  {
+    if (*p++ != '%') { continue; }
+    if (*p == '%')   { p++; continue; }
+
+    _log_spec_t spec;
+    p = _log_spec_parse(p, &spec);
+    if (spec.width_star)     { int w = va_arg(ap, int); _LOG_PACK(w); }
+    if (spec.precision_star) { int w = va_arg(ap, int); _LOG_PACK(w); }
+    switch (spec.conversion)
+    {
+      case 'd': case 'i': case 'c':
+      {
+        long long v;
+        switch (spec.length)
+        {
+          case _LOG_LEN_HH: v = (signed char) va_arg(ap, int); break;
+          case _LOG_LEN_H:  v = (short) va_arg(ap, int);       break;
+          case _LOG_LEN_L:  v = va_arg(ap, long);              break;
+          case _LOG_LEN_LL: v = va_arg(ap, long long);         break;
+          case _LOG_LEN_Z:  v = (long long) va_arg(ap, size_t);    break;
+          case _LOG_LEN_J:  v = (long long) va_arg(ap, intmax_t);  break;
+          case _LOG_LEN_T:  v = (long long) va_arg(ap, ptrdiff_t); break;
+          default:          v = va_arg(ap, int);               break;
+        }
+        _LOG_PACK(v);
+      } break;
+      case 'u': case 'o': case 'x': case 'X':
+      {
+        unsigned long long v;
+        switch (spec.length)
+        {
+          case _LOG_LEN_HH: v = (unsigned char) va_arg(ap, unsigned int);  break;
+          case _LOG_LEN_H:  v = (unsigned short) va_arg(ap, unsigned int); break;
+          case _LOG_LEN_L:  v = va_arg(ap, unsigned long);                 break;
+          case _LOG_LEN_LL: v = va_arg(ap, unsigned long long);            break;
+          case _LOG_LEN_Z:  v = va_arg(ap, size_t);                        break;
+          case _LOG_LEN_J:  v = (unsigned long long) va_arg(ap, uintmax_t); break;
+          case _LOG_LEN_T:  v = (unsigned long long) va_arg(ap, ptrdiff_t); break;
+          default:          v = va_arg(ap, unsigned int);                  break;
+        }
+        _LOG_PACK(v);
+      } break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      {
+        double v = (spec.length == _LOG_LEN_BIG_L) ? (double) va_arg(ap, long double) : va_arg(ap, double);
+        _LOG_PACK(v);
+      } break;
+      case 'p':
+      {
+        void* v = va_arg(ap, void*);
+        _LOG_PACK(v);
+      } break;
+      case 's':
+      {
+        /* the string gets copied (NUL-terminated), it might not outlive the call */
+        const char* str = va_arg(ap, const char*);
+        if (!str) { str = "(null)"; }
+        if (size >= cap) { return size; }
+        size_t len = strlen(str);
+        if (spec.precision >= 0 && (size_t) spec.precision < len) { len = (size_t) spec.precision; }
+        if (len > cap - size - 1) { len = cap - size - 1; }
+        memcpy(args + size, str, len);
+        args[size + len] = '\0';
+        size += (unsigned int) len + 1;
+      } break;
+      case 'n': { (void) va_arg(ap, int*); } break; /* not supported */
+      default: break;
+    }
+  }
+  #undef _LOG_PACK
+  return size;
+}
+
+static void _log_batch_flush(_log_batch_t* b)
+{
+  if (b->len) { fwrite(b->data, 1, b->len, b->out); b->len = 0; }
+}
+
+static void _log_batch_printf(_log_batch_t* b, const char* format, ...)
+{
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    va_list ap;
+    va_start(ap, format);
+    size_t avail = sizeof(b->data) - b->len;
+    int    n     = vsnprintf(b->data + b->len, avail, format, ap);
+    va_end(ap);
+    if (n < 0) { return; }
+    if ((size_t) n < avail) { b->len += (size_t) n; return; }
+    if (b->len == 0) { b->len = sizeof(b->data) - 1; return; } /* truncated */
+    _log_batch_flush(b);
+  }
+}
+
+static void _log_batch_write(_log_batch_t* b, const char* str, size_t len)
+{
+  if (b->len + len > sizeof(b->data)) { _log_batch_flush(b); }
+  if (len > sizeof(b->data))          { len = sizeof(b->data); }
+  memcpy(b->data + b->len, str, len);
+  b->len += len;
+}
+
+/* prints the packed arguments according to format */
+static void _log_args_print(_log_batch_t* b, const char* format, const unsigned char* args, unsigned int size)
+{
+  unsigned int at = 0;
+  #define _LOG_UNPACK(value) { if (at + sizeof(value) > size) { _log_batch_write(b, "?", 1); continue; } memcpy(&(value), args + at, sizeof(value)); at += sizeof(value); }
+  for (const char* p = format; *p; )
+  {
+    const char* literal = p;
+    while (*p && *p != '%') { p++; }
+    if (p != literal) { _log_batch_write(b, literal, (size_t) (p - literal)); }
+    if (!*p) { break; }
+    p++;
+    if (*p == '%') { _log_batch_write(b, "%", 1); p++; continue; }
+
+    _log_spec_t spec;
+    p = _log_spec_parse(p, &spec);
+    if (spec.width_star)
+    {
+      _LOG_UNPACK(spec.width);
+      size_t flags_len = strlen(spec.flags);
+      if (spec.width < 0 && flags_len < sizeof(spec.flags) - 1) { spec.width = -spec.width; spec.flags[flags_len] = '-'; }
+    }
+    if (spec.precision_star) { _LOG_UNPACK(spec.precision); }
+
+    /* rebuild the specifier with the actual width/precision & the stored type */
+    char fmt[48];
+    int  n = snprintf(fmt, sizeof(fmt), "%%%s", spec.flags);
+    if (spec.width >= 0)     { n += snprintf(fmt + n, sizeof(fmt) - n, "%d", spec.width); }
+    if (spec.precision >= 0) { n += snprintf(fmt + n, sizeof(fmt) - n, ".%d", spec.precision); }
+    switch (spec.conversion)
+    {
+      case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+      {
+        long long v;
+        _LOG_UNPACK(v);
+        snprintf(fmt + n, sizeof(fmt) - n, "ll%c", spec.conversion);
+        _log_batch_printf(b, fmt, v);
+      } break;
+      case 'c':
+      {
+        long long v;
+        _LOG_UNPACK(v);
+        snprintf(fmt + n, sizeof(fmt) - n, "c");
+        _log_batch_printf(b, fmt, (int) v);
+      } break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      {
+        double v;
+        _LOG_UNPACK(v);
+        snprintf(fmt + n, sizeof(fmt) - n, "%c", spec.conversion);
+        _log_batch_printf(b, fmt, v);
+      } break;
+      case 'p':
+      {
+        void* v;
+        _LOG_UNPACK(v);
+        snprintf(fmt + n, sizeof(fmt) - n, "p");
+        _log_batch_printf(b, fmt, v);
+      } break;
+      case 's':
+      {
+        if (at >= size) { _log_batch_write(b, "?", 1); continue; }
+        const char* str = (const char*) args + at;
+        at += (unsigned int) strlen(str) + 1;
+        snprintf(fmt + n, sizeof(fmt) - n, "s");
+        _log_batch_printf(b, fmt, str);
+      } break;
+      default: break;
+    }
+  }
+  #undef _LOG_UNPACK
+}
+#endif /* LOG_USE_ASYNC || LOG_USE_BINARY */
+#endif /* LOG_IMPLEMENTATION && _LOG_HAS_BACKEND */
+
+#if defined(LOG_IMPLEMENTATION) && defined(LOG_USE_SINKS)
+#if defined(_WIN32)
+  typedef SRWLOCK _log_mutex_t;
+  #define _LOG_MUTEX_INIT   SRWLOCK_INIT
+  #define _LOG_LOCK(lock)   AcquireSRWLockExclusive(lock)
+  #define _LOG_UNLOCK(lock) ReleaseSRWLockExclusive(lock)
+#else
+  #include <pthread.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+  typedef pthread_mutex_t _log_mutex_t;
+  #define _LOG_MUTEX_INIT   PTHREAD_MUTEX_INITIALIZER
+  #define _LOG_LOCK(lock)   pthread_mutex_lock(lock)
+  #define _LOG_UNLOCK(lock) pthread_mutex_unlock(lock)
+#endif
+
+static struct
+{
+  _log_mutex_t lock;
+  long long    count;
+  int          flush_mask;
+  log_sink_t*  sinks[LOG_MAX_SINKS];
+} _log_sinks = { _LOG_MUTEX_INIT, 0, 0, { 0 } };
+
+static int _log_sinks_active(void) { return _LOG_LOAD(&_log_sinks.count) != 0; }
+
+static int _log_mask_match(int flags, int mask)
+{
+  int groups[3] = { LOG_SEVERITY, LOG_SUBSYSTEMS, LOG_CATEGORIES };
+  for (int i = 0; i < 3; i++)
+  {
+    int bits = flags & groups[i];
+    if (bits && !(bits & mask)) { return 0; }
+  }
+  return 1;
+}
+
+/* NOTE: caller holds the lock */
+static void _log_sinks_dispatch(int flags, const char* line, size_t len)
+{
+  for (long long i = 0; i < _log_sinks.count; i++)
+  {
+    log_sink_t* sink = _log_sinks.sinks[i];
+    if (_log_mask_match(flags, sink->mask)) { sink->write(sink, flags, line, len); }
+  }
+}
+
+static void _log_sinks_flush_locked(void)
+{
+  for (long long i = 0; i < _log_sinks.count; i++)
+  {
+    if (_log_sinks.sinks[i]->flush) { _log_sinks.sinks[i]->flush(_log_sinks.sinks[i]); }
+  }
+}
+
+int log_sink_add(log_sink_t* sink)
+{
+  int added = 0;
+  _LOG_LOCK(&_log_sinks.lock);
+  if (sink && _log_sinks.count < LOG_MAX_SINKS)
+  {
+    _log_sinks.sinks[_log_sinks.count] = sink;
+    _LOG_STORE(&_log_sinks.count, _log_sinks.count + 1);
+    added = 1;
+  }
+  _LOG_UNLOCK(&_log_sinks.lock);
+  return added;
+}
+
+void log_sink_remove(log_sink_t* sink)
+{
+  _LOG_LOCK(&_log_sinks.lock);
+  for (long long i = 0; i < _log_sinks.count; i++)
+  {
+    if (_log_sinks.sinks[i] != sink) { continue; }
+    if (sink->flush) { sink->flush(sink); }
+    for (long long j = i + 1; j < _log_sinks.count; j++) { _log_sinks.sinks[j - 1] = _log_sinks.sinks[j]; }
+    _LOG_STORE(&_log_sinks.count, _log_sinks.count - 1);
+    break;
+  }
+  _LOG_UNLOCK(&_log_sinks.lock);
+}
+
+void log_sinks_flush(void)
+{
+  _LOG_LOCK(&_log_sinks.lock);
+  _log_sinks_flush_locked();
+  _LOG_UNLOCK(&_log_sinks.lock);
+}
+
+void log_sinks_set_flush_mask(int mask)
+{
+  _LOG_LOCK(&_log_sinks.lock);
+  _log_sinks.flush_mask = mask;
+  _LOG_UNLOCK(&_log_sinks.lock);
+}
+
+void log_sinks_close(void)
+{
+  _LOG_LOCK(&_log_sinks.lock);
+  for (long long i = 0; i < _log_sinks.count; i++) { _log_sinks.sinks[i]->close(_log_sinks.sinks[i]); }
+  _LOG_STORE(&_log_sinks.count, 0);
+  _LOG_UNLOCK(&_log_sinks.lock);
+}
+
+/* buffered file sink with size-based rotation */
+typedef struct _log_sink_file_t
+{
+  log_sink_t         base;
+  FILE*              file;
+  unsigned long long size;      /* bytes in the current file, incl. the buffer */
+  unsigned long long max_size;
+  int                max_files;
+  size_t             len;
+  char               buffer[LOG_SINK_BUFFER_SIZE];
+  char               path[512];
+} _log_sink_file_t;
+
+static void _log_sink_file_flush(log_sink_t* sink)
+{
+  _log_sink_file_t* s = (_log_sink_file_t*) sink;
+  if (s->len && s->file) { fwrite(s->buffer, 1, s->len, s->file); fflush(s->file); }
+  s->len = 0;
+}
+
+static void _log_sink_file_rotate(_log_sink_file_t* s)
+{
+  _log_sink_file_flush(&s->base);
+  if (s->file) { fclose(s->file); }
+
+  char from[sizeof(s->path) + 16], to[sizeof(s->path) + 16];
+  snprintf(to, sizeof(to), "%s.%d", s->path, s->max_files);
+  remove(to);
+  for (int i = s->max_files - 1; i >= 1; i--)
+  {
+    snprintf(from, sizeof(from), "%s.%d", s->path, i);
+    snprintf(to,   sizeof(to),   "%s.%d", s->path, i + 1);
+    rename(from, to);
+  }
+  snprintf(to, sizeof(to), "%s.1", s->path);
+  if (s->max_files > 0) { rename(s->path, to); }
+
+  s->file = fopen(s->path, "wb");
+  s->size = 0;
+}
+
+static void _log_sink_file_write(log_sink_t* sink, int flags, const char* line, size_t len)
+{
+  _log_sink_file_t* s = (_log_sink_file_t*) sink;
+  (void) flags;
+  if (s->max_size && s->size > 0 && s->size + len > s->max_size) { _log_sink_file_rotate(s); }
+  if (s->len + len > sizeof(s->buffer)) { _log_sink_file_flush(sink); }
+  if (len > sizeof(s->buffer))
+  {
+    if (s->file) { fwrite(line, 1, len, s->file); }
+  }
+  else
+  {
+    memcpy(s->buffer + s->len, line, len);
+    s->len += len;
+  }
+  s->size += len;
+}
+
+static void _log_sink_file_close(log_sink_t* sink)
+{
+  _log_sink_file_t* s = (_log_sink_file_t*) sink;
+  _log_sink_file_flush(sink);
+  if (s->file) { fclose(s->file); }
+  free(s);
+}
+
+log_sink_t* log_sink_file(const char* path, unsigned long long max_size, int max_files, int mask)
+{
+  _log_sink_file_t* s = (_log_sink_file_t*) calloc(1, sizeof(_log_sink_file_t));
+  if (!s || strlen(path) >= sizeof(s->path)) { free(s); return NULL; }
+  s->file = fopen(path, "ab");
+  if (!s->file) { free(s); return NULL; }
+  fseek(s->file, 0, SEEK_END);
+  s->size        = (unsigned long long) ftell(s->file);
+  s->max_size    = max_size;
+  s->max_files   = max_files;
+  s->base.mask   = mask;
+  s->base.write  = _log_sink_file_write;
+  s->base.flush  = _log_sink_file_flush;
+  s->base.close  = _log_sink_file_close;
+  memcpy(s->path, path, strlen(path) + 1);
+  return &s->base;
+}
+
+/* in-memory ring of the most recent output */
+typedef struct _log_sink_ring_t
+{
+  log_sink_t         base;
+  int                dump_mask;
+  FILE*              dump_to;
+  size_t             size;
+  unsigned long long written; /* total bytes, write position is written % size */
+  char               data[1];
+} _log_sink_ring_t;
+
+void log_sink_crash_ring_dump(log_sink_t* sink, FILE* to)
+{
+  _log_sink_ring_t* s = (_log_sink_ring_t*) sink;
+  if (!to) { to = s->dump_to; }
+  size_t at = (size_t) (s->written % s->size);
+  if (s->written > s->size)
+  {
+    /* oldest part, starting at the first complete line */
+    const char* start = s->data + at;
+    const char* nl    = (const char*) memchr(start, '\n', s->size - at);
+    if (nl) { fwrite(nl + 1, 1, (size_t) (s->data + s->size - (nl + 1)), to); fwrite(s->data, 1, at, to); }
+    else
+    {
+      nl = (const char*) memchr(s->data, '\n', at);
+      if (nl) { fwrite(nl + 1, 1, (size_t) (s->data + at - (nl + 1)), to); }
+    }
+  }
+  else
+  {
+    fwrite(s->data, 1, (size_t) s->written, to); /* not wrapped yet, also when exactly full */
+  }
+  fflush(to);
+}
+
+static void _log_sink_ring_write(log_sink_t* sink, int flags, const char* line, size_t len)
+{
+  _log_sink_ring_t* s = (_log_sink_ring_t*) sink;
+  if (len > s->size) { line += len - s->size; s->written += len - s->size; len = s->size; }
+  size_t at    = (size_t) (s->written % s->size);
+  size_t first = (len < s->size - at) ? len : s->size - at;
+  memcpy(s->data + at, line, first);
+  memcpy(s->data, line + first, len - first);
+  s->written += len;
+  if (flags & s->dump_mask) { log_sink_crash_ring_dump(sink, NULL); }
+}
+
+static void _log_sink_ring_close(log_sink_t* sink) { free(sink); }
+
+log_sink_t* log_sink_crash_ring(size_t size, int dump_mask, FILE* dump_to, int mask)
+{
+  if (size == 0) { return NULL; }
+  _log_sink_ring_t* s = (_log_sink_ring_t*) calloc(1, sizeof(_log_sink_ring_t) + size);
+  if (!s) { return NULL; }
+  s->dump_mask  = dump_mask;
+  s->dump_to    = dump_to ? dump_to : stderr;
+  s->size       = size;
+  s->base.mask  = mask;
+  s->base.write = _log_sink_ring_write;
+  s->base.flush = NULL;
+  s->base.close = _log_sink_ring_close;
+  return &s->base;
+}
+
+#if !defined(_WIN32)
+/* unix domain stream socket */
+typedef struct _log_sink_socket_t
+{
+  log_sink_t         base;
+  int                fd;
+  size_t             len;
+  struct sockaddr_un addr;
+  char               buffer[LOG_SINK_BUFFER_SIZE];
+} _log_sink_socket_t;
+
+static int _log_sink_socket_connect(_log_sink_socket_t* s)
+{
+  s->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (s->fd < 0) { return 0; }
+  if (connect(s->fd, (struct sockaddr*) &s->addr, sizeof(s->addr)) != 0) { close(s->fd); s->fd = -1; return 0; }
+  return 1;
+}
+
+static void _log_sink_socket_flush(log_sink_t* sink)
+{
+  _log_sink_socket_t* s = (_log_sink_socket_t*) sink;
+  #if defined(MSG_NOSIGNAL)
+    int send_flags = MSG_NOSIGNAL; /* don't raise SIGPIPE when the collector went away */
+  #else
+    int send_flags = 0;
+  #endif
+  if (s->len && (s->fd >= 0 || _log_sink_socket_connect(s)))
+  {
+    size_t sent = 0;
+    while (sent < s->len)
+    {
+      ssize_t n = send(s->fd, s->buffer + sent, s->len - sent, send_flags);
+      if (n <= 0) { close(s->fd); s->fd = -1; break; } /* drops the batch, reconnects next time */
+      sent += (size_t) n;
+    }
+  }
+  s->len = 0;
+}
+
+static void _log_sink_socket_write(log_sink_t* sink, int flags, const char* line, size_t len)
+{
+  _log_sink_socket_t* s = (_log_sink_socket_t*) sink;
+  (void) flags;
+  if (s->len + len > sizeof(s->buffer)) { _log_sink_socket_flush(sink); }
+  if (len > sizeof(s->buffer))          { len = sizeof(s->buffer); }
+  memcpy(s->buffer + s->len, line, len);
+  s->len += len;
+}
+
+static void _log_sink_socket_close(log_sink_t* sink)
+{
+  _log_sink_socket_t* s = (_log_sink_socket_t*) sink;
+  _log_sink_socket_flush(sink);
+  if (s->fd >= 0) { close(s->fd); }
+  free(s);
+}
+#endif
+
+log_sink_t* log_sink_socket(const char* path, int mask)
+{
+#if defined(_WIN32)
+  (void) path; (void) mask;
+  return NULL;
+#else
+  _log_sink_socket_t* s = (_log_sink_socket_t*) calloc(1, sizeof(_log_sink_socket_t));
+  if (!s || strlen(path) >= sizeof(s->addr.sun_path)) { free(s); return NULL; }
+  s->addr.sun_family = AF_UNIX;
+  memcpy(s->addr.sun_path, path, strlen(path) + 1);
+  if (!_log_sink_socket_connect(s)) { free(s); return NULL; }
+  s->base.mask  = mask;
+  s->base.write = _log_sink_socket_write;
+  s->base.flush = _log_sink_socket_flush;
+  s->base.close = _log_sink_socket_close;
+  return &s->base;
+#endif
+}
+#endif /* LOG_IMPLEMENTATION && LOG_USE_SINKS */
+
+#if defined(LOG_IMPLEMENTATION) && defined(_LOG_HAS_BACKEND)
+static void _log_sync_vwrite(int flags, const char* file, int line, const char* format, va_list ap)
+{
+#if defined(LOG_USE_SINKS)
+  if (_log_sinks_active())
+  {
+    /* format into a line, then hand it to the sinks */
+    char   buf[4096];
+    size_t suffix = sizeof(LOG_COLOR_OFF "\n");
+    size_t cap    = sizeof(buf) - suffix;
+    int    n      = snprintf(buf, cap, "%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i ", _LOG_TIMESTAMP(),
+                             _log_label(flags & LOG_SEVERITY),
+                             _log_label(flags & LOG_SUBSYSTEMS),
+                             _log_label(flags & LOG_CATEGORIES),
+                             file, line);
+    size_t len    = (n < 0) ? 0 : ((size_t) n >= cap ? cap - 1 : (size_t) n);
+    n             = vsnprintf(buf + len, cap - len, format, ap);
+    len          += (n < 0) ? 0 : ((size_t) n >= cap - len ? cap - len - 1 : (size_t) n);
+    memcpy(buf + len, LOG_COLOR_OFF "\n", suffix);
+    len          += suffix - 1;
+
+    _LOG_LOCK(&_log_sinks.lock);
+    _log_sinks_dispatch(flags, buf, len);
+    if (flags & _log_sinks.flush_mask) { _log_sinks_flush_locked(); }
+    _LOG_UNLOCK(&_log_sinks.lock);
+    return;
+  }
+#endif
+  printf("%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i ", _LOG_TIMESTAMP(),
+         _log_label(flags & LOG_SEVERITY),
+         _log_label(flags & LOG_SUBSYSTEMS),
+         _log_label(flags & LOG_CATEGORIES),
+         file, line);
+  vprintf(format, ap);
+  printf(LOG_COLOR_OFF "\n");
+}
+
+#if defined(LOG_USE_SINKS)
+void _log_write(int flags, const char* file, int line, const char* format, ...)
+{
+  va_list ap;
+  va_start(ap, format);
+  _log_sync_vwrite(flags, file, line, format, ap);
+  va_end(ap);
+}
+#endif
+#endif /* LOG_IMPLEMENTATION && _LOG_HAS_BACKEND */
+
+#if defined(LOG_IMPLEMENTATION)
+#include <stdlib.h> /* for strtod */
+
+static long long _log_kv_format = LOG_KV_LOGFMT;
+static _LOG_THREAD_LOCAL char _log_kv_buffer[LOG_KV_BUFFER_SIZE];
+
+#if defined(LOG_USE_ASYNC)
+static int _log_async_kv_write(int flags, const char* file, int line, const log_kv_t* kvs, int count);
+#endif
+
+#undef LOG_ENTRY
+#define LOG_ENTRY(entry, name, value, string, color) case LOG_##entry##_##name: return #name;
+static const char* _log_kv_name(int flags)
+{
+  if (!flags) { return NULL; }
+  switch (flags)
+  {
+    #ifdef LOG_USE_DEF_FILE
+      #include LOG_ENTRY_FILE
+    #else
+      LOG_ENTRIES
+    #endif
+    default: return NULL; /* no field for combined bits */
+  }
+}
+#undef LOG_ENTRY
+#define LOG_ENTRY(entry, name, value, string, color)  name = LOG_##entry##_##name,
+
+typedef struct _log_kv_out_t
+{
+  char*  buf;
+  size_t len;
+  size_t cap;
+  int    full; /* once a field didn't fit, the rest gets dropped */
+} _log_kv_out_t;
+
+static void _log_kv_put(_log_kv_out_t* o, const char* str, size_t len)
+{
+  if (o->full || len > o->cap - o->len) { o->full = 1; return; }
+  memcpy(o->buf + o->len, str, len);
+  o->len += len;
+}
+
+/* escapes '"', '\\' and control chars, everything else (incl. UTF-8) gets copied in runs */
+static void _log_kv_put_escaped(_log_kv_out_t* o, const char* str, size_t len)
+{
+  static const char hex[] = "0123456789abcdef";
+  size_t run = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    unsigned char c = (unsigned char) str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') { continue; }
+
+    _log_kv_put(o, str + run, i - run);
+    run = i + 1;
+    char   esc[6] = { '\\', (char) c, '0', '0', hex[c >> 4], hex[c & 15] };
+    size_t n      = 2;
+    switch (c)
+    {
+      case '"': case '\\':     break;
+      case '\n': esc[1] = 'n'; break;
+      case '\r': esc[1] = 'r'; break;
+      case '\t': esc[1] = 't'; break;
+      default:   esc[1] = 'u'; n = 6; break;
+    }
+    _log_kv_put(o, esc, n);
+  }
+  _log_kv_put(o, str + run, len - run);
+}
+
+static void _log_kv_put_string(_log_kv_out_t* o, int json, const char* str, size_t len)
+{
+  /* logfmt only quotes values that need it */
+  int quote = json || len == 0;
+  for (size_t i = 0; i < len && !quote; i++)
+  {
+    unsigned char c = (unsigned char) str[i];
+    quote = (c <= ' ' || c == '=' || c == '"' || c == '\\');
+  }
+  if (!quote) { _log_kv_put(o, str, len); return; }
+  _log_kv_put(o, "\"", 1);
+  _log_kv_put_escaped(o, str, len);
+  _log_kv_put(o, "\"", 1);
+}
+
+static void _log_kv_put_u64(_log_kv_out_t* o, unsigned long long v, int negative)
+{
+  char  tmp[24];
+  char* p = tmp + sizeof(tmp);
+  do { *--p = (char) ('0' + (v % 10)); v /= 10; } while (v);
+  if (negative) { *--p = '-'; }
+  _log_kv_put(o, p, (size_t) (tmp + sizeof(tmp) - p));
+}
+
+static void _log_kv_put_double(_log_kv_out_t* o, int json, double v)
+{
+  if (v != v)      { _log_kv_put(o, json ? "null" : "NaN", json ? 4 : 3); return; }
+  if (v - v != 0.0) /* inf */
+  {
+    if (json)   { _log_kv_put(o, "null", 4); }
+    else        { _log_kv_put(o, v > 0 ? "+Inf" : "-Inf", 4); }
+    return;
+  }
+  /* 15 digits if they round-trip, 17 otherwise */
+  char tmp[32];
+  int  n = snprintf(tmp, sizeof(tmp), "%.15g", v);
+  if (strtod(tmp, NULL) != v) { n = snprintf(tmp, sizeof(tmp), "%.17g", v); }
+  _log_kv_put(o, tmp, (size_t) n);
+}
+
+static void _log_kv_put_field(_log_kv_out_t* o, int json, const log_kv_t* kv, int first)
+{
+  size_t mark = o->len;
+  if (!first) { _log_kv_put(o, json ? "," : " ", 1); }
+  if (json)
+  {
+    _log_kv_put(o, "\"", 1);
+    _log_kv_put_escaped(o, kv->key, strlen(kv->key));
+    _log_kv_put(o, "\":", 2);
+  }
+  else
+  {
+    _log_kv_put(o, kv->key, strlen(kv->key));
+    _log_kv_put(o, "=", 1);
+  }
+  switch (kv->type)
+  {
+    case _LOG_KV_INT:   { _log_kv_put_u64(o, kv->value.i < 0 ? 0ull - (unsigned long long) kv->value.i : (unsigned long long) kv->value.i, kv->value.i < 0); } break;
+    case _LOG_KV_UINT:  { _log_kv_put_u64(o, kv->value.u, 0); } break;
+    case _LOG_KV_FLOAT: { _log_kv_put_double(o, json, kv->value.f); } break;
+    case _LOG_KV_BOOL:  { _log_kv_put(o, kv->value.i ? "true" : "false", kv->value.i ? 4 : 5); } break;
+    case _LOG_KV_STR:
+    {
+      if (kv->value.s) { _log_kv_put_string(o, json, kv->value.s, kv->len); }
+      else             { _log_kv_put(o, "null", 4); }
+    } break;
+    default: break;
+  }
+  if (o->full) { o->len = mark; }
+}
+
+/* writes one line (incl. '\n') into buf, returns its length. size has to be > 2 */
+static size_t _log_kv_serialize(char* buf, size_t size, int flags, const char* file, int line,
+                                unsigned long long time, const log_kv_t* kvs, int count)
+{
+  int           json = (_LOG_LOAD(&_log_kv_format) == LOG_KV_JSON);
+  _log_kv_out_t o    = { buf, 0, size - 2, 0 }; /* room for "}\n" */
+
+  /* labels & call site become fields */
+  log_kv_t    meta[6];
+  int         n     = 0;
+  const char* names[3] = { _log_kv_name(flags & LOG_SEVERITY), _log_kv_name(flags & LOG_SUBSYSTEMS), _log_kv_name(flags & LOG_CATEGORIES) };
+  meta[n++] = _log_kv_uint("time", time);
+  if (names[0]) { meta[n++] = _log_kv_str("level",     names[0], strlen(names[0])); }
+  if (names[1]) { meta[n++] = _log_kv_str("subsystem", names[1], strlen(names[1])); }
+  if (names[2]) { meta[n++] = _log_kv_str("category",  names[2], strlen(names[2])); }
+  meta[n++] = _log_kv_str("file", file, strlen(file));
+  meta[n++] = _log_kv_int("line", line);
+
+  if (json) { _log_kv_put(&o, "{", 1); }
+  for (int i = 0; i < n; i++)     { _log_kv_put_field(&o, json, &meta[i], i == 0); }
+  for (int i = 0; i < count; i++) { _log_kv_put_field(&o, json, &kvs[i], 0); }
+  if (json) { buf[o.len++] = '}'; }
+  buf[o.len++] = '\n';
+  return o.len;
+}
+
+void log_kv_set_format(int format)
+{
+  _LOG_STORE(&_log_kv_format, (long long) format);
+}
+
+void _log_kv_write(int flags, const char* file, int line, const log_kv_t* kvs, int count)
+{
+#if defined(LOG_USE_ASYNC)
+  if (_log_async_kv_write(flags, file, line, kvs, count)) { return; }
+#endif
+  size_t len = _log_kv_serialize(_log_kv_buffer, sizeof(_log_kv_buffer), flags, file, line, _log_time_ns(), kvs, count);
+#if defined(LOG_USE_SINKS)
+  if (_log_sinks_active())
+  {
+    _LOG_LOCK(&_log_sinks.lock);
+    _log_sinks_dispatch(flags, _log_kv_buffer, len);
+    if (flags & _log_sinks.flush_mask) { _log_sinks_flush_locked(); }
+    _LOG_UNLOCK(&_log_sinks.lock);
+    return;
+  }
+#endif
+  fwrite(_log_kv_buffer, 1, len, stdout);
+}
+#endif /* LOG_IMPLEMENTATION */
+
+#if defined(LOG_IMPLEMENTATION) && defined(LOG_USE_ASYNC)
+#if defined(_WIN32)
+  typedef HANDLE _log_thread_t;
+  #define _LOG_THREAD_FUNC(name)     DWORD WINAPI name(LPVOID arg)
+  #define _LOG_THREAD_START(t, func) ((*(t) = CreateThread(NULL, 0, func, NULL, 0, NULL)) != NULL)
+  #define _LOG_THREAD_JOIN(t)        (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+  #define _LOG_YIELD()               SwitchToThread()
+  #define _LOG_SLEEP_MS(ms)          Sleep(ms)
+#else
+  #include <pthread.h>
+  #include <sched.h>
+  typedef pthread_t _log_thread_t;
+  #define _LOG_THREAD_FUNC(name)     void* name(void* arg)
+  #define _LOG_THREAD_START(t, func) (pthread_create(t, NULL, func, NULL) == 0)
+  #define _LOG_THREAD_JOIN(t)        pthread_join(t, NULL)
+  #define _LOG_YIELD()               sched_yield()
+  #define _LOG_SLEEP_MS(ms)          { struct timespec ts = { 0, (ms) * 1000000L }; nanosleep(&ts, NULL); }
+#endif
+
+/* compact record that gets copied into the ring buffer by the logging thread */
+typedef struct _log_record_t
+{
+  const char*        format; /* string literals, so storing the pointer is enough */
+  const char*        file;
+  int                flags;
+  int                line;
+  unsigned long long time;   /* from _log_time_ns() */
+  unsigned int       args_size;
+  unsigned char      args[LOG_ASYNC_ARGS_SIZE];
+} _log_record_t;
+
+typedef struct _log_slot_t
+{
+  long long     seq;    /* == pos: free, == pos + 1: filled (bounded MPMC queue by D. Vyukov) */
+  _log_record_t record;
+} _log_slot_t;
+
+static struct
+{
+  _log_slot_t*  slots;
+  long long     mask;
+  int           policy;
+  int           flush_mask;
+  long long     running;        /* producers may enqueue */
+  long long     writer_running; /* the writer thread keeps draining */
+
+  char          pad0[64];  /* keep producer & consumer counters on different cache lines */
+  long long     enqueue_pos;
+  long long     dropped;
+  long long     writers;   /* producers between _log_async_enter() & _log_async_leave() */
+  char          pad1[64];
+  long long     reported;    /* nr of dropped messages that were reported */
+  long long     dequeue_pos;
+  long long     written_pos; /* everything before this is written & flushed */
+
+  _log_thread_t thread;
+  _log_batch_t* batch;
+} _log_async;
+
+/* key-value records have no format, their args hold: type (1 byte), key
+ * pointer and either the value (8 bytes) or a u32 length + the string bytes.
+ * Fields that don't fit into LOG_ASYNC_ARGS_SIZE get dropped */
+#define _LOG_KV_NULL_LEN 0xffffffffu
+
+static void _log_record_print_kv(_log_batch_t* b, const _log_record_t* r)
+{
+  log_kv_t     kvs[LOG_ASYNC_ARGS_SIZE / (1 + sizeof(const char*) + sizeof(unsigned int)) + 1];
+  int          count = 0;
+  unsigned int size  = 0;
+  while (size < r->args_size)
+  {
+    log_kv_t* kv = &kvs[count++];
+    *kv = _log_kv(NULL, r->args[size]);
+    memcpy(&kv->key, r->args + size + 1, sizeof(kv->key));
+    size += 1 + sizeof(kv->key);
+    if (kv->type == _LOG_KV_STR)
+    {
+      unsigned int len;
+      memcpy(&len, r->args + size, sizeof(len));
+      size += sizeof(len);
+      if (len == _LOG_KV_NULL_LEN) { continue; }
+      kv->value.s = (const char*) r->args + size;
+      kv->len     = len;
+      size       += len;
+    }
+    else
+    {
+      memcpy(&kv->value, r->args + size, sizeof(kv->value));
+      size += sizeof(kv->value);
+    }
+  }
+  /* the writer thread has its own thread-local buffer */
+  size_t len = _log_kv_serialize(_log_kv_buffer, sizeof(_log_kv_buffer), r->flags, r->file, r->line, r->time, kvs, count);
+  _log_batch_write(b, _log_kv_buffer, len);
+}
+
+static void _log_record_print(_log_batch_t* b, const _log_record_t* r)
+{
+  if (!r->format) { _log_record_print_kv(b, r); return; }
+#if defined(LOG_USE_MONOTONIC_TIME)
+  const char* timestamp = _log_time_string(r->time, 1);
+#else
+  const char* timestamp = _log_time_string(r->time, 0);
+#endif
+  _log_batch_printf(b, "%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i ", timestamp,
+                    _log_label(r->flags & LOG_SEVERITY),
+                    _log_label(r->flags & LOG_SUBSYSTEMS),
+                    _log_label(r->flags & LOG_CATEGORIES),
+                    r->file, r->line);
+  _log_args_print(b, r->format, r->args, r->args_size);
+  _log_batch_write(b, LOG_COLOR_OFF "\n", sizeof(LOG_COLOR_OFF "\n") - 1);
+}
+
+/* drains the ring buffer, returns the nr of records written. Sinks are
+ * flushed if flush is set or a record matches one of the flush masks */
+static long long _log_async_drain(int flush)
+{
+  _log_batch_t* b     = _log_async.batch;
+  long long     count = 0;
+#if !defined(LOG_USE_SINKS)
+  (void) flush;
+#endif
+  for (;;)
+  {
+    long long    pos  = _log_async.dequeue_pos;
+    _log_slot_t* slot = &_log_async.slots[pos & _log_async.mask];
+    if (_LOG_LOAD(&slot->seq) != pos + 1) { break; }
+
+    _log_record_print(b, &slot->record);
+#if defined(LOG_USE_SINKS)
+    if (_log_sinks_active())
+    {
+      _LOG_LOCK(&_log_sinks.lock);
+      _log_sinks_dispatch(slot->record.flags, b->data, b->len);
+      flush |= (slot->record.flags & (_log_sinks.flush_mask | _log_async.flush_mask)) != 0;
+      _LOG_UNLOCK(&_log_sinks.lock);
+      b->len = 0;
+    }
+#endif
+    _LOG_STORE(&slot->seq, pos + _log_async.mask + 1); /* hand the slot back to the producers */
+    _log_async.dequeue_pos = pos + 1;
+    count++;
+  }
+
+  long long dropped = _LOG_LOAD(&_log_async.dropped);
+  if (_log_async.policy == LOG_OVERFLOW_COUNT && dropped != _log_async.reported)
+  {
+    _log_batch_printf(b, "log: dropped %lld messages (ring buffer full)\n", dropped - _log_async.reported);
+    _log_async.reported = dropped;
+  }
+
+#if defined(LOG_USE_SINKS)
+  if (_log_sinks_active())
+  {
+    _LOG_LOCK(&_log_sinks.lock);
+    if (b->len) { _log_sinks_dispatch(0, b->data, b->len); } /* drop report */
+    if (flush)  { _log_sinks_flush_locked(); }
+    _LOG_UNLOCK(&_log_sinks.lock);
+    b->len = 0;
+  }
+#endif
+  if (b->len)
+  {
+    _log_batch_flush(b);
+    fflush(b->out);
+  }
+  _LOG_STORE(&_log_async.written_pos, _log_async.dequeue_pos);
+  return count;
+}
+
+static _LOG_THREAD_FUNC(_log_async_thread)
+{
+  (void) arg;
+  int idle = 0;
+  while (_LOG_LOAD(&_log_async.writer_running))
+  {
+    if (_log_async_drain(0)) { idle = 0; continue; }
+
+    /* back off: spin a little, then yield, then sleep */
+    if      (idle < 64)   { idle++; }
+    else if (idle < 128)  { idle++; _LOG_YIELD(); }
+    else if (idle == 128) { idle = _log_async_drain(1) ? 0 : idle + 1; } /* going to sleep: flush the sinks once */
+    else                  { _LOG_SLEEP_MS(1); }
+  }
+  _log_async_drain(1);
+  return 0;
+}
+
+int log_async_start(FILE* out, unsigned int capacity, int overflow_policy, int flush_mask)
+{
+  if (_LOG_LOAD(&_log_async.running)) { return 0; }
+
+  long long size = 2;
+  while (size < (long long) capacity) { size *= 2; }
+
+  _log_async.slots = (_log_slot_t*)  malloc(sizeof(_log_slot_t) * (size_t) size);
+  _log_async.batch = (_log_batch_t*) malloc(sizeof(_log_batch_t));
+  if (!_log_async.slots || !_log_async.batch)
+  {
+    free(_log_async.slots); free(_log_async.batch);
+    _log_async.slots = NULL; _log_async.batch = NULL;
+    return 0;
+  }
+  for (long long i = 0; i < size; i++) { _log_async.slots[i].seq = i; }
+  _log_async.mask        = size - 1;
+  _log_async.policy      = overflow_policy;
+  _log_async.flush_mask  = flush_mask;
+  _log_async.enqueue_pos = 0;
+  _log_async.dequeue_pos = 0;
+  _log_async.written_pos = 0;
+  _log_async.dropped     = 0;
+  _log_async.reported    = 0;
+  _log_async.batch->out  = out ? out : stdout;
+  _log_async.batch->len  = 0;
+
+  _LOG_STORE(&_log_async.writer_running, 1);
+  if (!_LOG_THREAD_START(&_log_async.thread, _log_async_thread))
+  {
+    _LOG_STORE(&_log_async.writer_running, 0);
+    free(_log_async.slots); free(_log_async.batch);
+    _log_async.slots = NULL; _log_async.batch = NULL;
+    return 0;
+  }
+  _LOG_STORE_SC(&_log_async.running, 1);
+  return 1;
+}
+
+/* producers register before they check running, so log_async_stop() knows
+ * when the last one that saw running == 1 is done with the ring buffer */
+static int _log_async_enter(void)
+{
+  _LOG_ADD_SC(&_log_async.writers, 1);
+  if (_LOG_LOAD_SC(&_log_async.running)) { return 1; }
+  _LOG_ADD_SC(&_log_async.writers, -1);
+  return 0;
+}
+
+static void _log_async_leave(void) { _LOG_ADD_SC(&_log_async.writers, -1); }
+
+void log_async_stop(void)
+{
+  if (!_LOG_LOAD(&_log_async.running)) { return; }
+  _LOG_STORE_SC(&_log_async.running, 0); /* new messages are written synchronously */
+  while (_LOG_LOAD_SC(&_log_async.writers) > 0) { _LOG_YIELD(); } /* the writer thread still drains meanwhile */
+  _LOG_STORE(&_log_async.writer_running, 0);
+  _LOG_THREAD_JOIN(_log_async.thread); /* drains what's left */
+  free(_log_async.slots); free(_log_async.batch);
+  _log_async.slots = NULL; _log_async.batch = NULL;
+}
+
+void log_async_flush(void)
+{
+  if (!_LOG_LOAD(&_log_async.running)) { fflush(stdout); return; }
+  long long target = _LOG_LOAD(&_log_async.enqueue_pos);
+  while (_LOG_LOAD(&_log_async.written_pos) < target) { _LOG_YIELD(); }
+}
+
+unsigned long long log_async_dropped(void)
+{
+  return (unsigned long long) _LOG_LOAD(&_log_async.dropped);
+}
+
+/* claims a slot for the record at *pos, NULL if the message got dropped */
+static _log_slot_t* _log_async_claim(long long* pos_out)
+{
+  _log_slot_t* slot;
+  long long    pos = _LOG_LOAD(&_log_async.enqueue_pos);
+  for (;;)
+  {
+    slot = &_log_async.slots[pos & _log_async.mask];
+    long long diff = _LOG_LOAD(&slot->seq) - pos;
+    if (diff == 0)
+    {
+      if (_LOG_CAS(&_log_async.enqueue_pos, pos, pos + 1)) { break; }
+      pos = _LOG_LOAD(&_log_async.enqueue_pos);
+    }
+    else if (diff < 0) /* full */
+    {
+      if (_log_async.policy != LOG_OVERFLOW_BLOCK) { _LOG_ADD(&_log_async.dropped, 1); return NULL; }
+      _LOG_YIELD();
+      pos = _LOG_LOAD(&_log_async.enqueue_pos);
+    }
+    else
+    {
+      pos = _LOG_LOAD(&_log_async.enqueue_pos);
+    }
+  }
+  *pos_out = pos;
+  return slot;
+}
+
+static void _log_async_vwrite(int flags, const char* file, int line, const char* format, va_list ap)
+{
+  /* not started (yet) or stopping: format & write synchronously */
+  if (!_log_async_enter()) { _log_sync_vwrite(flags, file, line, format, ap); return; }
+
+  long long    pos;
+  _log_slot_t* slot = _log_async_claim(&pos);
+  if (!slot) { _log_async_leave(); return; }
+
+  /* fill & publish it */
+  _log_record_t* r = &slot->record;
+  r->format    = format;
+  r->file      = file;
+  r->flags     = flags;
+  r->line      = line;
+  r->time      = _log_time_ns();
+  r->args_size = _log_args_pack(r->args, sizeof(r->args), format, ap);
+  _LOG_STORE(&slot->seq, pos + 1);
+
+  if (flags & _log_async.flush_mask) { log_async_flush(); }
+  _log_async_leave();
+}
+
+static int _log_async_kv_write(int flags, const char* file, int line, const log_kv_t* kvs, int count)
+{
+  if (!_log_async_enter()) { return 0; }
+
+  long long    pos;
+  _log_slot_t* slot = _log_async_claim(&pos);
+  if (!slot) { _log_async_leave(); return 1; }
+
+  _log_record_t* r    = &slot->record;
+  unsigned int   size = 0;
+  for (int i = 0; i < count; i++)
+  {
+    const log_kv_t* kv   = &kvs[i];
+    unsigned int    head = 1 + sizeof(kv->key);
+    unsigned int    body = (kv->type == _LOG_KV_STR) ? sizeof(unsigned int) : sizeof(kv->value);
+    if (size + head + body > sizeof(r->args)) { break; }
+
+    r->args[size] = (unsigned char) kv->type;
+    memcpy(r->args + size + 1, &kv->key, sizeof(kv->key));
+    size += head;
+    if (kv->type == _LOG_KV_STR)
+    {
+      /* strings get copied & truncated to what's left */
+      unsigned int len = kv->value.s ? (unsigned int) kv->len : _LOG_KV_NULL_LEN;
+      if (kv->value.s && len > sizeof(r->args) - size - body) { len = (unsigned int) (sizeof(r->args) - size - body); }
+      memcpy(r->args + size, &len, sizeof(len));
+      size += body;
+      if (kv->value.s) { memcpy(r->args + size, kv->value.s, len); size += len; }
+    }
+    else
+    {
+      memcpy(r->args + size, &kv->value, sizeof(kv->value));
+      size += body;
+    }
+  }
+
+  r->format    = NULL;
+  r->file      = file;
+  r->flags     = flags;
+  r->line      = line;
+  r->time      = _log_time_ns();
+  r->args_size = size;
+  _LOG_STORE(&slot->seq, pos + 1);
+
+  if (flags & _log_async.flush_mask) { log_async_flush(); }
+  _log_async_leave();
+  return 1;
+}
+
+void _log_async_write(int flags, const char* file, int line, const char* format, ...)
+{
+  va_list ap;
+  va_start(ap, format);
+  _log_async_vwrite(flags, file, line, format, ap);
+  va_end(ap);
+}
+#endif /* LOG_IMPLEMENTATION && LOG_USE_ASYNC */
+
+#if defined(LOG_IMPLEMENTATION) && defined(LOG_USE_BINARY)
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+#if !defined(_LOG_YIELD) /* without LOG_USE_ASYNC */
+  #if defined(_WIN32)
+    #define _LOG_YIELD() SwitchToThread()
+  #else
+    #include <sched.h>
+    #define _LOG_YIELD() sched_yield()
+  #endif
+#endif
+
+/* file layout: header, then records that start at 8 byte aligned offsets
+ *   descriptor: u32 size, u32 id | DESC_BIT, i32 flags, i32 line,
+ *               file\0 format\0 severity label\0 subsystem label\0 category label\0
+ *   message:    u32 size, u32 id, u64 time (ns, see _log_time_ns()), raw arguments
+ * a size of 0 marks the end of the log (unused or not completely written) */
+#define _LOG_BINARY_MAGIC    "LOGBIN01"
+#define _LOG_BINARY_DESC_BIT 0x80000000u
+
+typedef struct _log_binary_header_t
+{
+  char         magic[8];
+  unsigned int header_size;
+  unsigned int pointer_size;
+  unsigned int endian_check; /* 0x01020304 */
+  unsigned int monotonic;    /* timestamps are from the monotonic clock */
+  unsigned int reserved[2];
+} _log_binary_header_t;
+
+static struct
+{
+  unsigned char* base;
+  long long      size;
+  long long      generation; /* bumped on every open, descriptors re-register */
+  long long      open;
+  long long      next_id;
+
+  char           pad0[64];
+  long long      offset;     /* write position */
+  long long      dropped;
+  long long      writers;    /* between _log_binary_enter() & _log_binary_leave() */
+
+#if defined(_WIN32)
+  HANDLE         file;
+  HANDLE         mapping;
+#else
+  int            fd;
+#endif
+} _log_binary;
+
+static unsigned char* _log_binary_reserve(unsigned int size)
+{
+  long long aligned = (size + 7) & ~7;
+  long long at      = _LOG_ADD(&_log_binary.offset, aligned);
+  if (at + aligned > _log_binary.size) { _LOG_ADD(&_log_binary.dropped, 1); return NULL; }
+  return _log_binary.base + at;
+}
+
+/* returns the id of the descriptor, writes it to the file the first time */
+static unsigned int _log_binary_register(_log_desc_t* desc)
+{
+  long long generation = _log_binary.generation;
+  for (;;)
+  {
+    long long reg = _LOG_LOAD(&desc->reg);
+    if ((reg >> 32) == generation)                   { return (unsigned int) reg; }
+    if (reg != -1 && _LOG_CAS(&desc->reg, reg, -1)) { break; } /* we register it, others wait */
+  }
+
+  unsigned int id = (unsigned int) _LOG_ADD(&_log_binary.next_id, 1);
+  const char* strings[5] = { desc->file, desc->format,
+                             _log_label(desc->flags & LOG_SEVERITY),
+                             _log_label(desc->flags & LOG_SUBSYSTEMS),
+                             _log_label(desc->flags & LOG_CATEGORIES) };
+  size_t lens[5];
+  unsigned int size = 16;
+  for (int i = 0; i < 5; i++) { lens[i] = strlen(strings[i]) + 1; size += (unsigned int) lens[i]; }
+
+  unsigned char* rec = _log_binary_reserve(size);
+  if (rec)
+  {
+    unsigned int tagged = id | _LOG_BINARY_DESC_BIT;
+    unsigned int at     = 16;
+    memcpy(rec + 4,  &tagged,      4);
+    memcpy(rec + 8,  &desc->flags, 4);
+    memcpy(rec + 12, &desc->line,  4);
+    for (int i = 0; i < 5; i++) { memcpy(rec + at, strings[i], lens[i]); at += (unsigned int) lens[i]; }
+    memcpy(rec, &size, 4); /* size last, marks the record as complete */
+  }
+
+  _LOG_STORE(&desc->reg, (generation << 32) | id);
+  return id;
+}
+
+/* writers register before they check open, so log_binary_close() can wait
+ * for the ones that already passed the check before unmapping */
+static int _log_binary_enter(void)
+{
+  _LOG_ADD_SC(&_log_binary.writers, 1);
+  if (_LOG_LOAD_SC(&_log_binary.open)) { return 1; }
+  _LOG_ADD_SC(&_log_binary.writers, -1);
+  return 0;
+}
+
+static void _log_binary_leave(void) { _LOG_ADD_SC(&_log_binary.writers, -1); }
+
+int log_binary_open(const char* path, unsigned long long max_size)
+{
+  if (_log_binary.open || max_size < sizeof(_log_binary_header_t)) { return 0; }
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) { return 0; }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD) (max_size >> 32), (DWORD) max_size, NULL);
+  void*  base    = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T) max_size) : NULL;
+  if (!base)
+  {
+    if (mapping) { CloseHandle(mapping); }
+    CloseHandle(file);
+    return 0;
+  }
+  _log_binary.file    = file;
+  _log_binary.mapping = mapping;
+#else
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) { return 0; }
+  void* base = (ftruncate(fd, (off_t) max_size) == 0)
+             ? mmap(NULL, (size_t) max_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+             : MAP_FAILED;
+  if (base == MAP_FAILED) { close(fd); return 0; }
+  _log_binary.fd = fd;
+#endif
+
+  _log_binary_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, _LOG_BINARY_MAGIC, sizeof(header.magic));
+  header.header_size  = sizeof(header);
+  header.pointer_size = sizeof(void*);
+  header.endian_check = 0x01020304;
+#if defined(LOG_USE_MONOTONIC_TIME)
+  header.monotonic    = 1;
+#endif
+  memcpy(base, &header, sizeof(header));
+
+  _log_binary.base        = (unsigned char*) base;
+  _log_binary.size        = (long long) max_size;
+  _log_binary.offset      = sizeof(header);
+  _log_binary.dropped     = 0;
+  _log_binary.next_id     = 0;
+  _log_binary.generation += 1;
+  _LOG_STORE(&_log_binary.open, 1);
+  return 1;
+}
+
+void log_binary_close(void)
+{
+  if (!_log_binary.open) { return; }
+  _LOG_STORE_SC(&_log_binary.open, 0); /* new messages take the async/sync path */
+  while (_LOG_LOAD_SC(&_log_binary.writers) > 0) { _LOG_YIELD(); }
+
+  long long used = (_log_binary.offset < _log_binary.size) ? _log_binary.offset : _log_binary.size;
+#if defined(_WIN32)
+  UnmapViewOfFile(_log_binary.base);
+  CloseHandle(_log_binary.mapping);
+  LARGE_INTEGER end; end.QuadPart = used;
+  SetFilePointerEx(_log_binary.file, end, NULL, FILE_BEGIN);
+  SetEndOfFile(_log_binary.file);
+  CloseHandle(_log_binary.file);
+#else
+  munmap(_log_binary.base, (size_t) _log_binary.size);
+  if (ftruncate(_log_binary.fd, (off_t) used) != 0) { /* file just keeps its zeroed tail */ }
+  close(_log_binary.fd);
+#endif
+  _log_binary.base = NULL;
+}
+
+unsigned long long log_binary_dropped(void)
+{
+  return (unsigned long long) _LOG_LOAD(&_log_binary.dropped);
+}
+
+void _log_binary_write(_log_desc_t* desc, ...)
+{
+  va_list ap;
+  va_start(ap, desc);
+  if (!_log_binary_enter())
+  {
+#if defined(LOG_USE_ASYNC)
+    _log_async_vwrite(desc->flags, desc->file, desc->line, desc->format, ap);
+#else
+    _log_sync_vwrite(desc->flags, desc->file, desc->line, desc->format, ap);
+#endif
+    va_end(ap);
+    return;
+  }
+
+  unsigned int  id = _log_binary_register(desc);
+  unsigned char args[LOG_BINARY_ARGS_SIZE];
+  unsigned int  args_size = _log_args_pack(args, sizeof(args), desc->format, ap);
+  va_end(ap);
+
+  unsigned long long time_ns = _log_time_ns();
+  unsigned int       size    = 16 + args_size;
+  unsigned char*     rec     = _log_binary_reserve(size);
+  if (rec)
+  {
+    memcpy(rec + 4,  &id,      4);
+    memcpy(rec + 8,  &time_ns, 8);
+    memcpy(rec + 16, args,     args_size);
+    memcpy(rec, &size, 4); /* size last, marks the record as complete */
+  }
+  _log_binary_leave();
+}
+
+typedef struct _log_decode_desc_t
+{
+  const char* strings[5]; /* file, format, severity, subsystem, category */
+  int         line;
+} _log_decode_desc_t;
+
+long long log_binary_decode(const char* path, FILE* out)
+{
+  FILE* in = fopen(path, "rb");
+  if (!in) { return -1; }
+  fseek(in, 0, SEEK_END);
+  long file_size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  unsigned char* data = (file_size > 0) ? (unsigned char*) malloc((size_t) file_size) : NULL;
+  size_t size = data ? fread(data, 1, (size_t) file_size, in) : 0;
+  fclose(in);
+
+  _log_binary_header_t header;
+  if (size < sizeof(header)) { free(data); return -1; }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, _LOG_BINARY_MAGIC, sizeof(header.magic)) != 0 ||
+      header.pointer_size != sizeof(void*) || header.endian_check != 0x01020304)
+  {
+    free(data);
+    return -1;
+  }
+
+  _log_batch_t*       batch    = (_log_batch_t*) malloc(sizeof(_log_batch_t));
+  _log_decode_desc_t* descs    = NULL;
+  unsigned int        capacity = 0;
+  long long           count    = 0;
+  if (!batch) { free(data); return -1; }
+  batch->out = out ? out : stdout;
+  batch->len = 0;
+
+  size_t at = header.header_size;
+  while (at + 8 <= size)
+  {
+    unsigned int rec_size, id;
+    memcpy(&rec_size, data + at,     4);
+    memcpy(&id,       data + at + 4, 4);
+    if (rec_size < 16 || at + rec_size > size) { break; }
+    const unsigned char* rec = data + at;
+
+    if (id & _LOG_BINARY_DESC_BIT)
+    {
+      id &= ~_LOG_BINARY_DESC_BIT;
+      if (id >= capacity)
+      {
+        unsigned int new_capacity = (id + 1) * 2;
+        _log_decode_desc_t* grown = (_log_decode_desc_t*) realloc(descs, sizeof(*descs) * new_capacity);
+        if (!grown) { break; }
+        memset(grown + capacity, 0, sizeof(*descs) * (new_capacity - capacity));
+        descs    = grown;
+        capacity = new_capacity;
+      }
+      _log_decode_desc_t desc;
+      size_t str_at = 16;
+      int    valid  = 1;
+      memcpy(&desc.line, rec + 12, 4);
+      for (int i = 0; i < 5 && valid; i++)
+      {
+        const unsigned char* end = (const unsigned char*) memchr(rec + str_at, '\0', rec_size - str_at);
+        if (!end) { valid = 0; break; }
+        desc.strings[i] = (const char*) rec + str_at;
+        str_at = (size_t) (end - rec) + 1;
+      }
+      if (valid) { descs[id] = desc; }
+    }
+    else if (id < capacity && descs[id].strings[1])
+    {
+      const _log_decode_desc_t* desc = &descs[id];
+      unsigned long long time_ns;
+      memcpy(&time_ns, rec + 8, 8);
+      _log_batch_printf(batch, "%s" LOG_COLOR_OFF "%s%s%s %12.12s:%4i ", _log_time_string(time_ns, (int) header.monotonic),
+                        desc->strings[2], desc->strings[3], desc->strings[4], desc->strings[0], desc->line);
+      _log_args_print(batch, desc->strings[1], rec + 16, rec_size - 16);
+      _log_batch_write(batch, LOG_COLOR_OFF "\n", sizeof(LOG_COLOR_OFF "\n") - 1);
+      count++;
+    }
+    at += (rec_size + 7) & ~7u;
+  }
+
+  _log_batch_flush(batch);
+  fflush(batch->out);
+  free(batch);
+  free(descs);
+  free(data);
+  return count;
+}
+#endif /* LOG_IMPLEMENTATION && LOG_USE_BINARY */
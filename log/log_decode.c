@@ -0,0 +1,35 @@
+/* turns binary logs (written with LOG_USE_BINARY) back into text:
+ *
+ *     log_decode app.binlog [more.binlog ...] > app.log
+ *
+ * The log entries (labels, colors) are stored in the binary file, so this tool
+ * doesn't need the LOG_ENTRIES table of the program that wrote the log. Define
+ * LOG_TIME_FORMAT or LOG_USE_NO_COLOR when compiling it to change the output.
+ */
+
+#define LOG_ENTRIES \
+LOG_ENTRY(CATEGORY,   EMPTY0,             0,    "[     ]",     LOG_COLOR_GRAY    )
+
+#define LOG_USE_BINARY
+#define LOG_IMPLEMENTATION
+#include "log.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <binary log file>...\n", argv[0]);
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (log_binary_decode(argv[i], stdout) < 0)
+        {
+            fprintf(stderr, "%s: not a binary log file (or written on a different architecture)\n", argv[i]);
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -49,6 +49,14 @@
 struct mem_arena_t;
 typedef struct mem_arena_t mem_arena_t;
 
+typedef struct mem_arena_stats_t
+{
+    size_t used;      /* bytes pushed right now */
+    size_t peak;      /* high water mark of used */
+    size_t committed;
+    size_t capacity;
+} mem_arena_stats_t;
+
 /* api */
 mem_arena_t* mem_arena_create  (size_t        size_in_bytes);
 void*        mem_arena_push    (mem_arena_t*  arena, size_t size); /* push onto arena, committing if needed  */
@@ -62,8 +70,20 @@ void         mem_arena_pop_by  (mem_arena_t*  arena, size_t bytes);
 void         mem_arena_clear   (mem_arena_t*  arena);
 void         mem_arena_destroy (mem_arena_t** arena);
 
-/* helper */
+mem_arena_stats_t mem_arena_stats(mem_arena_t* arena); /* NOTE: not synchronized */
+
+/* registry: every arena from mem_arena_create() is linked into a global list
+ * (subarenas live inside their base & aren't), so the totals are one lock &
+ * a walk over the live arenas. NOTE: reads other threads' arenas unsynchronized */
+mem_arena_stats_t mem_arena_stats_total(size_t* arena_count /* optional */);
+
+/* default arenas, created lazily. The process default is shared & lives until
+ * exit (pushing onto it is not synchronized), a thread default is destroyed
+ * when its thread exits */
 mem_arena_t* mem_arena_default ();
+mem_arena_t* mem_arena_thread  ();
+
+/* helper */
 #define ARENA_PUSH_ARRAY(arena, type, count) (type*) mem_arena_push((arena), sizeof(type)*(count))
 #define ARENA_PUSH_STRUCT(arena, type)       ARENA_PUSH_ARRAY((arena), type, 1)
 
@@ -72,6 +92,16 @@ mem_arena_t* mem_arena_default ();
 /* TODO scratch arenas */
 
 #ifdef MEM_ARENA_IMPLEMENTATION
+#if defined(_WIN32)
+  #include <windows.h> /* for SRWLOCK, INIT_ONCE, FlsAlloc */
+  #define MEM_ARENA_LOCK()   AcquireSRWLockExclusive(&mem_arena_registry.lock)
+  #define MEM_ARENA_UNLOCK() ReleaseSRWLockExclusive(&mem_arena_registry.lock)
+#else
+  #include <pthread.h> /* for pthread_mutex_t, pthread_once, pthread_key_create */
+  #define MEM_ARENA_LOCK()   pthread_mutex_lock(&mem_arena_registry.lock)
+  #define MEM_ARENA_UNLOCK() pthread_mutex_unlock(&mem_arena_registry.lock)
+#endif
+
 typedef struct arena_region_header_t { size_t size; /* size of allocated region*/ } arena_region_header_t; /* unused */
 
 struct mem_arena_t
@@ -79,6 +109,10 @@ struct mem_arena_t
     char* pos;
     char* end;
     char* commit_pos;
+    char* peak;       /* highest pos so far */
+
+    mem_arena_t* next; /* registry list, NULL for subarenas */
+    mem_arena_t* prev;
 
     /* size_t pos; */
     /* size_t cap; */
@@ -90,6 +124,28 @@ struct mem_arena_t
     #endif
 };
 
+static struct
+{
+    mem_arena_t* head;
+    mem_arena_t* process_default;
+  #if defined(_WIN32)
+    SRWLOCK   lock;
+    INIT_ONCE once;
+    DWORD     thread_key; /* fiber local storage, has a destructor unlike tls */
+  #else
+    pthread_mutex_t lock;
+    pthread_once_t  once;
+    pthread_key_t   thread_key;
+  #endif
+} mem_arena_registry = {
+    NULL, NULL,
+  #if defined(_WIN32)
+    SRWLOCK_INIT, INIT_ONCE_STATIC_INIT, 0
+  #else
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT, 0
+  #endif
+};
+
 mem_arena_t* mem_arena_create(size_t size_in_bytes) {
 
     #ifdef MEM_ARENA_USE_RESERVE_AND_COMMIT_STRATEGY
@@ -109,12 +165,20 @@ mem_arena_t* mem_arena_create(size_t size_in_bytes) {
     arena->pos        = (char*) arena + sizeof(mem_arena_t);
     arena->end        = arena->pos + size_in_bytes;
     arena->commit_pos = arena->pos;
+    arena->peak       = arena->pos;
 
     #ifdef BUILD_DEBUG
     arena->depth         = 0;
     arena->commit_amount = 0;
     #endif
 
+    MEM_ARENA_LOCK();
+    arena->prev = NULL;
+    arena->next = mem_arena_registry.head;
+    if (arena->next) { arena->next->prev = arena; }
+    mem_arena_registry.head = arena;
+    MEM_ARENA_UNLOCK();
+
     return arena;
 }
 mem_arena_t* mem_arena_subarena(mem_arena_t* base, size_t size) {
@@ -139,6 +203,9 @@ mem_arena_t* mem_arena_subarena(mem_arena_t* base, size_t size) {
     subarena->pos         = (char*) subarena + sizeof(mem_arena_t);
     subarena->end         = subarena->pos + size;
     subarena->commit_pos  = subarena->pos;
+    subarena->peak        = subarena->pos;
+    subarena->next        = NULL;
+    subarena->prev        = NULL;
 
     #ifdef BUILD_DEBUG
     subarena->depth         = base->depth + 1;
@@ -155,6 +222,7 @@ void* mem_arena_push(mem_arena_t* arena, size_t size) {
         //buf = ARENA_BUFFER(arena, arena->pos);
         buf = arena->pos;
         arena->pos = push_to;
+        if (arena->pos > arena->peak) { arena->peak = arena->pos; }
 
         /* handle committing */
         if (arena->pos >= arena->commit_pos)
@@ -176,7 +244,7 @@ void* mem_arena_push(mem_arena_t* arena, size_t size) {
     return buf;
 }
 void mem_arena_pop_to(mem_arena_t* arena, char* buf) {
-    MEM_ARENA_ASSERT((char*) (arena + sizeof(mem_arena_t)) <= buf);
+    MEM_ARENA_ASSERT(((char*) arena + sizeof(mem_arena_t)) <= buf);
     MEM_ARENA_ASSERT(arena->end >= buf);
 
     //size_t new_pos =  (unsigned char*) buf - (unsigned char*) ARENA_BUFFER(arena, 0);
@@ -203,6 +271,12 @@ void mem_arena_clear(mem_arena_t*  arena) {
 void mem_arena_destroy(mem_arena_t** arena) {
     size_t cap = (*arena)->end - (char*) (*arena);
 
+    MEM_ARENA_LOCK();
+    if      ((*arena)->prev)                   { (*arena)->prev->next    = (*arena)->next; }
+    else if (mem_arena_registry.head == *arena) { mem_arena_registry.head = (*arena)->next; }
+    if      ((*arena)->next)                   { (*arena)->next->prev    = (*arena)->prev; }
+    MEM_ARENA_UNLOCK();
+
     #ifdef MEM_ARENA_USE_RESERVE_AND_COMMIT_STRATEGY
       MEM_ARENA_OS_DECOMMIT((void*) *arena, cap);
       MEM_ARENA_OS_RELEASE((void*) *arena, cap);
@@ -213,9 +287,76 @@ void mem_arena_destroy(mem_arena_t** arena) {
     *arena = NULL;
 }
 
-#define ARENA_DEFAULT_RESERVE_SIZE (4 * 1024 * 1024)
+mem_arena_stats_t mem_arena_stats(mem_arena_t* arena) {
+    char* base = (char*) arena + sizeof(mem_arena_t);
+    mem_arena_stats_t stats;
+    stats.used      = (arena->pos > base) ? (size_t) (arena->pos - base) : 0;
+    stats.peak      = (size_t) (arena->peak - base);
+    stats.committed = (size_t) (arena->commit_pos - base);
+    stats.capacity  = (size_t) (arena->end - base);
+    return stats;
+}
+
+mem_arena_stats_t mem_arena_stats_total(size_t* arena_count) {
+    mem_arena_stats_t total = {0, 0, 0, 0};
+    size_t count = 0;
+    MEM_ARENA_LOCK();
+    for (mem_arena_t* arena = mem_arena_registry.head; arena; arena = arena->next)
+    {
+        mem_arena_stats_t stats = mem_arena_stats(arena);
+        total.used      += stats.used;
+        total.peak      += stats.peak;
+        total.committed += stats.committed;
+        total.capacity  += stats.capacity;
+        count++;
+    }
+    MEM_ARENA_UNLOCK();
+    if (arena_count) { *arena_count = count; }
+    return total;
+}
+
+#ifndef ARENA_DEFAULT_RESERVE_SIZE
+  #define ARENA_DEFAULT_RESERVE_SIZE (4 * 1024 * 1024)
+#endif
+#ifndef ARENA_THREAD_RESERVE_SIZE
+  #define ARENA_THREAD_RESERVE_SIZE  (4 * 1024 * 1024)
+#endif
+
+#if defined(_WIN32)
+static void WINAPI mem_arena_thread_exit(void* arena) { if (arena) { mem_arena_destroy((mem_arena_t**) &arena); } }
+static BOOL CALLBACK mem_arena_init_defaults(PINIT_ONCE once, void* param, void** context) {
+    (void) once; (void) param; (void) context;
+    mem_arena_registry.thread_key      = FlsAlloc(mem_arena_thread_exit);
+    mem_arena_registry.process_default = mem_arena_create(ARENA_DEFAULT_RESERVE_SIZE);
+    return TRUE;
+}
+#else
+static void mem_arena_thread_exit(void* arena) { if (arena) { mem_arena_destroy((mem_arena_t**) &arena); } }
+static void mem_arena_init_defaults(void) {
+    int created = pthread_key_create(&mem_arena_registry.thread_key, mem_arena_thread_exit);
+    MEM_ARENA_ASSERT(created == 0); (void) created;
+    mem_arena_registry.process_default = mem_arena_create(ARENA_DEFAULT_RESERVE_SIZE);
+}
+#endif
+
 mem_arena_t* mem_arena_default() {
-    mem_arena_t* default_arena = mem_arena_create(ARENA_DEFAULT_RESERVE_SIZE);
-    return default_arena;
+  #if defined(_WIN32)
+    InitOnceExecuteOnce(&mem_arena_registry.once, mem_arena_init_defaults, NULL, NULL);
+  #else
+    pthread_once(&mem_arena_registry.once, mem_arena_init_defaults);
+  #endif
+    return mem_arena_registry.process_default;
+}
+
+mem_arena_t* mem_arena_thread() {
+    mem_arena_default(); /* makes sure the thread key exists */
+  #if defined(_WIN32)
+    mem_arena_t* arena = (mem_arena_t*) FlsGetValue(mem_arena_registry.thread_key);
+    if (!arena) { arena = mem_arena_create(ARENA_THREAD_RESERVE_SIZE); FlsSetValue(mem_arena_registry.thread_key, arena); }
+  #else
+    mem_arena_t* arena = (mem_arena_t*) pthread_getspecific(mem_arena_registry.thread_key);
+    if (!arena) { arena = mem_arena_create(ARENA_THREAD_RESERVE_SIZE); pthread_setspecific(mem_arena_registry.thread_key, arena); }
+  #endif
+    return arena;
 }
 #endif // MEM_ARENA_IMPLEMENTATION
@@ -117,6 +117,15 @@ int main(int argc, char** argv)
         number_arr = ARENA_PUSH_ARRAY(arena, size_t, 256);
         for (size_t i = 0; i < 256; i++) { assert(!number_arr[i]); }
 
+        /* stats: the peak stays after popping */
+        mem_arena_stats_t stats = mem_arena_stats(arena);
+        size_t used = KILOBYTES(4) + sizeof(struct test_align_unpacked) + 256 * sizeof(size_t);
+        assert(stats.used == used && stats.peak == used && stats.capacity == MEGABYTES(1));
+        assert(stats.committed >= stats.used);
+        mem_arena_pop_by(arena, KILOBYTES(2));
+        stats = mem_arena_stats(arena);
+        assert(stats.used == used - KILOBYTES(2) && stats.peak == used);
+
         /* provoke an overflow */
         //mem_arena_push(&sub_arena, KILOBYTES(3));
         //mem_arena_push(&arena,     MEGABYTES(10));
@@ -149,6 +158,35 @@ int main(int argc, char** argv)
         //mem_arena_t* test_arena     = mem_arena_subarena(base_arena, 1); // should fail
     }
 
+    /* TEST DEFAULT ARENAS & REGISTRY */
+    {
+        size_t count_before = 0;
+        mem_arena_stats_t before = mem_arena_stats_total(&count_before);
+
+        /* defaults are created once, the thread default is a separate arena */
+        mem_arena_t* process_arena = mem_arena_default();
+        mem_arena_t* thread_arena  = mem_arena_thread();
+        assert(process_arena && process_arena == mem_arena_default());
+        assert(thread_arena  && thread_arena  == mem_arena_thread() && thread_arena != process_arena);
+
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+        mem_arena_push(arena, KILOBYTES(8));
+        size_t count = 0;
+        mem_arena_stats_t total = mem_arena_stats_total(&count);
+        assert(count == count_before + 3);
+        assert(total.capacity == before.capacity + 2 * ARENA_DEFAULT_RESERVE_SIZE + MEGABYTES(1));
+        assert(total.used == before.used + KILOBYTES(8) && total.committed >= total.used);
+
+        /* subarenas are counted as part of their base */
+        mem_arena_subarena(arena, KILOBYTES(64));
+        mem_arena_stats_total(&count);
+        assert(count == count_before + 3);
+
+        mem_arena_destroy(&arena);
+        mem_arena_stats_total(&count);
+        assert(count == count_before + 2);
+    }
+
     return 0;
 }
 
@@ -0,0 +1,390 @@
+#pragma once
+
+/* runtime metrics: counters, gauges and latency histograms, registered by name.
+ *
+ * - counters are sharded: every thread adds to one of METRICS_SHARDS cache
+ *   lines, reading sums them up
+ * - gauges hold a single signed value
+ * - histograms use log-linear buckets (HDR style): every power of 2 is split
+ *   into 2^METRICS_HISTOGRAM_SUB_BITS buckets, i.e. percentiles are accurate
+ *   to ~6% for the default of 4 sub bits. Recording is lock-free.
+ *
+ * Metrics live until the end of the program. Looking a metric up by name takes
+ * a lock, the METRIC_* macros do it once per call site and cache the pointer.
+ *
+ * A snapshot has one line per metric and can be written to a file (see
+ * metrics_snapshot(), metrics_periodic_start()) or to the log (METRICS_LOG).
+ * Arenas can be tracked as well to report their memory usage.
+ */
+
+/* Example usage code:
+
+       METRIC_COUNT("net.packets", 1);
+       METRIC_GAUGE_SET("net.connections", connection_count);
+
+       u64 start = platform_time_ns();
+       update();
+       METRIC_RECORD("frame.ns", platform_time_ns() - start);
+
+       metrics_track_arena("arena.frame", frame_arena);
+       METRICS_LOG(INFO|PLATFORM);  // or: metrics_periodic_start(file, 1000);
+*/
+
+#ifndef METRICS_MAX
+  #define METRICS_MAX                 256 /* nr of metrics that can be registered */
+#endif
+#ifndef METRICS_SHARDS
+  #define METRICS_SHARDS              16  /* per counter, has to be a power of 2 */
+#endif
+#ifndef METRICS_HISTOGRAM_SUB_BITS
+  #define METRICS_HISTOGRAM_SUB_BITS  4
+#endif
+#define METRICS_HISTOGRAM_BUCKETS     ((64 - METRICS_HISTOGRAM_SUB_BITS + 1) << METRICS_HISTOGRAM_SUB_BITS)
+#define METRICS_LINE_SIZE             256 /* max. length of a snapshot line */
+
+typedef struct metrics_counter_t
+{
+    struct
+    {
+        u64 value;
+        CACHE_LINE_PAD(sizeof(u64));
+    } shards[METRICS_SHARDS];
+} metrics_counter_t;
+
+typedef struct metrics_gauge_t
+{
+    i64 value;
+} metrics_gauge_t;
+
+typedef struct metrics_histogram_t
+{
+    u64 count;
+    u64 sum;
+    u64 min;
+    u64 max;
+    u64 buckets[METRICS_HISTOGRAM_BUCKETS];
+} metrics_histogram_t;
+
+/* api: lookups create the metric if it doesn't exist yet */
+metrics_counter_t*   metrics_counter       (const char* name);
+metrics_gauge_t*     metrics_gauge         (const char* name);
+metrics_histogram_t* metrics_histogram     (const char* name);
+void                 metrics_track_arena   (const char* name, mem_arena_t* arena);
+void                 metrics_untrack_arena (mem_arena_t* arena); /* call before destroying it, waits for a snapshot reading it */
+
+u64                  metrics_counter_value (metrics_counter_t* counter);
+u64                  metrics_histogram_percentile(metrics_histogram_t* hist, f64 percentile); /* e.g. 99.9 */
+
+b32                  metrics_snapshot_line (u32 idx, char* buf, size_t size); /* 0 when idx is past the last metric */
+void                 metrics_snapshot      (FILE* out);
+b32                  metrics_periodic_start(FILE* out, u32 interval_ms);      /* snapshot on a background thread */
+void                 metrics_periodic_stop (void);
+
+#define METRICS_LOAD(ptr)           atomic_load_u64((ptr), ATOMIC_ACQUIRE)
+#define METRICS_STORE(ptr, val)     atomic_store_u64((ptr), (val), ATOMIC_RELEASE)
+#define METRICS_ADD(ptr, val)       atomic_fetch_add_u64((ptr), (val), ATOMIC_RELAXED)
+#define METRICS_LOAD_PTR(ptr)       atomic_load_ptr((void**) (ptr), ATOMIC_ACQUIRE)
+#define METRICS_STORE_PTR(ptr, val) atomic_store_ptr((void**) (ptr), (void*) (val), ATOMIC_RELEASE)
+#define metrics_cas(ptr, exp, des)  atomic_cas_weak_u64((ptr), (exp), (des), ATOMIC_RELAXED)
+
+#if defined(COMPILER_TCC)
+  #define METRICS_THREAD_LOCAL /* NOTE: no TLS in tcc, all threads share a shard */
+#else
+  #define METRICS_THREAD_LOCAL thread_local
+#endif
+extern METRICS_THREAD_LOCAL u32 metrics_thread_shard; /* shard index + 1, 0 if not assigned yet */
+u32 metrics_assign_shard(void);
+
+static inline void metrics_counter_add(metrics_counter_t* counter, u64 n)
+{
+    u32 shard = metrics_thread_shard;
+    if (!shard) { shard = metrics_assign_shard(); }
+    METRICS_ADD(&counter->shards[shard - 1].value, n);
+}
+
+static inline void metrics_gauge_set  (metrics_gauge_t* gauge, i64 value) { METRICS_STORE((u64*) &gauge->value, (u64) value); }
+static inline void metrics_gauge_add  (metrics_gauge_t* gauge, i64 delta) { METRICS_ADD((u64*) &gauge->value, (u64) delta); }
+static inline i64  metrics_gauge_value(metrics_gauge_t* gauge)            { return (i64) METRICS_LOAD((u64*) &gauge->value); }
+
+/* values below 2^SUB_BITS get a bucket each, above that every power of 2 gets 2^SUB_BITS buckets */
+static inline u32 metrics_histogram_bucket(u64 value)
+{
+    if (value < (1u << METRICS_HISTOGRAM_SUB_BITS)) { return (u32) value; }
+    u32 msb = 63;
+    while (!(value >> msb)) { msb--; } /* NOTE: compilers turn this into bsr/clz */
+    u32 shift = msb - METRICS_HISTOGRAM_SUB_BITS;
+    u32 sub   = (u32) (value >> shift) & ((1u << METRICS_HISTOGRAM_SUB_BITS) - 1);
+    return ((shift + 1) << METRICS_HISTOGRAM_SUB_BITS) + sub;
+}
+
+static inline void metrics_histogram_record(metrics_histogram_t* hist, u64 value)
+{
+    METRICS_ADD(&hist->buckets[metrics_histogram_bucket(value)], 1);
+    METRICS_ADD(&hist->count, 1);
+    METRICS_ADD(&hist->sum, value);
+    u64 min = METRICS_LOAD(&hist->min);
+    while (value < min && !metrics_cas(&hist->min, &min, value)) {}
+    u64 max = METRICS_LOAD(&hist->max);
+    while (value > max && !metrics_cas(&hist->max, &max, value)) {}
+}
+
+/* call site helpers, the lookup happens once */
+#define METRICS_CACHED(var, type, lookup, name)                          \
+    static type* var##_cache = NULL;                                     \
+    type* var = (type*) METRICS_LOAD_PTR(&var##_cache);                  \
+    if (!var) { var = lookup(name); METRICS_STORE_PTR(&var##_cache, var); }
+
+#define METRIC_COUNT(name, n)                                                                         \
+    { METRICS_CACHED(_metric, metrics_counter_t, metrics_counter, name) metrics_counter_add(_metric, (n)); }
+#define METRIC_GAUGE_SET(name, value)                                                                 \
+    { METRICS_CACHED(_metric, metrics_gauge_t, metrics_gauge, name) metrics_gauge_set(_metric, (value)); }
+#define METRIC_GAUGE_ADD(name, delta)                                                                 \
+    { METRICS_CACHED(_metric, metrics_gauge_t, metrics_gauge, name) metrics_gauge_add(_metric, (delta)); }
+#define METRIC_RECORD(name, value)                                                                    \
+    { METRICS_CACHED(_metric, metrics_histogram_t, metrics_histogram, name) metrics_histogram_record(_metric, (value)); }
+
+/* writes a snapshot through LOG(flags, ...), one message per metric */
+#define METRICS_LOG(flags)                                                                            \
+    {                                                                                                 \
+        char _metrics_line[METRICS_LINE_SIZE];                                                        \
+        for (u32 _metrics_i = 0; metrics_snapshot_line(_metrics_i, _metrics_line, sizeof(_metrics_line)); _metrics_i++) \
+        {                                                                                             \
+            if (_metrics_line[0]) { LOG(flags, "%s", _metrics_line); }                                \
+        }                                                                                             \
+    }
+
+#ifdef BASIC_IMPLEMENTATION
+#include <time.h> /* for time */
+
+enum { METRICS_TYPE_COUNTER, METRICS_TYPE_GAUGE, METRICS_TYPE_HISTOGRAM, METRICS_TYPE_ARENA };
+
+typedef struct metrics_entry_t
+{
+    char* name;
+    int   type;
+    void* metric; /* NULL for untracked arenas */
+} metrics_entry_t;
+
+METRICS_THREAD_LOCAL u32 metrics_thread_shard = 0;
+
+static struct
+{
+    platform_mutex_t  lock;
+    u64               count;       /* entries are published before the count */
+    u64               next_shard;
+    metrics_entry_t   entries[METRICS_MAX];
+
+    u64               periodic_running;
+    u32               periodic_interval_ms;
+    FILE*             periodic_out;
+    platform_thread_t periodic_thread;
+} metrics_registry = { { 0 }, 0, 0, { { NULL, 0, NULL } }, 0, 0, NULL, { 0, NULL, NULL, 0 } };
+
+u32 metrics_assign_shard(void)
+{
+    /* round robin, so the first METRICS_SHARDS threads never share a cache line */
+    metrics_thread_shard = (u32) (METRICS_ADD(&metrics_registry.next_shard, 1) & (METRICS_SHARDS - 1)) + 1;
+    return metrics_thread_shard;
+}
+
+/* allocation aligned to a cache line, metrics are never freed */
+static void* metrics_alloc(size_t size)
+{
+    u8* mem = (u8*) mem_alloc(size + CACHE_LINE_SIZE);
+    MEM_ASSERT(mem);
+    return (void*) NEXT_ALIGN_POW2((uintptr_t) mem, CACHE_LINE_SIZE);
+}
+
+static void* metrics_lookup(const char* name, int type, void* metric)
+{
+    platform_mutex_lock(&metrics_registry.lock);
+    u64 count = metrics_registry.count;
+    for (u64 i = 0; i < count; i++)
+    {
+        metrics_entry_t* entry = &metrics_registry.entries[i];
+        if (strcmp(entry->name, name) == 0)
+        {
+            MEM_ASSERT(entry->type == type && "metric was registered with a different type");
+            if (type == METRICS_TYPE_ARENA) { METRICS_STORE_PTR(&entry->metric, metric); }
+            platform_mutex_unlock(&metrics_registry.lock);
+            return entry->metric;
+        }
+    }
+    MEM_ASSERT(count < METRICS_MAX && "too many metrics, increase METRICS_MAX");
+
+    size_t len = strlen(name);
+    metrics_entry_t* entry = &metrics_registry.entries[count];
+    entry->name = (char*) mem_alloc(len + 1);
+    MEM_ASSERT(entry->name);
+    memcpy(entry->name, name, len + 1);
+    entry->type = type;
+    switch (type)
+    {
+        case METRICS_TYPE_COUNTER:   { metric = metrics_alloc(sizeof(metrics_counter_t)); } break;
+        case METRICS_TYPE_GAUGE:     { metric = metrics_alloc(sizeof(metrics_gauge_t));   } break;
+        case METRICS_TYPE_HISTOGRAM:
+        {
+            metrics_histogram_t* hist = (metrics_histogram_t*) metrics_alloc(sizeof(metrics_histogram_t));
+            hist->min = ~0ull;
+            metric    = hist;
+        } break;
+        default: break;
+    }
+    entry->metric = metric;
+    METRICS_STORE(&metrics_registry.count, count + 1);
+    platform_mutex_unlock(&metrics_registry.lock);
+    return metric;
+}
+
+metrics_counter_t*   metrics_counter  (const char* name) { return (metrics_counter_t*)   metrics_lookup(name, METRICS_TYPE_COUNTER,   NULL); }
+metrics_gauge_t*     metrics_gauge    (const char* name) { return (metrics_gauge_t*)     metrics_lookup(name, METRICS_TYPE_GAUGE,     NULL); }
+metrics_histogram_t* metrics_histogram(const char* name) { return (metrics_histogram_t*) metrics_lookup(name, METRICS_TYPE_HISTOGRAM, NULL); }
+
+void metrics_track_arena(const char* name, mem_arena_t* arena)
+{
+    metrics_lookup(name, METRICS_TYPE_ARENA, arena);
+}
+
+void metrics_untrack_arena(mem_arena_t* arena)
+{
+    platform_mutex_lock(&metrics_registry.lock);
+    for (u64 i = 0; i < metrics_registry.count; i++)
+    {
+        metrics_entry_t* entry = &metrics_registry.entries[i];
+        if (entry->type == METRICS_TYPE_ARENA && METRICS_LOAD_PTR(&entry->metric) == (void*) arena) { METRICS_STORE_PTR(&entry->metric, NULL); }
+    }
+    platform_mutex_unlock(&metrics_registry.lock);
+}
+
+u64 metrics_counter_value(metrics_counter_t* counter)
+{
+    u64 sum = 0;
+    for (u32 i = 0; i < METRICS_SHARDS; i++) { sum += METRICS_LOAD(&counter->shards[i].value); }
+    return sum;
+}
+
+u64 metrics_histogram_percentile(metrics_histogram_t* hist, f64 percentile)
+{
+    u64 count = METRICS_LOAD(&hist->count);
+    if (!count) { return 0; }
+
+    /* rank of the value we're looking for, then find its bucket */
+    u64 rank = (u64) ((percentile / 100.0) * (f64) count + 0.5);
+    if (rank < 1)     { rank = 1;     }
+    if (rank > count) { rank = count; }
+    u64 seen = 0;
+    u64 max  = METRICS_LOAD(&hist->max);
+    for (u32 i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += METRICS_LOAD(&hist->buckets[i]);
+        if (seen >= rank)
+        {
+            /* highest value that falls into the bucket */
+            u64 upper = i;
+            if (i >= (1u << METRICS_HISTOGRAM_SUB_BITS))
+            {
+                u32 shift = (i >> METRICS_HISTOGRAM_SUB_BITS) - 1;
+                u64 sub   = (i & ((1u << METRICS_HISTOGRAM_SUB_BITS) - 1)) | (1u << METRICS_HISTOGRAM_SUB_BITS);
+                upper     = ((sub + 1) << shift) - 1;
+            }
+            return (upper < max) ? upper : max;
+        }
+    }
+    return max; /* records that raced with us */
+}
+
+b32 metrics_snapshot_line(u32 idx, char* buf, size_t size)
+{
+    if (idx >= METRICS_LOAD(&metrics_registry.count)) { return 0; }
+
+    metrics_entry_t* entry  = &metrics_registry.entries[idx];
+    void*            metric = METRICS_LOAD_PTR(&entry->metric);
+    buf[0] = '\0';
+    switch (entry->type)
+    {
+        case METRICS_TYPE_COUNTER:
+        {
+            snprintf(buf, size, "counter   %s %llu", entry->name, (unsigned long long) metrics_counter_value((metrics_counter_t*) metric));
+        } break;
+        case METRICS_TYPE_GAUGE:
+        {
+            snprintf(buf, size, "gauge     %s %lld", entry->name, (long long) metrics_gauge_value((metrics_gauge_t*) metric));
+        } break;
+        case METRICS_TYPE_HISTOGRAM:
+        {
+            metrics_histogram_t* hist  = (metrics_histogram_t*) metric;
+            u64                  count = METRICS_LOAD(&hist->count);
+            snprintf(buf, size, "histogram %s count=%llu min=%llu p50=%llu p90=%llu p99=%llu p999=%llu max=%llu mean=%.1f",
+                     entry->name, (unsigned long long) count,
+                     (unsigned long long) (count ? METRICS_LOAD(&hist->min) : 0),
+                     (unsigned long long) metrics_histogram_percentile(hist, 50.0),
+                     (unsigned long long) metrics_histogram_percentile(hist, 90.0),
+                     (unsigned long long) metrics_histogram_percentile(hist, 99.0),
+                     (unsigned long long) metrics_histogram_percentile(hist, 99.9),
+                     (unsigned long long) METRICS_LOAD(&hist->max),
+                     count ? (f64) METRICS_LOAD(&hist->sum) / (f64) count : 0.0);
+        } break;
+        case METRICS_TYPE_ARENA:
+        {
+            /* under the lock, so metrics_untrack_arena() (& the destroy after it) waits for us */
+            platform_mutex_lock(&metrics_registry.lock);
+            metric = METRICS_LOAD_PTR(&entry->metric);
+            if (metric) /* NULL: untracked */
+            {
+                mem_arena_stats_t stats = mem_arena_stats((mem_arena_t*) metric);
+                snprintf(buf, size, "arena     %s used=%llu peak=%llu committed=%llu capacity=%llu", entry->name,
+                         (unsigned long long) stats.used, (unsigned long long) stats.peak,
+                         (unsigned long long) stats.committed, (unsigned long long) stats.capacity);
+            }
+            platform_mutex_unlock(&metrics_registry.lock);
+        } break;
+        default: break;
+    }
+    return 1;
+}
+
+void metrics_snapshot(FILE* out)
+{
+    char line[METRICS_LINE_SIZE];
+    for (u32 i = 0; metrics_snapshot_line(i, line, sizeof(line)); i++)
+    {
+        if (line[0]) { fprintf(out, "%s\n", line); }
+    }
+}
+
+static void metrics_periodic_thread(void* arg)
+{
+    (void) arg;
+    u32 slept = 0;
+    while (METRICS_LOAD(&metrics_registry.periodic_running))
+    {
+        /* sleep in small steps, so stopping doesn't take a whole interval */
+        platform_sleep_ns(10 * 1000000ull);
+        slept += 10;
+        if (slept < metrics_registry.periodic_interval_ms) { continue; }
+        slept = 0;
+
+        fprintf(metrics_registry.periodic_out, "# metrics %llu\n", (unsigned long long) time(NULL));
+        metrics_snapshot(metrics_registry.periodic_out);
+        fflush(metrics_registry.periodic_out);
+    }
+}
+
+b32 metrics_periodic_start(FILE* out, u32 interval_ms)
+{
+    if (METRICS_LOAD(&metrics_registry.periodic_running)) { return 0; }
+    metrics_registry.periodic_out         = out;
+    metrics_registry.periodic_interval_ms = interval_ms;
+    METRICS_STORE(&metrics_registry.periodic_running, 1);
+    b32 started = platform_thread_create(&metrics_registry.periodic_thread, metrics_periodic_thread, NULL, NULL);
+    if (!started) { METRICS_STORE(&metrics_registry.periodic_running, 0); }
+    return started;
+}
+
+void metrics_periodic_stop(void)
+{
+    if (!METRICS_LOAD(&metrics_registry.periodic_running)) { return; }
+    METRICS_STORE(&metrics_registry.periodic_running, 0);
+    platform_thread_join(&metrics_registry.periodic_thread);
+}
+#endif // BASIC_IMPLEMENTATION
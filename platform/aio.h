@@ -0,0 +1,474 @@
+#pragma once
+
+/*
+ * asynchronous file i/o: submit batches of reads & writes into caller-provided
+ * buffers, then poll or wait for their completions. Uses io_uring on linux
+ * (raw syscalls, no liburing, needs linux 5.6) and falls back to a pool of
+ * worker threads doing pread/pwrite (ReadFile/WriteFile on windows) when
+ * io_uring is unavailable (old kernel, seccomp) or PLATFORM_AIO_FORCE_THREADS
+ * is passed.
+ *
+ * - requests complete in any order, match them up with their user_data
+ * - like pread/pwrite a request can transfer fewer bytes than its size (end of
+ *   file, signals, some filesystems) on every backend, submit the rest again
+ * - at most queue_depth requests are in flight, platform_aio_submit() returns
+ *   how many it took
+ * - one thread submits & reaps (like an io_uring), the engine is not shared
+ * - registered buffers are pinned once instead of for every request (io_uring
+ *   only, ignored by the thread pool), set buffer_index of the request
+ * - PLATFORM_AIO_OPEN_DIRECT bypasses the page cache (O_DIRECT), the buffer,
+ *   offset & size then have to be aligned to the logical block size (4096 is safe)
+ *
+ * Depends on platform.h (threads & locks for the fallback).
+ */
+
+/* Example usage code:
+
+       platform_aio_t aio;
+       platform_aio_init(&aio, 64, 0);
+       for (u32 i = 0; i < count; i++)
+       {
+           files[i] = platform_aio_open(paths[i], 0);
+           reqs[i]  = platform_aio_read(files[i], buffers[i], sizes[i], 0, i); // user_data: i
+       }
+       for (u32 submitted = 0, done = 0; done < count;)
+       {
+           submitted += platform_aio_submit(&aio, reqs + submitted, count - submitted);
+           platform_aio_completion_t c[64];
+           u32 n = platform_aio_wait(&aio, c, 64, 1);
+           for (u32 j = 0; j < n; j++) { on_loaded(c[j].user_data, c[j].result); } // result: bytes or -errno
+           done += n;
+       }
+       platform_aio_destroy(&aio);
+*/
+
+#include <stdint.h>
+#include <stdlib.h> /* for calloc, free */
+#include <string.h> /* for memset */
+#if defined(PLATFORM_WIN32)
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>  /* for open, O_DIRECT */
+    #include <unistd.h> /* for pread, pwrite, close */
+#endif
+#if defined(PLATFORM_LINUX) && !defined(PLATFORM_AIO_NO_URING) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define PLATFORM_AIO_URING
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>    /* for mmap of the rings */
+        #include <sys/syscall.h>
+        #include <sys/uio.h>     /* for struct iovec */
+        #ifndef __NR_io_uring_setup /* same number on all architectures */
+            #define __NR_io_uring_setup    425
+            #define __NR_io_uring_enter    426
+            #define __NR_io_uring_register 427
+        #endif
+    #endif
+#endif
+
+#ifndef PLATFORM_AIO_THREAD_COUNT
+  #define PLATFORM_AIO_THREAD_COUNT 8 /* fallback workers, i/o bound so not tied to the core count */
+#endif
+
+typedef intptr_t platform_aio_file_t; /* fd or HANDLE */
+#define PLATFORM_AIO_INVALID_FILE ((platform_aio_file_t) -1)
+
+enum
+{
+    PLATFORM_AIO_FORCE_THREADS = 1 << 0, /* platform_aio_init(): don't use io_uring */
+    PLATFORM_AIO_OPEN_WRITE    = 1 << 1, /* platform_aio_open(): create/truncate for reading & writing */
+    PLATFORM_AIO_OPEN_DIRECT   = 1 << 2, /* platform_aio_open(): bypass the page cache */
+};
+
+typedef enum platform_aio_op_e      { PLATFORM_AIO_OP_READ, PLATFORM_AIO_OP_WRITE } platform_aio_op_e;
+typedef enum platform_aio_backend_e { PLATFORM_AIO_BACKEND_URING, PLATFORM_AIO_BACKEND_THREADS } platform_aio_backend_e;
+
+typedef struct platform_aio_request_t
+{
+    platform_aio_file_t file;
+    void*               buffer;
+    uint64_t            offset;
+    uint32_t            size;
+    uint32_t            op;           /* platform_aio_op_e */
+    int32_t             buffer_index; /* registered buffer that holds buffer, -1 if none */
+    uint64_t            user_data;
+} platform_aio_request_t;
+
+typedef struct platform_aio_completion_t
+{
+    uint64_t user_data;
+    int64_t  result; /* bytes transferred (can be short) or -errno (-GetLastError() on windows) */
+} platform_aio_completion_t;
+
+typedef struct platform_aio_t
+{
+    platform_aio_backend_e backend;
+    uint32_t               queue_depth; /* power of 2 */
+    uint32_t               in_flight;   /* submitted, not yet reaped */
+
+#if defined(PLATFORM_AIO_URING)
+    int                    ring_fd;
+    void*                  sq_ring;
+    size_t                 sq_ring_size;
+    void*                  cq_ring;     /* same as sq_ring with IORING_FEAT_SINGLE_MMAP */
+    size_t                 cq_ring_size;
+    struct io_uring_sqe*   sqes;
+    size_t                 sqes_size;
+    uint32_t*              sq_head;
+    uint32_t*              sq_tail;
+    uint32_t*              sq_array;
+    uint32_t               sq_mask;
+    uint32_t*              cq_head;
+    uint32_t*              cq_tail;
+    uint32_t               cq_mask;
+    struct io_uring_cqe*   cqes;
+#endif
+
+    /* thread pool fallback: request & completion rings of queue_depth, guarded by lock */
+    platform_thread_t          threads[PLATFORM_AIO_THREAD_COUNT];
+    uint32_t                   thread_count;
+    platform_mutex_t           lock;
+    platform_condvar_t         work_cv;
+    platform_condvar_t         done_cv;
+    platform_aio_request_t*    requests;
+    platform_aio_completion_t* completions;
+    uint32_t                   request_head;
+    uint32_t                   request_tail;
+    uint32_t                   completion_head;
+    uint32_t                   completion_tail;
+    uint32_t                   shutdown;
+} platform_aio_t;
+
+inline static platform_aio_request_t platform_aio_read(platform_aio_file_t file, void* buffer, uint32_t size, uint64_t offset, uint64_t user_data)
+{
+    platform_aio_request_t req;
+    req.file         = file;
+    req.buffer       = buffer;
+    req.offset       = offset;
+    req.size         = size;
+    req.op           = PLATFORM_AIO_OP_READ;
+    req.buffer_index = -1;
+    req.user_data    = user_data;
+    return req;
+}
+
+inline static platform_aio_request_t platform_aio_write(platform_aio_file_t file, const void* buffer, uint32_t size, uint64_t offset, uint64_t user_data)
+{
+    platform_aio_request_t req = platform_aio_read(file, (void*) buffer, size, offset, user_data);
+    req.op = PLATFORM_AIO_OP_WRITE;
+    return req;
+}
+
+inline static platform_aio_file_t platform_aio_open(const char* path, uint32_t flags)
+{
+#if defined(PLATFORM_WIN32)
+    DWORD access  = (flags & PLATFORM_AIO_OPEN_WRITE)  ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+    DWORD create  = (flags & PLATFORM_AIO_OPEN_WRITE)  ? CREATE_ALWAYS : OPEN_EXISTING;
+    DWORD attribs = (flags & PLATFORM_AIO_OPEN_DIRECT) ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL;
+    HANDLE file   = CreateFileA(path, access, FILE_SHARE_READ, NULL, create, attribs, NULL);
+    return (file == INVALID_HANDLE_VALUE) ? PLATFORM_AIO_INVALID_FILE : (platform_aio_file_t) file;
+#else
+    int oflags = (flags & PLATFORM_AIO_OPEN_WRITE) ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+  #if defined(O_DIRECT)
+    if (flags & PLATFORM_AIO_OPEN_DIRECT) { oflags |= O_DIRECT; }
+  #elif defined(__O_DIRECT) /* glibc hides O_DIRECT without _GNU_SOURCE */
+    if (flags & PLATFORM_AIO_OPEN_DIRECT) { oflags |= __O_DIRECT; }
+  #endif
+    int fd = open(path, oflags | O_CLOEXEC, 0644);
+  #if defined(PLATFORM_MACOS)
+    if (fd >= 0 && (flags & PLATFORM_AIO_OPEN_DIRECT)) { fcntl(fd, F_NOCACHE, 1); }
+  #endif
+    return (fd < 0) ? PLATFORM_AIO_INVALID_FILE : (platform_aio_file_t) fd;
+#endif
+}
+
+inline static void platform_aio_close(platform_aio_file_t file)
+{
+#if defined(PLATFORM_WIN32)
+    CloseHandle((HANDLE) file);
+#else
+    close((int) file);
+#endif
+}
+
+/* one blocking read/write, used by the thread pool. Short transfers are
+ * reported as-is, the same as the io_uring backend does */
+inline static int64_t _platform_aio_perform(const platform_aio_request_t* req)
+{
+#if defined(PLATFORM_WIN32)
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset     = (DWORD) req->offset;
+    ov.OffsetHigh = (DWORD) (req->offset >> 32);
+    DWORD bytes   = 0;
+    BOOL ok = (req->op == PLATFORM_AIO_OP_READ) ? ReadFile((HANDLE) req->file, req->buffer, req->size, &bytes, &ov)
+                                                 : WriteFile((HANDLE) req->file, req->buffer, req->size, &bytes, &ov);
+    if (!ok)
+    {
+        DWORD error = GetLastError();
+        return (error == ERROR_HANDLE_EOF) ? 0 : -(int64_t) error;
+    }
+    return (int64_t) bytes;
+#else
+    for (;;)
+    {
+        ssize_t n = (req->op == PLATFORM_AIO_OP_READ) ? pread ((int) req->file, req->buffer, req->size, (off_t) req->offset)
+                                                      : pwrite((int) req->file, req->buffer, req->size, (off_t) req->offset);
+        if (n >= 0)         { return (int64_t) n; }
+        if (errno != EINTR) { return -(int64_t) errno; }
+    }
+#endif
+}
+
+inline static void _platform_aio_worker(void* arg)
+{
+    platform_aio_t* aio  = (platform_aio_t*) arg;
+    uint32_t        mask = aio->queue_depth - 1;
+    platform_mutex_lock(&aio->lock);
+    for (;;)
+    {
+        while (aio->request_head == aio->request_tail && !aio->shutdown) { platform_condvar_wait(&aio->work_cv, &aio->lock); }
+        if (aio->request_head == aio->request_tail) { break; } /* shut down & drained */
+        platform_aio_request_t req = aio->requests[aio->request_head++ & mask];
+        platform_mutex_unlock(&aio->lock);
+
+        platform_aio_completion_t completion;
+        completion.user_data = req.user_data;
+        completion.result    = _platform_aio_perform(&req);
+
+        platform_mutex_lock(&aio->lock);
+        aio->completions[aio->completion_tail++ & mask] = completion;
+        platform_condvar_signal(&aio->done_cv);
+    }
+    platform_mutex_unlock(&aio->lock);
+}
+
+#if defined(PLATFORM_AIO_URING)
+inline static int _platform_aio_enter(platform_aio_t* aio, uint32_t to_submit, uint32_t min_complete)
+{
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    return (int) syscall(__NR_io_uring_enter, aio->ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+inline static int _platform_aio_uring_init(platform_aio_t* aio)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    aio->ring_fd = (int) syscall(__NR_io_uring_setup, aio->queue_depth, &params);
+    if (aio->ring_fd < 0) { return 0; }
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) { close(aio->ring_fd); return 0; } /* < 5.6, no IORING_OP_READ */
+
+    aio->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    aio->cq_ring_size = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+    aio->sqes_size    = params.sq_entries * sizeof(struct io_uring_sqe);
+    int single_mmap   = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && aio->cq_ring_size > aio->sq_ring_size) { aio->sq_ring_size = aio->cq_ring_size; }
+
+    void* sq   = mmap(NULL, aio->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQ_RING);
+    void* cq   = single_mmap ? sq : mmap(NULL, aio->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(NULL, aio->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        if (sqes != MAP_FAILED)               { munmap(sqes, aio->sqes_size); }
+        if (!single_mmap && cq != MAP_FAILED) { munmap(cq, aio->cq_ring_size); }
+        if (sq != MAP_FAILED)                 { munmap(sq, aio->sq_ring_size); }
+        close(aio->ring_fd);
+        return 0;
+    }
+    aio->sq_ring  = sq;
+    aio->cq_ring  = cq;
+    aio->sqes     = (struct io_uring_sqe*) sqes;
+    aio->sq_head  = (uint32_t*) ((char*) sq + params.sq_off.head);
+    aio->sq_tail  = (uint32_t*) ((char*) sq + params.sq_off.tail);
+    aio->sq_array = (uint32_t*) ((char*) sq + params.sq_off.array);
+    aio->sq_mask  = *(uint32_t*) ((char*) sq + params.sq_off.ring_mask);
+    aio->cq_head  = (uint32_t*) ((char*) cq + params.cq_off.head);
+    aio->cq_tail  = (uint32_t*) ((char*) cq + params.cq_off.tail);
+    aio->cq_mask  = *(uint32_t*) ((char*) cq + params.cq_off.ring_mask);
+    aio->cqes     = (struct io_uring_cqe*) ((char*) cq + params.cq_off.cqes);
+    return 1;
+}
+
+inline static uint32_t _platform_aio_uring_reap(platform_aio_t* aio, platform_aio_completion_t* out, uint32_t max)
+{
+    uint32_t head = *aio->cq_head; /* only we move the head */
+    uint32_t tail = _PLATFORM_LOAD32(aio->cq_tail);
+    uint32_t n    = 0;
+    for (; head != tail && n < max; head++, n++)
+    {
+        struct io_uring_cqe* cqe = &aio->cqes[head & aio->cq_mask];
+        out[n].user_data = cqe->user_data;
+        out[n].result    = cqe->res;
+    }
+    _PLATFORM_STORE32(aio->cq_head, head);
+    return n;
+}
+
+/* sqes the kernel hasn't consumed yet (io_uring_enter can take fewer than asked for) */
+inline static uint32_t _platform_aio_uring_unsubmitted(platform_aio_t* aio)
+{
+    return *aio->sq_tail - _PLATFORM_LOAD32(aio->sq_head);
+}
+#endif
+
+/* queue_depth is rounded up to a power of 2, flags: PLATFORM_AIO_FORCE_THREADS */
+inline static int platform_aio_init(platform_aio_t* aio, uint32_t queue_depth, uint32_t flags)
+{
+    memset(aio, 0, sizeof(*aio));
+    aio->queue_depth = 1;
+    while (aio->queue_depth < queue_depth && aio->queue_depth < 4096) { aio->queue_depth <<= 1; }
+
+#if defined(PLATFORM_AIO_URING)
+    if (!(flags & PLATFORM_AIO_FORCE_THREADS) && _platform_aio_uring_init(aio))
+    {
+        aio->backend = PLATFORM_AIO_BACKEND_URING;
+        return 1;
+    }
+#endif
+    (void) flags;
+    aio->backend     = PLATFORM_AIO_BACKEND_THREADS;
+    aio->requests    = (platform_aio_request_t*)    calloc(aio->queue_depth, sizeof(platform_aio_request_t));
+    aio->completions = (platform_aio_completion_t*) calloc(aio->queue_depth, sizeof(platform_aio_completion_t));
+    if (!aio->requests || !aio->completions) { free(aio->requests); free(aio->completions); memset(aio, 0, sizeof(*aio)); return 0; }
+    uint32_t count = (aio->queue_depth < PLATFORM_AIO_THREAD_COUNT) ? aio->queue_depth : PLATFORM_AIO_THREAD_COUNT;
+    platform_thread_desc_t desc = { 64 * 1024, 0 }; /* workers only call pread */
+    for (; aio->thread_count < count; aio->thread_count++)
+    {
+        if (!platform_thread_create(&aio->threads[aio->thread_count], _platform_aio_worker, aio, &desc)) { break; }
+    }
+    if (!aio->thread_count)
+    {
+        free(aio->requests);
+        free(aio->completions);
+        memset(aio, 0, sizeof(*aio));
+        return 0;
+    }
+    return 1;
+}
+
+/* pins buffers for requests with a buffer_index (io_uring only, a no-op for the thread pool) */
+inline static int platform_aio_register_buffers(platform_aio_t* aio, void* const* buffers, const uint64_t* sizes, uint32_t count)
+{
+#if defined(PLATFORM_AIO_URING)
+    if (aio->backend == PLATFORM_AIO_BACKEND_URING)
+    {
+        struct iovec* iovs = (struct iovec*) calloc(count, sizeof(struct iovec));
+        if (!iovs) { return 0; }
+        for (uint32_t i = 0; i < count; i++) { iovs[i].iov_base = buffers[i]; iovs[i].iov_len = sizes[i]; }
+        int result = (int) syscall(__NR_io_uring_register, aio->ring_fd, IORING_REGISTER_BUFFERS, iovs, count);
+        free(iovs);
+        return result == 0;
+    }
+#endif
+    (void) aio; (void) buffers; (void) sizes; (void) count;
+    return 1;
+}
+
+/* returns how many requests were taken (less than count when queue_depth are in flight) */
+inline static uint32_t platform_aio_submit(platform_aio_t* aio, const platform_aio_request_t* reqs, uint32_t count)
+{
+    uint32_t space = aio->queue_depth - aio->in_flight;
+    if (count > space) { count = space; }
+    if (!count)        { return 0; }
+    aio->in_flight += count;
+
+#if defined(PLATFORM_AIO_URING)
+    if (aio->backend == PLATFORM_AIO_BACKEND_URING)
+    {
+        uint32_t tail = *aio->sq_tail; /* only we move the tail */
+        for (uint32_t i = 0; i < count; i++, tail++)
+        {
+            const platform_aio_request_t* req = &reqs[i];
+            uint32_t idx             = tail & aio->sq_mask;
+            struct io_uring_sqe* sqe = &aio->sqes[idx];
+            int fixed                = req->buffer_index >= 0;
+            memset(sqe, 0, sizeof(*sqe));
+            if (req->op == PLATFORM_AIO_OP_READ) { sqe->opcode = fixed ? IORING_OP_READ_FIXED  : IORING_OP_READ;  }
+            else                                 { sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE; }
+            sqe->fd        = (int) req->file;
+            sqe->addr      = (uint64_t) (uintptr_t) req->buffer;
+            sqe->len       = req->size;
+            sqe->off       = req->offset;
+            sqe->user_data = req->user_data;
+            if (fixed) { sqe->buf_index = (uint16_t) req->buffer_index; }
+            aio->sq_array[idx] = idx;
+        }
+        _PLATFORM_STORE32(aio->sq_tail, tail); /* publish the sqes */
+        _platform_aio_enter(aio, _platform_aio_uring_unsubmitted(aio), 0);
+        return count;
+    }
+#endif
+    uint32_t mask = aio->queue_depth - 1;
+    platform_mutex_lock(&aio->lock);
+    for (uint32_t i = 0; i < count; i++) { aio->requests[aio->request_tail++ & mask] = reqs[i]; }
+    platform_condvar_broadcast(&aio->work_cv);
+    platform_mutex_unlock(&aio->lock);
+    return count;
+}
+
+/* waits until at least min_complete requests are done (capped to the ones in
+ * flight), copies up to max completions out & returns how many */
+inline static uint32_t platform_aio_wait(platform_aio_t* aio, platform_aio_completion_t* out, uint32_t max, uint32_t min_complete)
+{
+    if (min_complete > aio->in_flight) { min_complete = aio->in_flight; }
+    if (min_complete > max)            { min_complete = max; }
+    uint32_t n = 0;
+
+#if defined(PLATFORM_AIO_URING)
+    if (aio->backend == PLATFORM_AIO_BACKEND_URING)
+    {
+        uint32_t unsubmitted = _platform_aio_uring_unsubmitted(aio);
+        if (unsubmitted && !min_complete) { _platform_aio_enter(aio, unsubmitted, 0); }
+        n = _platform_aio_uring_reap(aio, out, max);
+        while (n < min_complete)
+        {
+            if (_platform_aio_enter(aio, _platform_aio_uring_unsubmitted(aio), min_complete - n) < 0 && errno != EINTR) { break; }
+            n += _platform_aio_uring_reap(aio, out + n, max - n);
+        }
+        aio->in_flight -= n;
+        return n;
+    }
+#endif
+    uint32_t mask = aio->queue_depth - 1;
+    platform_mutex_lock(&aio->lock);
+    while (aio->completion_tail - aio->completion_head < min_complete) { platform_condvar_wait(&aio->done_cv, &aio->lock); }
+    for (; n < max && aio->completion_head != aio->completion_tail; n++) { out[n] = aio->completions[aio->completion_head++ & mask]; }
+    platform_mutex_unlock(&aio->lock);
+    aio->in_flight -= n;
+    return n;
+}
+
+/* non-blocking: copies out up to max completions that are already done */
+inline static uint32_t platform_aio_poll(platform_aio_t* aio, platform_aio_completion_t* out, uint32_t max)
+{
+    return platform_aio_wait(aio, out, max, 0);
+}
+
+/* NOTE: waits for the requests still in flight (the kernel may write into
+ * their buffers until they complete), their completions are dropped */
+inline static void platform_aio_destroy(platform_aio_t* aio)
+{
+    platform_aio_completion_t dropped[64];
+    while (aio->in_flight && platform_aio_wait(aio, dropped, 64, 1)) {}
+
+#if defined(PLATFORM_AIO_URING)
+    if (aio->backend == PLATFORM_AIO_BACKEND_URING)
+    {
+        munmap(aio->sqes, aio->sqes_size);
+        if (aio->cq_ring != aio->sq_ring) { munmap(aio->cq_ring, aio->cq_ring_size); }
+        munmap(aio->sq_ring, aio->sq_ring_size);
+        close(aio->ring_fd);
+        memset(aio, 0, sizeof(*aio));
+        return;
+    }
+#endif
+    platform_mutex_lock(&aio->lock);
+    aio->shutdown = 1;
+    platform_condvar_broadcast(&aio->work_cv);
+    platform_mutex_unlock(&aio->lock);
+    for (uint32_t i = 0; i < aio->thread_count; i++) { platform_thread_join(&aio->threads[i]); }
+    free(aio->requests);
+    free(aio->completions);
+    memset(aio, 0, sizeof(*aio));
+}
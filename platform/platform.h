@@ -8,6 +8,7 @@
  * - PLATFORM_{WIN32|LINUX|MACOS}
  * - COMPILER_{GCC|CLANG|MINGW|MSVC|TCC}
  * - LANGUAGE_{C|CPP}
+ * - SIMD_{SSE2|SSE42|AVX2|NEON}: instruction sets enabled at compile-time
  * - STANDARD_{C89|C99|C11|C17|Cxx98|Cxx03|Cxx11|Cxx14|Cxx17|Cxx20}
  * - STANDARD_VERSION: Integer between 1989 and 2020
  *
@@ -31,6 +32,7 @@
  * - UNIMPLEMENTED: for unimplemented code
  * - DEPRECATED: for declaring functions deprecated (TODO)
  * - STATIC_ASSERT(expr,msg): portable static_assert
+ * - PRINTF_FORMAT(fmt_idx,args_idx): printf-style format string checking
  * - debug_running_under_debugger(): runtime debugger detection
  *
  * - OFFSET_OF(type,member): portable offsetof()
@@ -40,6 +42,18 @@
  *   Gets a pointer to the struct containing ptr as a member.
  * - ARRAY_COUNT(arr) : returns count of elements in array and 0 for pointers (decayed arrays)
  *
+ * - platform_time_ns(): monotonic clock in nanoseconds
+ * - platform_cycles(), platform_cycles_per_sec(): cpu timestamp counter & its frequency
+ * - platform_sleep_until_ns(deadline): hybrid sleep (os sleep, then spin) for precise wakeups
+ * - platform_cpu_relax(), platform_yield(): for spin-wait loops
+ *
+ * - platform_thread_{create|join}(): threads with stack size & cpu affinity
+ * - platform_{mutex|condvar|event|rwlock|spinlock}_t: futex-based locks, zero-init is unlocked
+ *
+ * - platform_cpu_info(): runtime cpu features (avx2, avx-512, neon,...), cores, caches & numa nodes
+ * - platform_cpu_has(PLATFORM_CPU_FEATURE_*): check for an instruction set extension at runtime
+ * - SIMD_DISPATCH(...), SIMD_TARGET_{SSE42|AVX2|AVX512}: kernels picked at runtime via platform_simd_level()
+ *
  * - u8,u32,u64,f32,f64,... typedefs. Can be turned off with PLATFORM_NO_TYPEDEFS
  * - numericals limits like U32_MAX, F32_MIN, etc. Can be turned off with PLATFORM_NO_TYPEDEFS
  */
@@ -55,6 +69,13 @@
     #error "No supported platform (OS) detected."
 # endif
 
+/* strict -std=c99/c11 hides the posix (clock_gettime, nanosleep) & misc
+ * (syscall) declarations, _DEFAULT_SOURCE brings back what gnu99/gnu11 have
+ * NOTE: only works if platform.h comes before the first system header */
+#if !defined(PLATFORM_WIN32) && defined(__STRICT_ANSI__) && !defined(_GNU_SOURCE) && !defined(_DEFAULT_SOURCE)
+    #define _DEFAULT_SOURCE
+#endif
+
 #if defined(__EMSCRIPTEN__)
     #define PLATFORM_WEB // NOTE: untested
 #endif
@@ -94,6 +115,22 @@
     #warning "Architecture not detected"
 #endif
 
+/* simd instruction set detection (compile-time, i.e. what the compiler is allowed to emit) */
+#if !defined(COMPILER_TCC) /* NOTE: tcc has no intrinsics */
+    #if defined(ARCH_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SIMD_SSE2
+    #endif
+    #if defined(__SSE4_2__)
+        #define SIMD_SSE42
+    #endif
+    #if defined(__AVX2__)
+        #define SIMD_AVX2
+    #endif
+    #if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define SIMD_NEON
+    #endif
+#endif
+
 /* define export declarations for .dll & .so files */
 #if defined(COMPILER_GCC)
     // NOTE GCC exports every symbol to the ELF by default, unless -fvisibility=hidden is specified
@@ -464,6 +501,15 @@ else                                                                      \
   #define DEPRECATED WARNING("no DEPRECATED macro available")
 #endif
 
+/* printf-style format checking. Usage: void my_log(const char* fmt, ...) PRINTF_FORMAT(1, 2); */
+#if defined(COMPILER_GCC) || defined(COMPILER_CLANG)
+  #define PRINTF_FORMAT(fmt_idx, args_idx) __attribute__((format(printf, fmt_idx, args_idx)))
+#elif defined(COMPILER_MINGW) /* NOTE: plain printf would check against msvcrt's printf */
+  #define PRINTF_FORMAT(fmt_idx, args_idx) __attribute__((format(gnu_printf, fmt_idx, args_idx)))
+#else
+  #define PRINTF_FORMAT(fmt_idx, args_idx)
+#endif
+
 /* static_assert */
 #if defined(LANGUAGE_CPP) && STANDARD_VERSION >= 2011
     #define STATIC_ASSERT(expr, msg) static_assert(expr, msg) /* C++11 built-in static_assert */
@@ -596,3 +642,910 @@ else                                                                      \
     #define F32_MIN -FLT_MAX
     #define F32_MAX FLT_MAX
 #endif
+
+/* timing: monotonic clock, cycle counter & sleeping
+ *
+ * - platform_time_ns(): monotonic clock in ns (clock_gettime goes through the
+ *   vDSO on linux, i.e. no syscall)
+ * - platform_cycles(): cpu timestamp counter (rdtsc on x86, cntvct_el0 on
+ *   arm64), ns on other architectures. platform_cycles_serialized() waits for
+ *   preceding instructions to finish (rdtscp), use it for the end of a measurement
+ * - platform_cycles_per_sec(): counter frequency, calibrated against the
+ *   monotonic clock on x86 (takes 10ms on the first call, cached per translation unit)
+ * - platform_sleep_until_ns(): sleeps most of the time and spins for the last
+ *   PLATFORM_SLEEP_SPIN_NS to wake up (close to) on time
+ * - platform_cpu_relax(): pause instruction for spin-wait loops
+ */
+#include <stdint.h> // for uint64_t
+#if defined(PLATFORM_WIN32)
+    #include <windows.h>
+#elif defined(PLATFORM_MACOS)
+    #include <mach/mach_time.h>
+    #include <sched.h>
+    #include <time.h>
+#else
+    #include <sched.h>
+    #include <time.h>
+#endif
+#if defined(COMPILER_MSVC)
+    #include <intrin.h>
+#endif
+
+#ifndef PLATFORM_SLEEP_SPIN_NS
+  #if defined(PLATFORM_WIN32)
+    #define PLATFORM_SLEEP_SPIN_NS 2000000 /* windows timers are coarse (1ms at best) */
+  #else
+    #define PLATFORM_SLEEP_SPIN_NS 200000  /* covers the default timer slack (50us) & wakeup latency */
+  #endif
+#endif
+
+inline static uint64_t platform_time_ns()
+{
+#if defined(PLATFORM_WIN32)
+    static LARGE_INTEGER frequency; /* NOTE: never changes while the system runs */
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) { QueryPerformanceFrequency(&frequency); }
+    QueryPerformanceCounter(&counter);
+    /* split to not overflow the multiplication */
+    uint64_t sec = (uint64_t) (counter.QuadPart / frequency.QuadPart);
+    uint64_t rem = (uint64_t) (counter.QuadPart % frequency.QuadPart);
+    return sec * 1000000000ull + (rem * 1000000000ull) / (uint64_t) frequency.QuadPart;
+#elif defined(PLATFORM_MACOS)
+    static mach_timebase_info_data_t timebase;
+    if (!timebase.denom) { mach_timebase_info(&timebase); }
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+inline static uint64_t platform_cycles()
+{
+#if defined(COMPILER_MSVC) && (defined(ARCH_X64) || defined(ARCH_X86))
+    return __rdtsc();
+#elif defined(ARCH_X64) || defined(ARCH_X86)
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t) hi << 32) | lo;
+#elif defined(ARCH_ARM64) && !defined(COMPILER_MSVC)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return platform_time_ns();
+#endif
+}
+
+inline static uint64_t platform_cycles_serialized()
+{
+#if defined(COMPILER_MSVC) && (defined(ARCH_X64) || defined(ARCH_X86))
+    unsigned int aux;
+    return __rdtscp(&aux);
+#elif defined(ARCH_X64) || defined(ARCH_X86)
+    uint32_t lo, hi, aux;
+    __asm__ __volatile__("rdtscp" : "=a"(lo), "=d"(hi), "=c"(aux));
+    (void) aux;
+    return ((uint64_t) hi << 32) | lo;
+#elif defined(ARCH_ARM64) && !defined(COMPILER_MSVC)
+    uint64_t ticks;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(ticks) : : "memory");
+    return ticks;
+#else
+    return platform_time_ns();
+#endif
+}
+
+inline static void platform_cpu_relax()
+{
+#if defined(COMPILER_MSVC) && (defined(ARCH_X64) || defined(ARCH_X86))
+    _mm_pause();
+#elif defined(COMPILER_MSVC) && defined(ARCH_ARM64)
+    __yield();
+#elif defined(ARCH_X64) || defined(ARCH_X86)
+    __asm__ __volatile__("pause");
+#elif defined(ARCH_ARM64) || defined(ARCH_ARM)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+inline static void platform_yield()
+{
+#if defined(PLATFORM_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+inline static uint64_t platform_cycles_per_sec()
+{
+    static uint64_t frequency = 0;
+    if (frequency) { return frequency; }
+#if defined(ARCH_ARM64) && !defined(COMPILER_MSVC)
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+#elif defined(ARCH_X64) || defined(ARCH_X86)
+    uint64_t ns_start     = platform_time_ns();
+    uint64_t cycles_start = platform_cycles();
+    uint64_t ns_end       = ns_start;
+    while (ns_end - ns_start < 10000000ull) { platform_cpu_relax(); ns_end = platform_time_ns(); }
+    uint64_t cycles_end   = platform_cycles();
+    frequency = (uint64_t) ((double) (cycles_end - cycles_start) * 1e9 / (double) (ns_end - ns_start));
+#else
+    frequency = 1000000000ull; /* platform_cycles() falls back to ns */
+#endif
+    return frequency;
+}
+
+/* sleep until the monotonic clock (platform_time_ns()) reaches deadline_ns */
+inline static void platform_sleep_until_ns(uint64_t deadline_ns)
+{
+    for (;;)
+    {
+        uint64_t now = platform_time_ns();
+        if (now >= deadline_ns) { return; }
+        uint64_t left = deadline_ns - now;
+        if (left > PLATFORM_SLEEP_SPIN_NS)
+        {
+            /* let the os sleep, but wake up early */
+            uint64_t sleep_ns = left - PLATFORM_SLEEP_SPIN_NS;
+#if defined(PLATFORM_WIN32)
+            Sleep((DWORD) (sleep_ns / 1000000ull));
+#else
+            struct timespec ts;
+            ts.tv_sec  = (time_t) (sleep_ns / 1000000000ull);
+            ts.tv_nsec = (long) (sleep_ns % 1000000000ull);
+            nanosleep(&ts, NULL);
+#endif
+        }
+        else if (left > PLATFORM_SLEEP_SPIN_NS / 4) { platform_yield(); }
+        else                                        { platform_cpu_relax(); }
+    }
+}
+
+inline static void platform_sleep_ns(uint64_t ns) { platform_sleep_until_ns(platform_time_ns() + ns); }
+
+/* threads & synchronization: thin layer over pthreads/win32 threads, locks are
+ * built on futexes (WaitOnAddress on windows) and are a single u32, i.e.
+ * uncontended lock/unlock never enters the kernel and zero-initialization
+ * ({0} or memset) is a valid unlocked state.
+ *
+ * - platform_thread_create/join(): optional stack size & cpu affinity mask
+ * - platform_mutex_t:    futex mutex (unlocked/locked/contended), spins shortly before sleeping
+ * - platform_condvar_t:  sequence counter futex, wait in a loop (spurious wakeups)
+ * - platform_event_t:    one-shot event, wait returns once it is set (until reset)
+ * - platform_rwlock_t:   reader-writer lock, NOTE: readers can starve writers
+ * - platform_spinlock_t: test-and-test-and-set with exponential backoff, for very short sections
+ *
+ * NOTE: on macOS futex waits fall back to yield loops (untested)
+ * NOTE: with mingw link against synchronization (-lsynchronization)
+ */
+#if defined(PLATFORM_WIN32)
+    #if defined(COMPILER_MSVC)
+        #pragma comment(lib, "synchronization.lib") /* WaitOnAddress */
+    #endif
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #if defined(PLATFORM_LINUX)
+        #include <linux/futex.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+#ifndef PLATFORM_SPIN_COUNT
+  #define PLATFORM_SPIN_COUNT 100 /* spins before a contended lock goes to sleep */
+#endif
+#define PLATFORM_BACKOFF_MAX  64  /* max pause instructions between spinlock retries */
+
+/* NOTE: the locks bring their own minimal atomics, see atomics.h for the full set */
+#if defined(COMPILER_MSVC)
+  #define _PLATFORM_LOAD32(ptr)          ((uint32_t) _InterlockedOr((volatile long*) (ptr), 0))
+  #define _PLATFORM_STORE32(ptr, val)    _InterlockedExchange((volatile long*) (ptr), (long) (val))
+  #define _PLATFORM_EXCHANGE32(ptr, val) ((uint32_t) _InterlockedExchange((volatile long*) (ptr), (long) (val)))
+  #define _PLATFORM_ADD32(ptr, val)      ((uint32_t) _InterlockedExchangeAdd((volatile long*) (ptr), (long) (val)))
+  inline static int _platform_cas32(uint32_t* ptr, uint32_t* expected, uint32_t desired)
+  {
+      uint32_t prev = (uint32_t) _InterlockedCompareExchange((volatile long*) ptr, (long) desired, (long) *expected);
+      if (prev == *expected) { return 1; }
+      *expected = prev;
+      return 0;
+  }
+#else
+  #define _PLATFORM_LOAD32(ptr)          __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+  #define _PLATFORM_STORE32(ptr, val)    __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+  #define _PLATFORM_EXCHANGE32(ptr, val) __atomic_exchange_n((ptr), (val), __ATOMIC_SEQ_CST)
+  #define _PLATFORM_ADD32(ptr, val)      __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+  inline static int _platform_cas32(uint32_t* ptr, uint32_t* expected, uint32_t desired)
+  {
+      return __atomic_compare_exchange_n(ptr, expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  }
+#endif
+
+/* futex: sleeps as long as *addr == expected (can wake up spuriously) */
+inline static void platform_futex_wait(uint32_t* addr, uint32_t expected)
+{
+#if defined(PLATFORM_WIN32)
+    WaitOnAddress((volatile VOID*) addr, &expected, sizeof(uint32_t), INFINITE);
+#elif defined(PLATFORM_LINUX)
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    while (_PLATFORM_LOAD32(addr) == expected) { platform_yield(); }
+#endif
+}
+
+inline static void platform_futex_wake(uint32_t* addr, int all)
+{
+#if defined(PLATFORM_WIN32)
+    if (all) { WakeByAddressAll((PVOID) addr);    }
+    else     { WakeByAddressSingle((PVOID) addr); }
+#elif defined(PLATFORM_LINUX)
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, all ? 0x7FFFFFFF : 1, NULL, NULL, 0);
+#else
+    (void) addr; (void) all;
+#endif
+}
+
+/* threads */
+typedef void (*platform_thread_func_t)(void* arg);
+
+typedef struct platform_thread_desc_t
+{
+    uint64_t stack_size;    /* 0: os default */
+    uint64_t affinity_mask; /* bit i: may run on cpu i, 0: any cpu */
+} platform_thread_desc_t;
+
+typedef struct platform_thread_t
+{
+#if defined(PLATFORM_WIN32)
+    HANDLE                 handle;
+#else
+    pthread_t              handle;
+#endif
+    platform_thread_func_t func;
+    void*                  arg;
+    uint64_t               affinity_mask;
+} platform_thread_t;
+
+/* pins the calling thread, returns 0 on failure (always on macOS) */
+inline static int platform_thread_set_affinity(uint64_t affinity_mask)
+{
+#if defined(PLATFORM_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) affinity_mask) != 0;
+#elif defined(PLATFORM_LINUX)
+    /* NOTE: raw syscall, cpu_set_t needs _GNU_SOURCE. Only covers cpu 0-63 */
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = {0};
+    for (unsigned int i = 0; i < 64; i++)
+    {
+        if ((affinity_mask >> i) & 1) { mask[i / (8 * sizeof(unsigned long))] |= 1ul << (i % (8 * sizeof(unsigned long))); }
+    }
+    return syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) == 0;
+#else
+    (void) affinity_mask;
+    return 0;
+#endif
+}
+
+inline static uint32_t platform_thread_id()
+{
+#if defined(PLATFORM_WIN32)
+    return (uint32_t) GetCurrentThreadId();
+#elif defined(PLATFORM_LINUX)
+    return (uint32_t) syscall(SYS_gettid);
+#else
+    uint64_t id = 0;
+    pthread_threadid_np(NULL, &id);
+    return (uint32_t) id;
+#endif
+}
+
+#if defined(PLATFORM_WIN32)
+inline static DWORD WINAPI _platform_thread_entry(LPVOID param)
+#else
+inline static void* _platform_thread_entry(void* param)
+#endif
+{
+    platform_thread_t* thread = (platform_thread_t*) param;
+    if (thread->affinity_mask) { platform_thread_set_affinity(thread->affinity_mask); }
+    thread->func(thread->arg);
+    return 0;
+}
+
+/* NOTE: thread has to stay in place until it is joined, desc can be NULL. Returns 0 on failure */
+inline static int platform_thread_create(platform_thread_t* thread, platform_thread_func_t func, void* arg,
+                                         const platform_thread_desc_t* desc)
+{
+    thread->func          = func;
+    thread->arg           = arg;
+    thread->affinity_mask = desc ? desc->affinity_mask : 0;
+    uint64_t stack_size   = desc ? desc->stack_size    : 0;
+#if defined(PLATFORM_WIN32)
+    thread->handle = CreateThread(NULL, (SIZE_T) stack_size, _platform_thread_entry, thread,
+                                  stack_size ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, NULL);
+    return thread->handle != NULL;
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    int ok = !stack_size || pthread_attr_setstacksize(&attr, (size_t) stack_size) == 0;
+    ok     = ok && pthread_create(&thread->handle, &attr, _platform_thread_entry, thread) == 0;
+    pthread_attr_destroy(&attr);
+    return ok;
+#endif
+}
+
+inline static void platform_thread_join(platform_thread_t* thread)
+{
+#if defined(PLATFORM_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+/* mutex */
+typedef struct platform_mutex_t { uint32_t state; } platform_mutex_t; /* 0: unlocked, 1: locked, 2: contended */
+
+inline static int platform_mutex_trylock(platform_mutex_t* mutex)
+{
+    uint32_t expected = 0;
+    return _platform_cas32(&mutex->state, &expected, 1);
+}
+
+inline static void platform_mutex_lock(platform_mutex_t* mutex)
+{
+    if (platform_mutex_trylock(mutex)) { return; }
+    for (int i = 0; i < PLATFORM_SPIN_COUNT; i++)
+    {
+        platform_cpu_relax();
+        if (_PLATFORM_LOAD32(&mutex->state) == 0 && platform_mutex_trylock(mutex)) { return; }
+    }
+    /* mark as contended, so the unlock wakes us up */
+    while (_PLATFORM_EXCHANGE32(&mutex->state, 2) != 0) { platform_futex_wait(&mutex->state, 2); }
+}
+
+inline static void platform_mutex_unlock(platform_mutex_t* mutex)
+{
+    if (_PLATFORM_EXCHANGE32(&mutex->state, 0) == 2) { platform_futex_wake(&mutex->state, 0); }
+}
+
+/* condition variable */
+typedef struct platform_condvar_t
+{
+    uint32_t seq;     /* bumped by every signal */
+    uint32_t waiters; /* signals skip the syscall without waiters */
+} platform_condvar_t;
+
+inline static void platform_condvar_wait(platform_condvar_t* cv, platform_mutex_t* mutex)
+{
+    uint32_t seq = _PLATFORM_LOAD32(&cv->seq);
+    _PLATFORM_ADD32(&cv->waiters, 1);
+    platform_mutex_unlock(mutex);
+    platform_futex_wait(&cv->seq, seq);
+    _PLATFORM_ADD32(&cv->waiters, (uint32_t) -1);
+    /* relock as contended, other waiters might be sleeping on the mutex */
+    while (_PLATFORM_EXCHANGE32(&mutex->state, 2) != 0) { platform_futex_wait(&mutex->state, 2); }
+}
+
+inline static void platform_condvar_signal(platform_condvar_t* cv)
+{
+    _PLATFORM_ADD32(&cv->seq, 1);
+    if (_PLATFORM_LOAD32(&cv->waiters)) { platform_futex_wake(&cv->seq, 0); }
+}
+
+inline static void platform_condvar_broadcast(platform_condvar_t* cv)
+{
+    _PLATFORM_ADD32(&cv->seq, 1);
+    if (_PLATFORM_LOAD32(&cv->waiters)) { platform_futex_wake(&cv->seq, 1); }
+}
+
+/* one-shot event */
+typedef struct platform_event_t { uint32_t state; } platform_event_t; /* 0: not set, 1: set, 2: set & waited on */
+
+inline static int platform_event_is_set(platform_event_t* event) { return _PLATFORM_LOAD32(&event->state) != 0; }
+inline static void platform_event_reset(platform_event_t* event) { _PLATFORM_STORE32(&event->state, 0); }
+
+inline static void platform_event_set(platform_event_t* event)
+{
+    if (_PLATFORM_EXCHANGE32(&event->state, 1) == 2) { platform_futex_wake(&event->state, 1); }
+}
+
+inline static void platform_event_wait(platform_event_t* event)
+{
+    uint32_t state = 0;
+    while (!platform_event_is_set(event))
+    {
+        /* announce the waiter, the set wakes everybody up */
+        if (_platform_cas32(&event->state, &state, 2) || state == 2) { platform_futex_wait(&event->state, 2); }
+        state = 0;
+    }
+}
+
+/* reader-writer lock */
+#define _PLATFORM_RW_WRITER  0x40000000u
+#define _PLATFORM_RW_WAITING 0x80000000u /* somebody sleeps, unlocks have to wake */
+#define _PLATFORM_RW_READERS 0x3FFFFFFFu
+
+typedef struct platform_rwlock_t { uint32_t state; } platform_rwlock_t;
+
+/* sleeps until the state changes, returns the new state */
+inline static uint32_t _platform_rwlock_sleep(platform_rwlock_t* lock, uint32_t state)
+{
+    if ((state & _PLATFORM_RW_WAITING) || _platform_cas32(&lock->state, &state, state | _PLATFORM_RW_WAITING))
+    {
+        platform_futex_wait(&lock->state, state | _PLATFORM_RW_WAITING);
+        state = _PLATFORM_LOAD32(&lock->state);
+    }
+    return state;
+}
+
+inline static void platform_rwlock_read_lock(platform_rwlock_t* lock)
+{
+    uint32_t state = _PLATFORM_LOAD32(&lock->state);
+    for (int spins = 0;; spins++)
+    {
+        if (!(state & _PLATFORM_RW_WRITER))
+        {
+            if (_platform_cas32(&lock->state, &state, state + 1)) { return; }
+        }
+        else if (spins < PLATFORM_SPIN_COUNT) { platform_cpu_relax(); state = _PLATFORM_LOAD32(&lock->state); }
+        else                                  { state = _platform_rwlock_sleep(lock, state); }
+    }
+}
+
+inline static void platform_rwlock_read_unlock(platform_rwlock_t* lock)
+{
+    uint32_t prev = _PLATFORM_ADD32(&lock->state, (uint32_t) -1);
+    if (prev == (_PLATFORM_RW_WAITING | 1))
+    {
+        /* last reader out: clear the flag & wake, unless somebody else took the lock (keeps the flag) */
+        uint32_t expected = _PLATFORM_RW_WAITING;
+        if (_platform_cas32(&lock->state, &expected, 0)) { platform_futex_wake(&lock->state, 1); }
+    }
+}
+
+inline static void platform_rwlock_write_lock(platform_rwlock_t* lock)
+{
+    uint32_t state = _PLATFORM_LOAD32(&lock->state);
+    for (int spins = 0;; spins++)
+    {
+        if (!(state & (_PLATFORM_RW_WRITER | _PLATFORM_RW_READERS)))
+        {
+            if (_platform_cas32(&lock->state, &state, state | _PLATFORM_RW_WRITER)) { return; }
+        }
+        else if (spins < PLATFORM_SPIN_COUNT) { platform_cpu_relax(); state = _PLATFORM_LOAD32(&lock->state); }
+        else                                  { state = _platform_rwlock_sleep(lock, state); }
+    }
+}
+
+inline static void platform_rwlock_write_unlock(platform_rwlock_t* lock)
+{
+    if (_PLATFORM_EXCHANGE32(&lock->state, 0) & _PLATFORM_RW_WAITING) { platform_futex_wake(&lock->state, 1); }
+}
+
+/* spinlock */
+typedef struct platform_spinlock_t { uint32_t locked; } platform_spinlock_t;
+
+inline static int platform_spinlock_trylock(platform_spinlock_t* lock)
+{
+    return _PLATFORM_EXCHANGE32(&lock->locked, 1) == 0;
+}
+
+inline static void platform_spinlock_lock(platform_spinlock_t* lock)
+{
+    uint32_t backoff = 1;
+    while (!platform_spinlock_trylock(lock))
+    {
+        /* wait for the lock to look free (read only, keeps the cache line shared) */
+        while (_PLATFORM_LOAD32(&lock->locked))
+        {
+            for (uint32_t i = 0; i < backoff; i++) { platform_cpu_relax(); }
+            if (backoff < PLATFORM_BACKOFF_MAX) { backoff <<= 1; }
+            else                                { platform_yield(); }
+        }
+    }
+}
+
+inline static void platform_spinlock_unlock(platform_spinlock_t* lock) { _PLATFORM_STORE32(&lock->locked, 0); }
+
+/* cpu info: runtime detection of instruction set extensions (cpuid on x86,
+ * hwcaps on arm), core counts, smt siblings, cache sizes & numa nodes (from
+ * /sys on linux, GetLogicalProcessorInformationEx on windows, sysctl on macOS).
+ * Detected once on the first call to platform_cpu_info() (per translation unit).
+ *
+ * NOTE: cpus above PLATFORM_MAX_CPUS are counted, but have no topology entries
+ */
+#if defined(COMPILER_GCC) || defined(COMPILER_CLANG) || defined(COMPILER_MINGW)
+    #if defined(ARCH_X64) || defined(ARCH_X86)
+        #include <cpuid.h>
+    #endif
+#endif
+#if defined(PLATFORM_LINUX) && (defined(ARCH_ARM64) || defined(ARCH_ARM))
+    #include <sys/auxv.h> /* for getauxval */
+#endif
+#if defined(PLATFORM_MACOS)
+    #include <sys/sysctl.h>
+#endif
+
+#ifndef PLATFORM_MAX_CPUS
+  #define PLATFORM_MAX_CPUS 256
+#endif
+
+#define PLATFORM_CPU_FEATURES(X)  \
+    X(SSE2)     X(SSE3)     X(SSSE3)    X(SSE41)    X(SSE42)  X(POPCNT) \
+    X(AVX)      X(AVX2)     X(FMA)      X(BMI1)     X(BMI2)   X(F16C)   \
+    X(AVX512F)  X(AVX512BW) X(AVX512VL) X(AVX512DQ)                     \
+    X(NEON)     X(SVE)      X(CRC32)
+#define PLATFORM_CPU_FEATURE_ENUM(name) PLATFORM_CPU_FEATURE_##name,
+typedef enum platform_cpu_feature_e { PLATFORM_CPU_FEATURES(PLATFORM_CPU_FEATURE_ENUM) PLATFORM_CPU_FEATURE_COUNT } platform_cpu_feature_e;
+#undef PLATFORM_CPU_FEATURE_ENUM
+
+typedef struct platform_cpu_info_t
+{
+    uint64_t features;                      /* bit per platform_cpu_feature_e, see platform_cpu_has() */
+    uint32_t logical_cores;                 /* online hardware threads */
+    uint32_t physical_cores;
+    uint32_t threads_per_core;              /* smt, e.g. 2 with hyperthreading */
+    uint32_t numa_nodes;
+    uint32_t cache_line;                    /* bytes */
+    uint32_t l1d_size;                      /* bytes, per core */
+    uint32_t l2_size;                       /* bytes, usually per core */
+    uint32_t l3_size;                       /* bytes, usually shared, 0 if there is none */
+    uint16_t core_of_cpu[PLATFORM_MAX_CPUS]; /* physical core index of a logical cpu, same index: smt siblings */
+    uint8_t  node_of_cpu[PLATFORM_MAX_CPUS]; /* numa node of a logical cpu */
+} platform_cpu_info_t;
+
+#if defined(ARCH_X64) || defined(ARCH_X86)
+inline static void _platform_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+  #if defined(COMPILER_MSVC)
+    __cpuidex((int*) regs, (int) leaf, (int) subleaf);
+  #else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+  #endif
+}
+
+inline static uint64_t _platform_xgetbv()
+{
+  #if defined(COMPILER_MSVC)
+    return _xgetbv(0);
+  #else
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t) hi << 32) | lo;
+  #endif
+}
+#endif
+
+inline static uint64_t _platform_detect_features()
+{
+    uint64_t features = 0;
+#define _PLATFORM_FEATURE(name, cond) if (cond) { features |= 1ull << PLATFORM_CPU_FEATURE_##name; }
+#if defined(ARCH_X64) || defined(ARCH_X86)
+    uint32_t r[4], max_leaf;
+    _platform_cpuid(0, 0, r);
+    max_leaf = r[0];
+    _platform_cpuid(1, 0, r);
+    uint32_t ecx1 = r[2], edx1 = r[3];
+    /* avx & avx-512 registers also need os support (saved on context switches) */
+    int os_avx    = ((ecx1 >> 27) & 1) && ((_platform_xgetbv() & 0x06) == 0x06);
+    int os_avx512 = os_avx && ((_platform_xgetbv() & 0xE0) == 0xE0);
+    _PLATFORM_FEATURE(SSE2,   (edx1 >> 26) & 1);
+    _PLATFORM_FEATURE(SSE3,   (ecx1 >>  0) & 1);
+    _PLATFORM_FEATURE(SSSE3,  (ecx1 >>  9) & 1);
+    _PLATFORM_FEATURE(SSE41,  (ecx1 >> 19) & 1);
+    _PLATFORM_FEATURE(SSE42,  (ecx1 >> 20) & 1);
+    _PLATFORM_FEATURE(CRC32,  (ecx1 >> 20) & 1); /* part of sse4.2 */
+    _PLATFORM_FEATURE(POPCNT, (ecx1 >> 23) & 1);
+    _PLATFORM_FEATURE(AVX,    os_avx && ((ecx1 >> 28) & 1));
+    _PLATFORM_FEATURE(FMA,    os_avx && ((ecx1 >> 12) & 1));
+    _PLATFORM_FEATURE(F16C,   os_avx && ((ecx1 >> 29) & 1));
+    if (max_leaf >= 7)
+    {
+        _platform_cpuid(7, 0, r);
+        uint32_t ebx7 = r[1];
+        _PLATFORM_FEATURE(AVX2,     os_avx    && ((ebx7 >>  5) & 1));
+        _PLATFORM_FEATURE(BMI1,     (ebx7 >> 3) & 1);
+        _PLATFORM_FEATURE(BMI2,     (ebx7 >> 8) & 1);
+        _PLATFORM_FEATURE(AVX512F,  os_avx512 && ((ebx7 >> 16) & 1));
+        _PLATFORM_FEATURE(AVX512DQ, os_avx512 && ((ebx7 >> 17) & 1));
+        _PLATFORM_FEATURE(AVX512BW, os_avx512 && ((ebx7 >> 30) & 1));
+        _PLATFORM_FEATURE(AVX512VL, os_avx512 && ((ebx7 >> 31) & 1));
+    }
+#elif defined(ARCH_ARM64)
+    _PLATFORM_FEATURE(NEON, 1); /* mandatory on aarch64 */
+  #if defined(PLATFORM_LINUX)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    _PLATFORM_FEATURE(CRC32, (hwcap >> 7)  & 1); /* HWCAP_CRC32 */
+    _PLATFORM_FEATURE(SVE,   (hwcap >> 22) & 1); /* HWCAP_SVE */
+  #elif defined(PLATFORM_WIN32)
+    _PLATFORM_FEATURE(CRC32, IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE));
+  #elif defined(PLATFORM_MACOS)
+    _PLATFORM_FEATURE(CRC32, 1); /* all apple silicon */
+  #endif
+#elif defined(ARCH_ARM) && defined(PLATFORM_LINUX)
+    _PLATFORM_FEATURE(NEON, (getauxval(AT_HWCAP) >> 12) & 1); /* HWCAP_NEON */
+#endif
+#undef _PLATFORM_FEATURE
+    return features;
+}
+
+#if defined(PLATFORM_LINUX)
+/* reads a number from a /sys file, understands K/M suffixes (cache sizes), returns 0 on failure */
+inline static uint64_t _platform_read_sys(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) { return 0; }
+    unsigned long long value = 0;
+    char suffix = 0;
+    int read = fscanf(f, "%llu%c", &value, &suffix);
+    fclose(f);
+    if (read < 1) { return 0; }
+    if (suffix == 'K') { value *= 1024; }
+    if (suffix == 'M') { value *= 1024 * 1024; }
+    return value;
+}
+#endif
+
+inline static void _platform_detect_topology(platform_cpu_info_t* info)
+{
+    char path[128];
+#if defined(PLATFORM_LINUX)
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    info->logical_cores = (online > 0) ? (uint32_t) online : 1;
+
+    /* physical cores: distinct (package, core) pairs */
+    uint32_t core_keys[PLATFORM_MAX_CPUS];
+    uint32_t cpus = (info->logical_cores < PLATFORM_MAX_CPUS) ? info->logical_cores : PLATFORM_MAX_CPUS;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        uint32_t core = (uint32_t) _platform_read_sys(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        uint32_t key = ((uint32_t) _platform_read_sys(path) << 16) | (core & 0xFFFF);
+        uint32_t idx = 0;
+        while (idx < info->physical_cores && core_keys[idx] != key) { idx++; }
+        if (idx == info->physical_cores) { core_keys[info->physical_cores++] = key; }
+        info->core_of_cpu[cpu] = (uint16_t) idx;
+    }
+
+    /* caches of cpu0: indexN/{level,type,size,coherency_line_size} */
+    for (int i = 0; i < 8; i++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        FILE* f = fopen(path, "r");
+        if (!f) { break; }
+        char type[16] = {0};
+        int read = fscanf(f, "%15s", type);
+        fclose(f);
+        if (read != 1 || type[0] == 'I') { continue; } /* skip instruction caches */
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        uint64_t level = _platform_read_sys(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        uint32_t size  = (uint32_t) _platform_read_sys(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", i);
+        if (level == 1) { info->l1d_size = size; info->cache_line = (uint32_t) _platform_read_sys(path); }
+        if (level == 2) { info->l2_size  = size; }
+        if (level == 3) { info->l3_size  = size; }
+    }
+
+    /* numa: nodeN/cpulist, e.g. "0-3,8-11" */
+    for (uint32_t node = 0; node < 256; node++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        FILE* f = fopen(path, "r");
+        if (!f) { break; }
+        info->numa_nodes++;
+        unsigned int first, last;
+        char sep = ',';
+        while (sep == ',' && fscanf(f, "%u", &first) == 1)
+        {
+            last = first;
+            if (fscanf(f, "%c", &sep) == 1 && sep == '-') { if (fscanf(f, "%u%c", &last, &sep) < 1) { sep = 0; } }
+            for (unsigned int cpu = first; cpu <= last && cpu < PLATFORM_MAX_CPUS; cpu++) { info->node_of_cpu[cpu] = (uint8_t) node; }
+        }
+        fclose(f);
+    }
+#elif defined(PLATFORM_WIN32)
+    (void) path;
+    DWORD size = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &size);
+    char* buffer = (char*) HeapAlloc(GetProcessHeap(), 0, size);
+    if (buffer && GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) buffer, &size))
+    {
+        for (DWORD offset = 0; offset < size;)
+        {
+            PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX entry = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) (buffer + offset);
+            if (entry->Relationship == RelationProcessorCore)
+            {
+                /* NOTE: only processor group 0 (first 64 cpus) */
+                for (uint32_t cpu = 0; cpu < 64 && cpu < PLATFORM_MAX_CPUS; cpu++)
+                {
+                    if ((entry->Processor.GroupMask[0].Mask >> cpu) & 1) { info->core_of_cpu[cpu] = (uint16_t) info->physical_cores; info->logical_cores++; }
+                }
+                info->physical_cores++;
+            }
+            else if (entry->Relationship == RelationCache && entry->Cache.Type != CacheInstruction)
+            {
+                if (entry->Cache.Level == 1) { info->l1d_size = entry->Cache.CacheSize; info->cache_line = entry->Cache.LineSize; }
+                if (entry->Cache.Level == 2) { info->l2_size  = entry->Cache.CacheSize; }
+                if (entry->Cache.Level == 3) { info->l3_size  = entry->Cache.CacheSize; }
+            }
+            else if (entry->Relationship == RelationNumaNode)
+            {
+                for (uint32_t cpu = 0; cpu < 64 && cpu < PLATFORM_MAX_CPUS; cpu++)
+                {
+                    if ((entry->NumaNode.GroupMask.Mask >> cpu) & 1) { info->node_of_cpu[cpu] = (uint8_t) entry->NumaNode.NodeNumber; }
+                }
+                info->numa_nodes++;
+            }
+            offset += entry->Size;
+        }
+    }
+    if (buffer) { HeapFree(GetProcessHeap(), 0, buffer); }
+#elif defined(PLATFORM_MACOS)
+    (void) path;
+    /* NOTE: untested */
+    uint64_t value = 0; size_t len = sizeof(value);
+    int32_t  count = 0; size_t count_len = sizeof(count);
+    if (sysctlbyname("hw.logicalcpu",  &count, &count_len, NULL, 0) == 0) { info->logical_cores  = (uint32_t) count; }
+    if (sysctlbyname("hw.physicalcpu", &count, &count_len, NULL, 0) == 0) { info->physical_cores = (uint32_t) count; }
+    if (sysctlbyname("hw.cachelinesize", &value, &len, NULL, 0) == 0)     { info->cache_line     = (uint32_t) value; }
+    if (sysctlbyname("hw.l1dcachesize",  &value, &len, NULL, 0) == 0)     { info->l1d_size       = (uint32_t) value; }
+    if (sysctlbyname("hw.l2cachesize",   &value, &len, NULL, 0) == 0)     { info->l2_size        = (uint32_t) value; }
+    if (sysctlbyname("hw.l3cachesize",   &value, &len, NULL, 0) == 0)     { info->l3_size        = (uint32_t) value; }
+    uint32_t smt = (info->physical_cores && info->logical_cores > info->physical_cores) ? info->logical_cores / info->physical_cores : 1;
+    for (uint32_t cpu = 0; cpu < info->logical_cores && cpu < PLATFORM_MAX_CPUS; cpu++) { info->core_of_cpu[cpu] = (uint16_t) (cpu / smt); }
+#else
+    (void) path;
+#endif
+}
+
+inline static const platform_cpu_info_t* platform_cpu_info()
+{
+    static platform_cpu_info_t info;
+    static uint32_t state = 0; /* 0: not detected, 1: detecting, 2: done */
+    uint32_t expected = 0;
+    if (_PLATFORM_LOAD32(&state) == 2) { return &info; }
+    if (_platform_cas32(&state, &expected, 1))
+    {
+        info.features = _platform_detect_features();
+        _platform_detect_topology(&info);
+        if (!info.logical_cores)  { info.logical_cores  = 1; }
+        if (!info.physical_cores) { info.physical_cores = info.logical_cores; }
+        if (!info.numa_nodes)     { info.numa_nodes     = 1; }
+        if (!info.cache_line)     { info.cache_line     = 64; }
+        info.threads_per_core = (info.logical_cores + info.physical_cores - 1) / info.physical_cores;
+        _PLATFORM_STORE32(&state, 2);
+    }
+    while (_PLATFORM_LOAD32(&state) != 2) { platform_yield(); } /* another thread is detecting */
+    return &info;
+}
+
+inline static int platform_cpu_has(platform_cpu_feature_e feature) { return (platform_cpu_info()->features >> feature) & 1; }
+
+inline static const char* platform_cpu_feature_string(platform_cpu_feature_e feature)
+{
+#define PLATFORM_CPU_FEATURE_STRING(name) case PLATFORM_CPU_FEATURE_##name: { return #name; }
+    switch (feature)
+    {
+        PLATFORM_CPU_FEATURES(PLATFORM_CPU_FEATURE_STRING)
+        default: { return "UNKNOWN"; }
+    }
+#undef PLATFORM_CPU_FEATURE_STRING
+}
+
+/* runtime simd dispatch: kernels for instruction sets the compiler wasn't told
+ * to target (no -mavx2) can still be compiled with SIMD_TARGET_{SSE42|AVX2|AVX512}
+ * (x86 only, needs SIMD_DISPATCH_X86) and are picked at runtime, so one binary
+ * runs on old & new cpus. SIMD_DISPATCH() declares a function pointer that starts
+ * out at a resolver, the first call picks an implementation & patches the pointer:
+ *
+ *     static u64 sum_scalar(const u8* p, u64 n) { ... }
+ *     SIMD_TARGET_AVX2 static u64 sum_avx2(const u8* p, u64 n) { ... }
+ *
+ *     SIMD_DISPATCH(u64, sum, (const u8* p, u64 n), (p, n)) // body picks by level
+ *     {
+ *         #if defined(SIMD_DISPATCH_X86)
+ *         if (level >= PLATFORM_SIMD_AVX2) { return sum_avx2; }
+ *         #endif
+ *         return sum_scalar;
+ *     }
+ *     u64 total = sum(data, count); // indirect call, resolved on first use
+ *     sum_select(PLATFORM_SIMD_SCALAR)(data, count); // a specific level, e.g. for tests
+ *
+ * NOTE: not using ifunc on linux, resolvers run before relocations & couldn't
+ * call platform_cpu_info()
+ */
+typedef enum platform_simd_e
+{
+    PLATFORM_SIMD_SCALAR,
+    PLATFORM_SIMD_SSE2,
+    PLATFORM_SIMD_SSE42,  /* + popcnt */
+    PLATFORM_SIMD_AVX2,   /* + bmi1, bmi2, fma */
+    PLATFORM_SIMD_AVX512, /* f, bw, vl, dq */
+    PLATFORM_SIMD_NEON,
+    PLATFORM_SIMD_COUNT,
+} platform_simd_e;
+
+#if !defined(COMPILER_TCC) && (defined(ARCH_X64) || defined(ARCH_X86))
+    #define SIMD_DISPATCH_X86
+    #if defined(COMPILER_MSVC) /* msvc emits any intrinsic without flags */
+        #define SIMD_TARGET_SSE42
+        #define SIMD_TARGET_AVX2
+        #define SIMD_TARGET_AVX512
+    #else
+        #define SIMD_TARGET_SSE42  __attribute__((target("sse4.2,popcnt")))
+        #define SIMD_TARGET_AVX2   __attribute__((target("avx2,bmi,bmi2,fma,popcnt")))
+        #define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx2,bmi,bmi2,fma,popcnt")))
+    #endif
+#endif
+
+/* best simd level the cpu supports (never below what the binary was compiled for) */
+inline static platform_simd_e platform_simd_level()
+{
+    platform_simd_e level = PLATFORM_SIMD_SCALAR;
+#if defined(SIMD_DISPATCH_X86)
+    #define _PLATFORM_HAS(f) platform_cpu_has(PLATFORM_CPU_FEATURE_##f)
+    if (_PLATFORM_HAS(SSE2))                                                      { level = PLATFORM_SIMD_SSE2;   }
+    if (level == PLATFORM_SIMD_SSE2  && _PLATFORM_HAS(SSE42) && _PLATFORM_HAS(POPCNT)) { level = PLATFORM_SIMD_SSE42;  }
+    if (level == PLATFORM_SIMD_SSE42 && _PLATFORM_HAS(AVX2) && _PLATFORM_HAS(BMI1) &&
+        _PLATFORM_HAS(BMI2) && _PLATFORM_HAS(FMA))                                { level = PLATFORM_SIMD_AVX2;   }
+    if (level == PLATFORM_SIMD_AVX2  && _PLATFORM_HAS(AVX512F) && _PLATFORM_HAS(AVX512BW) &&
+        _PLATFORM_HAS(AVX512VL) && _PLATFORM_HAS(AVX512DQ))                      { level = PLATFORM_SIMD_AVX512; }
+    #undef _PLATFORM_HAS
+    #if defined(SIMD_SSE2)
+    if (level < PLATFORM_SIMD_SSE2)  { level = PLATFORM_SIMD_SSE2;  }
+    #endif
+    #if defined(SIMD_SSE42)
+    if (level < PLATFORM_SIMD_SSE42) { level = PLATFORM_SIMD_SSE42; }
+    #endif
+    #if defined(SIMD_AVX2)
+    if (level < PLATFORM_SIMD_AVX2)  { level = PLATFORM_SIMD_AVX2;  }
+    #endif
+#elif defined(SIMD_NEON)
+    level = PLATFORM_SIMD_NEON; /* mandatory on aarch64, nothing to dispatch */
+#elif defined(SIMD_SSE2)
+    level = PLATFORM_SIMD_SSE2;
+#endif
+    return level;
+}
+
+inline static const char* platform_simd_string(platform_simd_e level)
+{
+    switch (level)
+    {
+        case PLATFORM_SIMD_SCALAR: { return "SCALAR"; }
+        case PLATFORM_SIMD_SSE2:   { return "SSE2";   }
+        case PLATFORM_SIMD_SSE42:  { return "SSE4.2"; }
+        case PLATFORM_SIMD_AVX2:   { return "AVX2";   }
+        case PLATFORM_SIMD_AVX512: { return "AVX-512"; }
+        case PLATFORM_SIMD_NEON:   { return "NEON";   }
+        default:                   { return "Invalid"; }
+    }
+}
+
+#if defined(COMPILER_MSVC)
+  #define _PLATFORM_LOAD_FUNC(type, ptr)        (*(type volatile*) (ptr))
+  #define _PLATFORM_STORE_FUNC(type, ptr, func) (*(type volatile*) (ptr) = (func))
+#else
+  #define _PLATFORM_LOAD_FUNC(type, ptr)        __atomic_load_n((ptr), __ATOMIC_RELAXED)
+  #define _PLATFORM_STORE_FUNC(type, ptr, func) __atomic_store_n((ptr), (func), __ATOMIC_RELAXED)
+#endif
+
+/* declares `ret name params` & `name_select(level)`, the body of which must return
+ * an implementation for the given level. Racing first calls all pick the same one. */
+#define SIMD_DISPATCH(ret, name, params, args)                                                      \
+    typedef ret (*name##_func_t) params;                                                            \
+    static name##_func_t name##_select(platform_simd_e level);                                      \
+    static ret name##_resolve params;                                                               \
+    static name##_func_t name##_impl = name##_resolve;                                              \
+    inline static ret name params { return _PLATFORM_LOAD_FUNC(name##_func_t, &name##_impl) args; } \
+    static ret name##_resolve params                                                                \
+    {                                                                                               \
+        name##_func_t func = name##_select(platform_simd_level());                                  \
+        _PLATFORM_STORE_FUNC(name##_func_t, &name##_impl, func);                                    \
+        return func args;                                                                           \
+    }                                                                                               \
+    static name##_func_t name##_select(platform_simd_e level)
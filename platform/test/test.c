@@ -1,6 +1,99 @@
 #include "../platform.h"
+#include "../aio.h"
 
 #include <stdio.h>
+#include <string.h> // for strcmp
+
+#if !defined(COMPILER_TCC)
+static thread_local u32 thread_thing = 0;
+#endif
+
+typedef struct test_threads_t
+{
+    platform_mutex_t    mutex;
+    platform_condvar_t  cv;
+    platform_spinlock_t spinlock;
+    platform_rwlock_t   rwlock;
+    platform_event_t    start;
+    u32                 counter;      /* protected by mutex */
+    u32                 spin_counter; /* protected by spinlock */
+    u32                 pair[2];      /* protected by rwlock, always equal */
+    u32                 done;         /* protected by mutex, signaled by cv */
+} test_threads_t;
+
+static void test_thread_func(void* arg)
+{
+    test_threads_t* t = (test_threads_t*) arg;
+    platform_event_wait(&t->start);
+
+#if !defined(COMPILER_TCC)
+    thread_thing = platform_thread_id();
+#endif
+    for (u32 i = 0; i < 10000; i++)
+    {
+        platform_mutex_lock(&t->mutex);
+        t->counter++;
+        platform_mutex_unlock(&t->mutex);
+
+        platform_spinlock_lock(&t->spinlock);
+        t->spin_counter++;
+        platform_spinlock_unlock(&t->spinlock);
+
+        if (i % 4 == 0)
+        {
+            platform_rwlock_write_lock(&t->rwlock);
+            t->pair[0]++; t->pair[1]++;
+            platform_rwlock_write_unlock(&t->rwlock);
+        }
+        else
+        {
+            platform_rwlock_read_lock(&t->rwlock);
+            ASSERT(t->pair[0] == t->pair[1]);
+            platform_rwlock_read_unlock(&t->rwlock);
+        }
+    }
+#if !defined(COMPILER_TCC)
+    ASSERT(thread_thing == platform_thread_id()); /* no other thread touched it */
+#endif
+
+    platform_mutex_lock(&t->mutex);
+    t->done++;
+    platform_condvar_signal(&t->cv);
+    platform_mutex_unlock(&t->mutex);
+}
+
+static u32 test_sum_scalar(const u8* ptr, u32 len)
+{
+    u32 sum = 0;
+    for (u32 i = 0; i < len; i++) { sum += ptr[i]; }
+    return sum;
+}
+
+#if defined(SIMD_DISPATCH_X86)
+#include <immintrin.h>
+SIMD_TARGET_AVX2 static u32 test_sum_avx2(const u8* ptr, u32 len)
+{
+    __m256i acc = _mm256_setzero_si256();
+    u32 i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*) (ptr + i)), _mm256_setzero_si256()));
+    }
+    u64 sums[4];
+    _mm256_storeu_si256((__m256i*) sums, acc);
+    return (u32) (sums[0] + sums[1] + sums[2] + sums[3]) + test_sum_scalar(ptr + i, len - i);
+}
+#endif
+
+SIMD_DISPATCH(u32, test_sum, (const u8* ptr, u32 len), (ptr, len))
+{
+#if defined(SIMD_DISPATCH_X86)
+    if (level >= PLATFORM_SIMD_AVX2) { return test_sum_avx2; }
+#endif
+    (void) level;
+    return test_sum_scalar;
+}
+
 int main(int argc, char** argv)
 {
     /* TEST PLATFORM DETECTION */
@@ -66,9 +159,29 @@ int main(int argc, char** argv)
 
     /* TEST THREAD STUFF */
     {
-        #if !defined(COMPILER_TCC) // TODO
-        static thread_local u32 thread_thing = 0; // TODO test properly with threads
-        #endif
+        test_threads_t t = {0};
+        platform_thread_t threads[4];
+        platform_thread_desc_t desc = { 256 * 1024, 0 }; /* custom stack size */
+        for (int i = 0; i < 4; i++)
+        {
+            desc.affinity_mask = (i == 0) ? 1 : 0;        /* pin the first one to cpu 0 */
+            ASSERT(platform_thread_create(&threads[i], test_thread_func, &t, &desc));
+        }
+        platform_event_set(&t.start); /* release all threads at once for more contention */
+
+        platform_mutex_lock(&t.mutex);
+        while (t.done < 4) { platform_condvar_wait(&t.cv, &t.mutex); }
+        platform_mutex_unlock(&t.mutex);
+        for (int i = 0; i < 4; i++) { platform_thread_join(&threads[i]); }
+
+        ASSERT(t.counter      == 4 * 10000);
+        ASSERT(t.spin_counter == 4 * 10000);
+        ASSERT(t.pair[0]      == 4 * 2500 && t.pair[1] == t.pair[0]);
+        ASSERT(platform_event_is_set(&t.start));
+        platform_event_reset(&t.start);
+        ASSERT(!platform_event_is_set(&t.start));
+        ASSERT(platform_mutex_trylock(&t.mutex) && !platform_mutex_trylock(&t.mutex));
+        platform_mutex_unlock(&t.mutex);
     }
 
     /* TEST MEMORY MACROS */
@@ -93,6 +206,180 @@ int main(int argc, char** argv)
         #endif
     }
 
+    /* TEST TIMERS */
+    {
+        /* monotonic clock & cycle counter only move forward */
+        u64 t0 = platform_time_ns();
+        u64 c0 = platform_cycles();
+        u64 t1 = platform_time_ns();
+        u64 c1 = platform_cycles_serialized();
+        ASSERT(t1 >= t0);
+        ASSERT(c1 >= c0);
+
+        /* calibrated frequency agrees with the clock (generous bounds for loaded machines) */
+        u64 freq = platform_cycles_per_sec();
+        ASSERT(freq > 0);
+        t0 = platform_time_ns();
+        c0 = platform_cycles();
+        platform_sleep_ns(20000000ull);
+        c1 = platform_cycles();
+        t1 = platform_time_ns();
+        ASSERT(t1 - t0 >= 20000000ull);
+        f64 measured = (f64) (c1 - c0) * 1e9 / (f64) (t1 - t0);
+        ASSERT(measured > (f64) freq * 0.5 && measured < (f64) freq * 1.5);
+
+        /* sleep_until never wakes up early, short sleeps only spin */
+        u64 deadline = platform_time_ns() + 1000000ull;
+        platform_sleep_until_ns(deadline);
+        ASSERT(platform_time_ns() >= deadline);
+        deadline = platform_time_ns() + 1000ull;
+        platform_sleep_until_ns(deadline);
+        ASSERT(platform_time_ns() >= deadline);
+        platform_sleep_until_ns(0); /* deadline in the past returns right away */
+        platform_cpu_relax();
+        platform_yield();
+    }
+
+
+    /* TEST CPU INFO */
+    {
+        const platform_cpu_info_t* info = platform_cpu_info();
+        ASSERT(info == platform_cpu_info()); /* detected once */
+        ASSERT(info->logical_cores >= info->physical_cores && info->physical_cores >= 1);
+        ASSERT(info->threads_per_core >= 1 && info->numa_nodes >= 1);
+        ASSERT(info->cache_line >= 16 && (info->cache_line & (info->cache_line - 1)) == 0);
+        for (u32 cpu = 0; cpu < info->logical_cores && cpu < PLATFORM_MAX_CPUS; cpu++)
+        {
+            ASSERT(info->core_of_cpu[cpu] < info->physical_cores);
+            ASSERT(info->node_of_cpu[cpu] < info->numa_nodes);
+        }
+        #if defined(ARCH_X64)
+        ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_SSE2)); /* baseline for x86-64 */
+        #elif defined(ARCH_ARM64)
+        ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_NEON));
+        #endif
+        #if defined(__AVX2__)
+        ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_AVX2)); /* compiled with -mavx2 & running */
+        #endif
+        if (platform_cpu_has(PLATFORM_CPU_FEATURE_AVX2)) { ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_AVX)); }
+        ASSERT(strcmp(platform_cpu_feature_string(PLATFORM_CPU_FEATURE_AVX512F), "AVX512F") == 0);
+    }
+
+
+    /* TEST SIMD DISPATCH */
+    {
+        u8 buf[100];
+        for (u32 i = 0; i < sizeof(buf); i++) { buf[i] = (u8) (i * 7); }
+        u32 expected = test_sum_scalar(buf, sizeof(buf));
+        ASSERT(test_sum(buf, sizeof(buf)) == expected); /* resolves */
+        ASSERT(test_sum(buf, sizeof(buf)) == expected); /* already resolved */
+        ASSERT(test_sum_select(PLATFORM_SIMD_SCALAR) == test_sum_scalar);
+        ASSERT(test_sum_select(platform_simd_level())(buf, 33) == test_sum_scalar(buf, 33));
+        #if defined(SIMD_AVX2)
+        ASSERT(platform_simd_level() >= PLATFORM_SIMD_AVX2); /* never below the compile-time level */
+        #endif
+        if (platform_simd_level() == PLATFORM_SIMD_AVX512) { ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_AVX512BW)); }
+        if (platform_simd_level() >= PLATFORM_SIMD_AVX2)   { ASSERT(platform_cpu_has(PLATFORM_CPU_FEATURE_AVX2)); }
+        ASSERT(strcmp(platform_simd_string(PLATFORM_SIMD_AVX2), "AVX2") == 0);
+    }
+
+
+    /* TEST ASYNC IO */
+    for (u32 backend = 0; backend < 2; backend++) /* io_uring (if available), then the thread pool */
+    {
+        platform_aio_t aio;
+        ASSERT(platform_aio_init(&aio, 16, backend ? PLATFORM_AIO_FORCE_THREADS : 0));
+        if (backend) { ASSERT(aio.backend == PLATFORM_AIO_BACKEND_THREADS); }
+        ASSERT(aio.queue_depth == 16);
+
+        /* page aligned buffers (O_DIRECT) */
+        enum { CHUNK = 4096, CHUNKS = 16 };
+        static u8 storage[(CHUNKS + 2) * CHUNK];
+        u8* data   = (u8*) (((uintptr_t) storage + CHUNK - 1) & ~(uintptr_t) (CHUNK - 1));
+        u8* readback = data + CHUNK; /* last CHUNKS - 1 chunks are reused for reads */
+        for (u32 i = 0; i < CHUNK; i++) { data[i] = (u8) (i * 13 + backend); }
+
+        /* write 16 chunks (all the same), out of order completions matched up by user_data */
+        const char* path = "test_aio.bin";
+        platform_aio_file_t file = platform_aio_open(path, PLATFORM_AIO_OPEN_WRITE);
+        ASSERT(file != PLATFORM_AIO_INVALID_FILE);
+        platform_aio_request_t reqs[CHUNKS];
+        for (u32 i = 0; i < CHUNKS; i++) { reqs[i] = platform_aio_write(file, data, CHUNK, (u64) i * CHUNK, 100 + i); }
+        ASSERT(platform_aio_submit(&aio, reqs, CHUNKS) == CHUNKS);
+        ASSERT(platform_aio_submit(&aio, reqs, 1) == 0); /* queue depth reached */
+        platform_aio_completion_t done[CHUNKS];
+        u32 seen = 0;
+        for (u32 n = 0; n < CHUNKS;)
+        {
+            u32 got = platform_aio_wait(&aio, done, CHUNKS, 1);
+            ASSERT(got >= 1);
+            for (u32 j = 0; j < got; j++)
+            {
+                ASSERT(done[j].result == CHUNK && done[j].user_data >= 100 && done[j].user_data < 100 + CHUNKS);
+                seen |= 1u << (done[j].user_data - 100);
+            }
+            n += got;
+        }
+        ASSERT(seen == 0xFFFF && aio.in_flight == 0);
+        ASSERT(platform_aio_poll(&aio, done, CHUNKS) == 0);
+        platform_aio_close(file);
+
+        /* read back: full chunks, a short read at the end of the file & a bad file */
+        file = platform_aio_open(path, 0);
+        ASSERT(file != PLATFORM_AIO_INVALID_FILE);
+        u32 count = 0;
+        for (u32 i = 0; i < CHUNKS - 3; i++) { reqs[count++] = platform_aio_read(file, readback + i * CHUNK, CHUNK, (u64) i * CHUNK, i); }
+        reqs[count] = platform_aio_read(file, readback + count * CHUNK, CHUNK, CHUNKS * CHUNK - 100, 1000); count++;
+        reqs[count++] = platform_aio_read(PLATFORM_AIO_INVALID_FILE, readback, CHUNK, 0, 2000);
+        ASSERT(platform_aio_submit(&aio, reqs, count) == count);
+        u32 n = 0;
+        while (n < count) { n += platform_aio_wait(&aio, done + n, count - n, count - n); }
+        for (u32 j = 0; j < count; j++)
+        {
+            if      (done[j].user_data == 1000) { ASSERT(done[j].result == 100); }
+            else if (done[j].user_data == 2000) { ASSERT(done[j].result < 0);    }
+            else                                { ASSERT(done[j].result == CHUNK); }
+        }
+        for (u32 i = 0; i < CHUNKS - 3; i++) { ASSERT(memcmp(readback + i * CHUNK, data, CHUNK) == 0); }
+
+        /* registered buffers */
+        void* buffers[1] = { readback };
+        u64   sizes[1]   = { CHUNK };
+        if (platform_aio_register_buffers(&aio, buffers, sizes, 1))
+        {
+            memset(readback, 0, CHUNK);
+            reqs[0] = platform_aio_read(file, readback, CHUNK, CHUNK, 7);
+            reqs[0].buffer_index = 0;
+            ASSERT(platform_aio_submit(&aio, reqs, 1) == 1);
+            ASSERT(platform_aio_wait(&aio, done, 1, 1) == 1 && done[0].user_data == 7 && done[0].result == CHUNK);
+            ASSERT(memcmp(readback, data, CHUNK) == 0);
+        }
+        platform_aio_close(file);
+
+        /* O_DIRECT (not every filesystem supports it, e.g. tmpfs) */
+        file = platform_aio_open(path, PLATFORM_AIO_OPEN_DIRECT);
+        if (file != PLATFORM_AIO_INVALID_FILE)
+        {
+            memset(readback, 0, CHUNK);
+            reqs[0] = platform_aio_read(file, readback, CHUNK, 2 * CHUNK, 8);
+            ASSERT(platform_aio_submit(&aio, reqs, 1) == 1);
+            ASSERT(platform_aio_wait(&aio, done, 1, 1) == 1);
+            ASSERT(done[0].result == CHUNK && memcmp(readback, data, CHUNK) == 0);
+            platform_aio_close(file);
+        }
+
+        /* destroy waits for the requests still in flight */
+        file = platform_aio_open(path, 0);
+        memset(readback, 0, CHUNKS * CHUNK);
+        for (u32 i = 0; i < CHUNKS; i++) { reqs[i] = platform_aio_read(file, readback + i * CHUNK, CHUNK, (u64) i * CHUNK, i); }
+        ASSERT(platform_aio_submit(&aio, reqs, CHUNKS) == CHUNKS);
+        platform_aio_destroy(&aio);
+        ASSERT(aio.in_flight == 0);
+        for (u32 i = 0; i < CHUNKS; i++) { ASSERT(memcmp(readback + i * CHUNK, data, CHUNK) == 0); }
+        platform_aio_close(file);
+        remove(path);
+    }
+
     return 0;
 }
 
@@ -0,0 +1,211 @@
+#pragma once
+
+/* scoped profiler: zones record begin & end timestamps (cpu ticks, e.g. rdtsc)
+ * into a ring buffer per thread, profile_dump_chrome() writes them out as a
+ * Chrome trace (load it in chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Zones nest. A thread's ring buffer gets allocated when it records its first
+ * event and is never freed, so threads that already exited still show up in
+ * the dump. When the ring buffer is full, the oldest events get overwritten.
+ * Ticks are converted to time by comparing them against the monotonic clock
+ * between the first recorded event and the dump (no startup calibration).
+ *
+ * The macros compile to nothing unless ENABLE_PROFILING is defined.
+ *
+ * NOTE: returning or breaking out of a PROFILE_SCOPE block skips its end
+ * event (it is a for-loop, see scoped_begin_end in macros.h), use
+ * PROFILE_BEGIN/PROFILE_END or PROFILE_FUNCTION (C++) in that case.
+ * NOTE: dump while no other thread records, e.g. between frames or at exit
+ */
+
+/* Example usage code:
+
+       void update()
+       {
+           PROFILE_SCOPE("physics") { physics_step(); }
+           PROFILE_SCOPE("render")
+           {
+               PROFILE_SCOPE("cull") { cull(); }
+               draw();
+           }
+       }
+       ...
+       FILE* trace = fopen("trace.json", "wb");
+       profile_dump_chrome(trace);
+       fclose(trace);
+*/
+
+#ifndef PROFILE_RING_SIZE
+  #define PROFILE_RING_SIZE (1 << 16) /* events per thread (16 bytes each), has to be a power of 2 */
+#endif
+
+typedef struct profile_event_t
+{
+    u64         ticks;
+    const char* name;  /* NULL for end events */
+} profile_event_t;
+
+typedef struct profile_thread_t profile_thread_t;
+struct profile_thread_t
+{
+    profile_thread_t* next;
+    const char*       name;
+    u32               id;
+    u64               head;  /* nr of events written so far */
+    profile_event_t   events[PROFILE_RING_SIZE];
+};
+
+/* api */
+void              profile_thread_name (const char* name); /* shows up in the trace, string has to outlive the dump */
+u64               profile_dump_chrome (FILE* out);        /* returns the nr of events written */
+void              profile_clear       (void);             /* drops all recorded events */
+f64               profile_ticks_per_us(void);             /* calibrated against the monotonic clock */
+profile_thread_t* profile_thread      (void);             /* ring buffer of the calling thread */
+
+#if defined(COMPILER_TCC)
+  #define PROFILE_THREAD_LOCAL /* NOTE: no TLS in tcc, only profile a single thread */
+#else
+  #define PROFILE_THREAD_LOCAL thread_local
+#endif
+extern PROFILE_THREAD_LOCAL profile_thread_t* profile_current_thread;
+
+/* cheap timestamp in cpu ticks */
+static inline u64 profile_ticks(void) { return platform_cycles(); }
+
+static inline void profile_record(const char* name)
+{
+    profile_thread_t* t = profile_current_thread;
+    if (!t) { t = profile_thread(); }
+    u64 head = t->head;
+    t->events[head & (PROFILE_RING_SIZE - 1)].ticks = profile_ticks();
+    t->events[head & (PROFILE_RING_SIZE - 1)].name  = name;
+    t->head = head + 1;
+}
+
+static inline void profile_begin(const char* name) { profile_record(name); }
+static inline void profile_end(void)               { profile_record(NULL); }
+
+#if defined(ENABLE_PROFILING)
+  #define PROFILE_BEGIN(name) profile_begin(name)
+  #define PROFILE_END()       profile_end()
+  #define PROFILE_SCOPE(name) scoped_begin_end(profile_begin(name), profile_end())
+  #if defined(LANGUAGE_CPP) && (STANDARD_VERSION >= 2011)
+    #define PROFILE_FUNCTION() profile_begin(__func__); defer(profile_end())
+  #endif
+#else
+  #define PROFILE_BEGIN(name)
+  #define PROFILE_END()
+  #define PROFILE_SCOPE(name)
+  #define PROFILE_FUNCTION()
+#endif
+
+#ifdef BASIC_IMPLEMENTATION
+PROFILE_THREAD_LOCAL profile_thread_t* profile_current_thread = NULL;
+
+static struct
+{
+    platform_mutex_t  lock;
+    profile_thread_t* threads;
+    u32               thread_count;
+    u64               start_ticks;  /* reference point for the calibration */
+    u64               start_ns;
+} profile_state = { { 0 }, NULL, 0, 0, 0 };
+
+profile_thread_t* profile_thread(void)
+{
+    if (profile_current_thread) { return profile_current_thread; }
+
+    profile_thread_t* t = (profile_thread_t*) mem_alloc(sizeof(profile_thread_t));
+    MEM_ASSERT(t);
+    platform_mutex_lock(&profile_state.lock);
+    if (!profile_state.threads)
+    {
+        profile_state.start_ns    = platform_time_ns();
+        profile_state.start_ticks = profile_ticks();
+    }
+    t->id                 = ++profile_state.thread_count;
+    t->next               = profile_state.threads;
+    profile_state.threads = t;
+    platform_mutex_unlock(&profile_state.lock);
+
+    profile_current_thread = t;
+    return t;
+}
+
+void profile_thread_name(const char* name)
+{
+    profile_thread()->name = name;
+}
+
+f64 profile_ticks_per_us(void)
+{
+    /* measure over at least 10ms for a stable result */
+    profile_thread();
+    u64 ns    = platform_time_ns();
+    u64 ticks = profile_ticks();
+    while (ns - profile_state.start_ns < 10000000ull)
+    {
+        ns    = platform_time_ns();
+        ticks = profile_ticks();
+    }
+    return (f64) (ticks - profile_state.start_ticks) * 1000.0 / (f64) (ns - profile_state.start_ns);
+}
+
+void profile_clear(void)
+{
+    platform_mutex_lock(&profile_state.lock);
+    for (profile_thread_t* t = profile_state.threads; t; t = t->next) { t->head = 0; }
+    platform_mutex_unlock(&profile_state.lock);
+}
+
+/* zone names are usually string literals, only escape what would break the json */
+static void profile_write_json_string(FILE* out, const char* str)
+{
+    fputc('"', out);
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')  { fputc('\\', out); fputc(*str, out); }
+        else if ((u8) *str < 0x20)        { fprintf(out, "\\u%04x", (u32) (u8) *str); }
+        else                              { fputc(*str, out); }
+    }
+    fputc('"', out);
+}
+
+u64 profile_dump_chrome(FILE* out)
+{
+    f64 ticks_per_us = profile_ticks_per_us();
+    u64 written      = 0;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    platform_mutex_lock(&profile_state.lock);
+    for (profile_thread_t* t = profile_state.threads; t; t = t->next)
+    {
+        if (t->name)
+        {
+            fprintf(out, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", written ? ",\n" : "", t->id);
+            profile_write_json_string(out, t->name);
+            fprintf(out, "}}");
+            written++;
+        }
+
+        u64 count = (t->head < PROFILE_RING_SIZE) ? t->head : PROFILE_RING_SIZE;
+        u32 depth = 0;
+        for (u64 i = t->head - count; i < t->head; i++)
+        {
+            profile_event_t* e = &t->events[i & (PROFILE_RING_SIZE - 1)];
+            if (!e->name && depth == 0) { continue; } /* its begin event got overwritten */
+            depth += e->name ? 1 : -1;
+
+            /* the tick counters of different cores can be slightly off */
+            f64 ts = (e->ticks > profile_state.start_ticks) ? (f64) (e->ticks - profile_state.start_ticks) / ticks_per_us : 0.0;
+            fprintf(out, "%s{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", written ? ",\n" : "", e->name ? 'B' : 'E', t->id, ts);
+            if (e->name) { fprintf(out, ",\"name\":"); profile_write_json_string(out, e->name); }
+            fputc('}', out);
+            written++;
+        }
+    }
+    platform_mutex_unlock(&profile_state.lock);
+    fprintf(out, "\n]}\n");
+    return written;
+}
+#endif // BASIC_IMPLEMENTATION
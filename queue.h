@@ -0,0 +1,334 @@
+#pragma once
+
+/* lock-free queues for passing messages between threads, none of them
+ * allocates after creation:
+ *
+ * - queue_spsc_t: bounded single-producer/single-consumer ring buffer, wait-free.
+ *   Both sides cache the index of the other side and only reload it when the
+ *   ring looks full (producer) or empty (consumer).
+ * - queue_mpsc_t: unbounded multi-producer/single-consumer intrusive queue
+ *   (Vyukov), embed a queue_node_t in your struct. Pushing is wait-free, a pop
+ *   can return NULL while a producer is halfway through a push.
+ * - queue_mpmc_t: bounded multi-producer/multi-consumer queue (Vyukov), every
+ *   cell has a sequence number, producers & consumers claim positions with a CAS.
+ *
+ * Elements of the bounded queues are copied in & out (elem_size bytes), the
+ * capacity is rounded up to a power of 2. Memory comes from the arena or, if
+ * NULL is passed, from mem_reserve() (released by queue_*_destroy()).
+ * The producer & consumer indices live on separate cache lines.
+ */
+
+/* Example usage code:
+
+       queue_spsc_t* q = queue_spsc_create(1024, sizeof(msg_t), NULL);
+       // producer thread
+       msg_t msg = { ... };
+       while (!queue_spsc_push(q, &msg)) { platform_cpu_relax(); } // full
+       // consumer thread
+       msg_t batch[32];
+       u64 count = queue_spsc_pop_n(q, batch, 32);
+
+       // intrusive mpsc queue
+       typedef struct job_msg_t { queue_node_t node; int payload; } job_msg_t;
+       queue_mpsc_t inbox; queue_mpsc_init(&inbox);
+       queue_mpsc_push(&inbox, &msg->node);                     // any thread
+       queue_node_t* n = queue_mpsc_pop(&inbox);                // one thread
+       job_msg_t* m = container_of(n, job_msg_t, node);
+*/
+
+/* spsc */
+typedef struct queue_spsc_t
+{
+    u64   head;        /* consumer */
+    u64   tail_cache;
+    CACHE_LINE_PAD(2 * sizeof(u64));
+    u64   tail;        /* producer */
+    u64   head_cache;
+    CACHE_LINE_PAD(2 * sizeof(u64));
+    u8*   buffer;
+    u64   mask;
+    u64   elem_size;
+    void* os_base;     /* NULL for arena memory */
+    u64   os_size;
+} queue_spsc_t;
+
+/* mpsc */
+typedef struct queue_node_t { struct queue_node_t* next; } queue_node_t;
+
+typedef struct queue_mpsc_t
+{
+    queue_node_t* head; /* producers push here */
+    CACHE_LINE_PAD(sizeof(queue_node_t*));
+    queue_node_t* tail; /* consumer pops here */
+    queue_node_t  stub;
+} queue_mpsc_t;
+
+/* mpmc */
+typedef struct queue_mpmc_t
+{
+    u64   enqueue_pos;
+    CACHE_LINE_PAD(sizeof(u64));
+    u64   dequeue_pos;
+    CACHE_LINE_PAD(sizeof(u64));
+    u8*   cells;       /* u64 sequence + element */
+    u64   cell_size;
+    u64   mask;
+    u64   elem_size;
+    void* os_base;
+    u64   os_size;
+} queue_mpmc_t;
+
+/* api */
+queue_spsc_t* queue_spsc_create (u64 capacity, u64 elem_size, mem_arena_t* arena); /* NULL arena: from the os, NULL on failure */
+void          queue_spsc_destroy(queue_spsc_t** q);
+b32           queue_spsc_push   (queue_spsc_t* q, const void* elem);            /* 0 if full */
+b32           queue_spsc_pop    (queue_spsc_t* q, void* elem);                  /* 0 if empty */
+u64           queue_spsc_push_n (queue_spsc_t* q, const void* elems, u64 count); /* returns nr pushed */
+u64           queue_spsc_pop_n  (queue_spsc_t* q, void* elems, u64 max);        /* returns nr popped */
+u64           queue_spsc_count  (queue_spsc_t* q);                              /* approximate */
+
+void          queue_mpsc_init   (queue_mpsc_t* q);
+void          queue_mpsc_push   (queue_mpsc_t* q, queue_node_t* node);
+void          queue_mpsc_push_n (queue_mpsc_t* q, queue_node_t* first, queue_node_t* last); /* pre-linked chain */
+queue_node_t* queue_mpsc_pop    (queue_mpsc_t* q);                                          /* NULL if empty */
+b32           queue_mpsc_empty  (queue_mpsc_t* q);
+
+queue_mpmc_t* queue_mpmc_create (u64 capacity, u64 elem_size, mem_arena_t* arena); /* NULL arena: from the os, NULL on failure */
+void          queue_mpmc_destroy(queue_mpmc_t** q);
+b32           queue_mpmc_push   (queue_mpmc_t* q, const void* elem);
+b32           queue_mpmc_pop    (queue_mpmc_t* q, void* elem);
+u64           queue_mpmc_push_n (queue_mpmc_t* q, const void* elems, u64 count);
+u64           queue_mpmc_pop_n  (queue_mpmc_t* q, void* elems, u64 max);
+
+#ifdef BASIC_IMPLEMENTATION
+static u64 queue_round_pow2(u64 v)
+{
+    u64 p = 1;
+    while (p < v) { p <<= 1; }
+    return p;
+}
+
+/* cache line aligned memory from the arena or reserved & committed from the os */
+static void* queue_alloc(mem_arena_t* arena, u64 size, void** os_base, u64* os_size)
+{
+    *os_base = NULL;
+    *os_size = 0;
+    if (arena)
+    {
+        u8* mem = (u8*) mem_arena_push(arena, size + CACHE_LINE_SIZE);
+        return mem ? (void*) NEXT_ALIGN_POW2((uintptr_t) mem, CACHE_LINE_SIZE) : NULL;
+    }
+    void* mem       = mem_reserve(NULL, size);
+    int   committed = mem && mem_commit(mem, size);
+    MEM_ASSERT(committed);
+    if (!committed)
+    {
+        if (mem) { mem_release(mem, size); }
+        return NULL;
+    }
+    *os_base = mem;
+    *os_size = size;
+    return mem; /* page aligned */
+}
+
+queue_spsc_t* queue_spsc_create(u64 capacity, u64 elem_size, mem_arena_t* arena)
+{
+    capacity = queue_round_pow2(capacity);
+    void* os_base; u64 os_size;
+    u64 header       = NEXT_ALIGN_POW2(sizeof(queue_spsc_t), CACHE_LINE_SIZE);
+    queue_spsc_t* q  = (queue_spsc_t*) queue_alloc(arena, header + capacity * elem_size, &os_base, &os_size);
+    if (!q) { return NULL; }
+    memset(q, 0, sizeof(queue_spsc_t));
+    q->buffer        = (u8*) q + header;
+    q->mask          = capacity - 1;
+    q->elem_size     = elem_size;
+    q->os_base       = os_base;
+    q->os_size       = os_size;
+    return q;
+}
+
+void queue_spsc_destroy(queue_spsc_t** q)
+{
+    if ((*q)->os_base) { mem_release((*q)->os_base, (*q)->os_size); }
+    *q = NULL;
+}
+
+u64 queue_spsc_push_n(queue_spsc_t* q, const void* elems, u64 count)
+{
+    u64 tail  = q->tail; /* only written by us */
+    u64 space = (q->mask + 1) - (tail - q->head_cache);
+    if (space < count)
+    {
+        q->head_cache = atomic_load_u64(&q->head, ATOMIC_ACQUIRE);
+        space         = (q->mask + 1) - (tail - q->head_cache);
+        if (space < count) { count = space; }
+    }
+
+    /* copy in at most two parts (wrap around) */
+    u64 idx   = tail & q->mask;
+    u64 first = (count < (q->mask + 1) - idx) ? count : (q->mask + 1) - idx;
+    memcpy(q->buffer + idx * q->elem_size, elems, first * q->elem_size);
+    memcpy(q->buffer, (const u8*) elems + first * q->elem_size, (count - first) * q->elem_size);
+
+    atomic_store_u64(&q->tail, tail + count, ATOMIC_RELEASE);
+    return count;
+}
+
+u64 queue_spsc_pop_n(queue_spsc_t* q, void* elems, u64 max)
+{
+    u64 head      = q->head; /* only written by us */
+    u64 available = q->tail_cache - head;
+    if (available < max)
+    {
+        q->tail_cache = atomic_load_u64(&q->tail, ATOMIC_ACQUIRE);
+        available     = q->tail_cache - head;
+    }
+    u64 count = (available < max) ? available : max;
+
+    u64 idx   = head & q->mask;
+    u64 first = (count < (q->mask + 1) - idx) ? count : (q->mask + 1) - idx;
+    memcpy(elems, q->buffer + idx * q->elem_size, first * q->elem_size);
+    memcpy((u8*) elems + first * q->elem_size, q->buffer, (count - first) * q->elem_size);
+
+    atomic_store_u64(&q->head, head + count, ATOMIC_RELEASE);
+    return count;
+}
+
+b32 queue_spsc_push(queue_spsc_t* q, const void* elem) { return queue_spsc_push_n(q, elem, 1) == 1; }
+b32 queue_spsc_pop (queue_spsc_t* q, void* elem)       { return queue_spsc_pop_n(q, elem, 1) == 1;  }
+
+u64 queue_spsc_count(queue_spsc_t* q)
+{
+    return atomic_load_u64(&q->tail, ATOMIC_ACQUIRE) - atomic_load_u64(&q->head, ATOMIC_ACQUIRE);
+}
+
+/* see https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue */
+void queue_mpsc_init(queue_mpsc_t* q)
+{
+    q->stub.next = NULL;
+    q->head      = &q->stub;
+    q->tail      = &q->stub;
+}
+
+void queue_mpsc_push_n(queue_mpsc_t* q, queue_node_t* first, queue_node_t* last)
+{
+    atomic_store_ptr((void**) &last->next, NULL, ATOMIC_RELAXED);
+    queue_node_t* prev = (queue_node_t*) atomic_exchange_ptr((void**) &q->head, last, ATOMIC_ACQ_REL);
+    /* NOTE: until this store the chain is cut off, the consumer sees an empty queue */
+    atomic_store_ptr((void**) &prev->next, first, ATOMIC_RELEASE);
+}
+
+void queue_mpsc_push(queue_mpsc_t* q, queue_node_t* node) { queue_mpsc_push_n(q, node, node); }
+
+queue_node_t* queue_mpsc_pop(queue_mpsc_t* q)
+{
+    queue_node_t* tail = q->tail;
+    queue_node_t* next = (queue_node_t*) atomic_load_ptr((void**) &tail->next, ATOMIC_ACQUIRE);
+    if (tail == &q->stub)
+    {
+        if (!next) { return NULL; }
+        q->tail = next; /* skip the stub */
+        tail    = next;
+        next    = (queue_node_t*) atomic_load_ptr((void**) &next->next, ATOMIC_ACQUIRE);
+    }
+    if (next) { q->tail = next; return tail; }
+
+    /* tail is the last node: only pop it after putting the stub behind it */
+    if (tail != (queue_node_t*) atomic_load_ptr((void**) &q->head, ATOMIC_ACQUIRE)) { return NULL; } /* push in progress */
+    queue_mpsc_push(q, &q->stub);
+    next = (queue_node_t*) atomic_load_ptr((void**) &tail->next, ATOMIC_ACQUIRE);
+    if (next) { q->tail = next; return tail; }
+    return NULL;
+}
+
+b32 queue_mpsc_empty(queue_mpsc_t* q)
+{
+    return q->tail == (queue_node_t*) atomic_load_ptr((void**) &q->head, ATOMIC_ACQUIRE) && q->tail == &q->stub;
+}
+
+/* see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
+queue_mpmc_t* queue_mpmc_create(u64 capacity, u64 elem_size, mem_arena_t* arena)
+{
+    capacity = queue_round_pow2(capacity < 2 ? 2 : capacity);
+    void* os_base; u64 os_size;
+    u64 header      = NEXT_ALIGN_POW2(sizeof(queue_mpmc_t), CACHE_LINE_SIZE);
+    u64 cell_size   = NEXT_ALIGN_POW2(sizeof(u64) + elem_size, sizeof(u64));
+    queue_mpmc_t* q = (queue_mpmc_t*) queue_alloc(arena, header + capacity * cell_size, &os_base, &os_size);
+    if (!q) { return NULL; }
+    memset(q, 0, sizeof(queue_mpmc_t));
+    q->cells        = (u8*) q + header;
+    q->cell_size    = cell_size;
+    q->mask         = capacity - 1;
+    q->elem_size    = elem_size;
+    q->os_base      = os_base;
+    q->os_size      = os_size;
+    for (u64 i = 0; i < capacity; i++) { *(u64*) (q->cells + i * cell_size) = i; }
+    return q;
+}
+
+void queue_mpmc_destroy(queue_mpmc_t** q)
+{
+    if ((*q)->os_base) { mem_release((*q)->os_base, (*q)->os_size); }
+    *q = NULL;
+}
+
+b32 queue_mpmc_push(queue_mpmc_t* q, const void* elem)
+{
+    u64 pos = atomic_load_u64(&q->enqueue_pos, ATOMIC_RELAXED);
+    for (;;)
+    {
+        u8* cell = q->cells + (pos & q->mask) * q->cell_size;
+        u64 seq  = atomic_load_u64((u64*) cell, ATOMIC_ACQUIRE);
+        i64 diff = (i64) (seq - pos);
+        if (diff == 0)
+        {
+            /* cell is free, try to claim the position */
+            if (atomic_cas_weak_u64(&q->enqueue_pos, &pos, pos + 1, ATOMIC_RELAXED))
+            {
+                memcpy(cell + sizeof(u64), elem, q->elem_size);
+                atomic_store_u64((u64*) cell, pos + 1, ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+        else if (diff < 0) { return 0; } /* full */
+        else               { pos = atomic_load_u64(&q->enqueue_pos, ATOMIC_RELAXED); }
+    }
+}
+
+b32 queue_mpmc_pop(queue_mpmc_t* q, void* elem)
+{
+    u64 pos = atomic_load_u64(&q->dequeue_pos, ATOMIC_RELAXED);
+    for (;;)
+    {
+        u8* cell = q->cells + (pos & q->mask) * q->cell_size;
+        u64 seq  = atomic_load_u64((u64*) cell, ATOMIC_ACQUIRE);
+        i64 diff = (i64) (seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (atomic_cas_weak_u64(&q->dequeue_pos, &pos, pos + 1, ATOMIC_RELAXED))
+            {
+                memcpy(elem, cell + sizeof(u64), q->elem_size);
+                atomic_store_u64((u64*) cell, pos + q->mask + 1, ATOMIC_RELEASE); /* free for the next lap */
+                return 1;
+            }
+        }
+        else if (diff < 0) { return 0; } /* empty */
+        else               { pos = atomic_load_u64(&q->dequeue_pos, ATOMIC_RELAXED); }
+    }
+}
+
+/* NOTE: cells are released out of order, so batches claim one position at a time */
+u64 queue_mpmc_push_n(queue_mpmc_t* q, const void* elems, u64 count)
+{
+    u64 i = 0;
+    while (i < count && queue_mpmc_push(q, (const u8*) elems + i * q->elem_size)) { i++; }
+    return i;
+}
+
+u64 queue_mpmc_pop_n(queue_mpmc_t* q, void* elems, u64 max)
+{
+    u64 i = 0;
+    while (i < max && queue_mpmc_pop(q, (u8*) elems + i * q->elem_size)) { i++; }
+    return i;
+}
+#endif // BASIC_IMPLEMENTATION
@@ -0,0 +1,711 @@
+#pragma once
+
+/* non-owning string view: a pointer + length pair that is not NUL-terminated.
+ * Slicing, searching, splitting, trimming and parsing never allocate and
+ * never write to the viewed memory. Functions that build new strings (copy,
+ * concat, join) take a mem_arena_t to push the result onto.
+ *
+ * NOTE: parsing functions take the whole view, i.e. there is no need to copy
+ * a substring into a NUL-terminated buffer just to call strtol/strtod.
+ *
+ * Searching & scanning (find, find_any, count, utf8 validation) uses SSE2,
+ * AVX2 or AVX-512 kernels picked at runtime (see SIMD_DISPATCH in platform.h),
+ * so it doesn't need to be compiled with -mavx2, and falls back to scalar code
+ * on other architectures.
+ */
+
+/* Example usage code:
+
+       str8 line = S("  width = 1280 ");
+       str8 key, value;
+       if (str8_cut(line, '=', &key, &value))
+       {
+           i64 width = 0;
+           if (str8_equal(str8_trim(key), S("width")) && str8_to_i64(str8_trim(value), &width)) { ... }
+       }
+
+       str8_iter_t it = str8_tokenize(S("a, b,,c"), S(", "));
+       for (str8 token; str8_next(&it, &token);) { printf("%.*s\n", STR8_FMT(token)); } // a b c
+*/
+
+#include <string.h> /* for memcmp, memchr, strlen */
+
+typedef struct str8
+{
+    u8* ptr;
+    u64 len;
+} str8;
+
+/* S("literal") creates a view of a string literal w/o calling strlen */
+#define S(lit)               str8_make((u8*) (lit), sizeof(lit) - 1)
+#define STR8_LIT_INIT(lit)   { (u8*) (lit), sizeof(lit) - 1 } /* for static initializers */
+#define STR8_FMT(s)          (int) (s).len, (const char*) (s).ptr  /* printf("%.*s", STR8_FMT(s)) */
+
+inline static str8 str8_make  (u8* ptr, u64 len)   { str8 s; s.ptr = ptr; s.len = len; return s; }
+inline static str8 str8_cstr  (const char* cstr)   { return str8_make((u8*) cstr, cstr ? strlen(cstr) : 0); }
+
+/* slicing: indices are clamped to the view, so these never fail */
+inline static str8 str8_slice (str8 s, u64 from, u64 to) { if (to > s.len) { to = s.len; } if (from > to) { from = to; } return str8_make(s.ptr + from, to - from); }
+inline static str8 str8_prefix(str8 s, u64 n)            { return str8_slice(s, 0, n); }
+inline static str8 str8_suffix(str8 s, u64 n)            { return str8_slice(s, (n > s.len) ? 0 : s.len - n, s.len); }
+inline static str8 str8_skip  (str8 s, u64 n)            { return str8_slice(s, n, s.len); }
+inline static str8 str8_chop  (str8 s, u64 n)            { return str8_slice(s, 0, (n > s.len) ? 0 : s.len - n); }
+
+inline static b32  str8_equal      (str8 a, str8 b)      { return (a.len == b.len) && (a.len == 0 || memcmp(a.ptr, b.ptr, a.len) == 0); }
+inline static b32  str8_starts_with(str8 s, str8 prefix) { return str8_equal(str8_prefix(s, prefix.len), prefix); }
+inline static b32  str8_ends_with  (str8 s, str8 suffix) { return str8_equal(str8_suffix(s, suffix.len), suffix); }
+inline static b32  str8_is_space   (u8 c)                { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+/* api */
+i64  str8_find_byte (str8 s, u8 c, u64 from);        /* -1 if not found */
+i64  str8_rfind_byte(str8 s, u8 c);                  /* -1 if not found */
+i64  str8_find      (str8 s, str8 needle, u64 from); /* -1 if not found */
+i64  str8_find_any  (str8 s, str8 set, u64 from);    /* first byte that is in set, -1 if not found */
+b32  str8_contains  (str8 s, str8 needle);
+u64  str8_count_byte(str8 s, u8 c);
+b32  str8_is_utf8   (str8 s);                        /* rejects overlongs, surrogates & > U+10FFFF */
+#define str8_count_newlines(s) str8_count_byte((s), '\n')
+b32  str8_cut       (str8 s, u8 delim, str8* before, str8* after); /* split at first delim */
+
+str8 str8_trim_left (str8 s);
+str8 str8_trim_right(str8 s);
+str8 str8_trim      (str8 s);
+
+/* iterators: split keeps empty fields ("a,,b" -> "a" "" "b"), tokenize skips them */
+typedef struct str8_iter_t
+{
+    str8 rest;
+    str8 delims;     /* any of these bytes ends a token (tokenize) */
+    u8   delim;      /* single delimiter byte (split) */
+    b32  skip_empty;
+    b32  done;
+} str8_iter_t;
+
+str8_iter_t str8_split   (str8 s, u8   delim);
+str8_iter_t str8_tokenize(str8 s, str8 delims);
+b32         str8_next    (str8_iter_t* it, str8* token); /* returns 0 when done */
+
+/* parsing: the whole view has to be a valid number, returns 0 otherwise (e.g. on overflow) */
+b32  str8_to_u64    (str8 s, u64* out); /* decimal, 0x hex or 0b binary */
+b32  str8_to_i64    (str8 s, i64* out);
+b32  str8_to_f64    (str8 s, f64* out); /* decimal, optional exponent, inf & nan. Ignores the locale */
+
+/* building strings: results are pushed onto the arena and NUL-terminated (not counted in len),
+ * see strbuild.h for formatting & incremental building */
+str8  str8_copy     (mem_arena_t* arena, str8 s);
+char* str8_to_cstr  (mem_arena_t* arena, str8 s);
+str8  str8_concat   (mem_arena_t* arena, str8 a, str8 b);
+str8  str8_join     (mem_arena_t* arena, const str8* parts, u64 count, str8 separator);
+
+#ifdef BASIC_IMPLEMENTATION
+#include <stdlib.h> /* for strtod */
+
+/* search & scan kernels: all return len when nothing was found */
+#if defined(SIMD_DISPATCH_X86) && defined(SIMD_SSE2)
+  #define STR8_DISPATCH_AVX /* avx kernels are compiled regardless of -m flags */
+  #include <immintrin.h>
+#elif defined(SIMD_SSE2)
+  #include <emmintrin.h>
+#endif
+
+inline static u32 str8_ctz32(u32 mask) /* mask != 0 */
+{
+    #if defined(COMPILER_MSVC)
+      unsigned long idx; _BitScanForward(&idx, mask); return (u32) idx;
+    #elif !defined(COMPILER_TCC)
+      return (u32) __builtin_ctz(mask);
+    #else
+      u32 idx = 0; while (!(mask & 1)) { mask >>= 1; idx++; } return idx;
+    #endif
+}
+
+inline static u32 str8_ctz64(u64 mask) /* mask != 0 */
+{
+    u32 lo = (u32) mask;
+    return lo ? str8_ctz32(lo) : 32 + str8_ctz32((u32) (mask >> 32));
+}
+
+static u64 str8_find_byte_scalar(const u8* ptr, u64 len, u8 c)
+{
+    const u8* hit = (const u8*) memchr(ptr, c, len);
+    return hit ? (u64) (hit - ptr) : len;
+}
+
+static u64 str8_find_any_scalar(const u8* ptr, u64 len, const u8* set, u64 set_len)
+{
+    u8 table[256] = {0};
+    for (u64 i = 0; i < set_len; i++) { table[set[i]] = 1; }
+    for (u64 i = 0; i < len; i++)     { if (table[ptr[i]]) { return i; } }
+    return len;
+}
+
+static u64 str8_find_scalar(const u8* ptr, u64 len, const u8* needle, u64 needle_len) /* needle_len > 0 */
+{
+    if (needle_len > len) { return len; }
+    u64 last = len - needle_len;
+    for (u64 i = 0; i <= last; i++)
+    {
+        const u8* hit = (const u8*) memchr(ptr + i, needle[0], (last - i) + 1);
+        if (!hit) { break; }
+        i = hit - ptr;
+        if (memcmp(hit, needle, needle_len) == 0) { return i; }
+    }
+    return len;
+}
+
+static u64 str8_count_byte_scalar(const u8* ptr, u64 len, u8 c)
+{
+    u64 count = 0;
+    for (u64 i = 0; i < len; i++) { count += (ptr[i] == c); }
+    return count;
+}
+
+static u64 str8_skip_ascii_scalar(const u8* ptr, u64 len) /* index of first non-ascii byte */
+{
+    u64 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        u64 block; memcpy(&block, ptr + i, 8);
+        if (block & 0x8080808080808080ull) { break; }
+    }
+    while (i < len && ptr[i] < 0x80) { i++; }
+    return i;
+}
+
+#if defined(SIMD_SSE2)
+static u64 str8_find_byte_sse2(const u8* ptr, u64 len, u8 c)
+{
+    __m128i needle = _mm_set1_epi8((char) c);
+    u64 i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*) (ptr + i));
+        u32 mask      = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_find_byte_scalar(ptr + i, len - i, c);
+}
+
+#define STR8_SIMD_MAX_SET 16 /* bigger sets use the lookup table */
+static u64 str8_find_any_sse2(const u8* ptr, u64 len, const u8* set, u64 set_len)
+{
+    if (set_len > STR8_SIMD_MAX_SET) { return str8_find_any_scalar(ptr, len, set, set_len); }
+    __m128i needles[STR8_SIMD_MAX_SET];
+    for (u64 j = 0; j < set_len; j++) { needles[j] = _mm_set1_epi8((char) set[j]); }
+
+    u64 i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*) (ptr + i));
+        __m128i eq    = _mm_cmpeq_epi8(block, needles[0]);
+        for (u64 j = 1; j < set_len; j++) { eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, needles[j])); }
+        u32 mask = (u32) _mm_movemask_epi8(eq);
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_find_any_scalar(ptr + i, len - i, set, set_len);
+}
+
+/* compares the first & last byte of the needle for 16 positions at once and
+ * only does a full compare for positions where both match, see
+ * http://0x80.pl/articles/simd-strfind.html */
+static u64 str8_find_sse2(const u8* ptr, u64 len, const u8* needle, u64 needle_len)
+{
+    if (needle_len == 1) { return str8_find_byte_sse2(ptr, len, needle[0]); }
+    __m128i first = _mm_set1_epi8((char) needle[0]);
+    __m128i last  = _mm_set1_epi8((char) needle[needle_len - 1]);
+    u64 i = 0;
+    for (; i + needle_len - 1 + 16 <= len; i += 16)
+    {
+        __m128i block_first = _mm_loadu_si128((const __m128i*) (ptr + i));
+        __m128i block_last  = _mm_loadu_si128((const __m128i*) (ptr + i + needle_len - 1));
+        u32 mask = (u32) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+        while (mask)
+        {
+            u32 bit = str8_ctz32(mask);
+            if (memcmp(ptr + i + bit + 1, needle + 1, needle_len - 2) == 0) { return i + bit; }
+            mask &= mask - 1;
+        }
+    }
+    u64 rest = str8_find_scalar(ptr + i, len - i, needle, needle_len);
+    return (rest == len - i) ? len : i + rest;
+}
+
+static u64 str8_count_byte_sse2(const u8* ptr, u64 len, u8 c)
+{
+    __m128i needle = _mm_set1_epi8((char) c);
+    __m128i zero   = _mm_setzero_si128();
+    u64 count = 0;
+    u64 i     = 0;
+    while (i + 16 <= len)
+    {
+        /* count in 8bit lanes (cmpeq yields -1) and sum them up before they overflow */
+        __m128i acc = zero;
+        for (u32 n = 0; n < 255 && i + 16 <= len; n++, i += 16)
+        {
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (ptr + i)), needle));
+        }
+        __m128i sums = _mm_sad_epu8(acc, zero);
+        count += (u64) _mm_cvtsi128_si32(sums) + (u64) _mm_extract_epi16(sums, 4);
+    }
+    return count + str8_count_byte_scalar(ptr + i, len - i, c);
+}
+
+static u64 str8_skip_ascii_sse2(const u8* ptr, u64 len)
+{
+    u64 i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        u32 mask = (u32) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (ptr + i)));
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_skip_ascii_scalar(ptr + i, len - i);
+}
+#endif // SIMD_SSE2
+
+#if defined(STR8_DISPATCH_AVX)
+SIMD_TARGET_AVX2 static u64 str8_find_byte_avx2(const u8* ptr, u64 len, u8 c)
+{
+    __m256i needle = _mm256_set1_epi8((char) c);
+    u64 i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*) (ptr + i));
+        u32 mask      = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_find_byte_sse2(ptr + i, len - i, c);
+}
+
+SIMD_TARGET_AVX2 static u64 str8_find_any_avx2(const u8* ptr, u64 len, const u8* set, u64 set_len)
+{
+    if (set_len > STR8_SIMD_MAX_SET) { return str8_find_any_scalar(ptr, len, set, set_len); }
+    __m256i needles[STR8_SIMD_MAX_SET];
+    for (u64 j = 0; j < set_len; j++) { needles[j] = _mm256_set1_epi8((char) set[j]); }
+
+    u64 i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*) (ptr + i));
+        __m256i eq    = _mm256_cmpeq_epi8(block, needles[0]);
+        for (u64 j = 1; j < set_len; j++) { eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, needles[j])); }
+        u32 mask = (u32) _mm256_movemask_epi8(eq);
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_find_any_sse2(ptr + i, len - i, set, set_len);
+}
+
+SIMD_TARGET_AVX2 static u64 str8_find_avx2(const u8* ptr, u64 len, const u8* needle, u64 needle_len)
+{
+    if (needle_len == 1) { return str8_find_byte_avx2(ptr, len, needle[0]); }
+    __m256i first = _mm256_set1_epi8((char) needle[0]);
+    __m256i last  = _mm256_set1_epi8((char) needle[needle_len - 1]);
+    u64 i = 0;
+    for (; i + needle_len - 1 + 32 <= len; i += 32)
+    {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*) (ptr + i));
+        __m256i block_last  = _mm256_loadu_si256((const __m256i*) (ptr + i + needle_len - 1));
+        u32 mask = (u32) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+        while (mask)
+        {
+            u32 bit = str8_ctz32(mask);
+            if (memcmp(ptr + i + bit + 1, needle + 1, needle_len - 2) == 0) { return i + bit; }
+            mask &= mask - 1;
+        }
+    }
+    u64 rest = str8_find_sse2(ptr + i, len - i, needle, needle_len);
+    return (rest == len - i) ? len : i + rest;
+}
+
+SIMD_TARGET_AVX2 static u64 str8_count_byte_avx2(const u8* ptr, u64 len, u8 c)
+{
+    __m256i needle = _mm256_set1_epi8((char) c);
+    __m256i zero   = _mm256_setzero_si256();
+    u64 count = 0;
+    u64 i     = 0;
+    while (i + 32 <= len)
+    {
+        __m256i acc = zero;
+        for (u32 n = 0; n < 255 && i + 32 <= len; n++, i += 32)
+        {
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (ptr + i)), needle));
+        }
+        u64 sums[4];
+        _mm256_storeu_si256((__m256i*) sums, _mm256_sad_epu8(acc, zero));
+        count += sums[0] + sums[1] + sums[2] + sums[3];
+    }
+    return count + str8_count_byte_sse2(ptr + i, len - i, c);
+}
+
+SIMD_TARGET_AVX2 static u64 str8_skip_ascii_avx2(const u8* ptr, u64 len)
+{
+    u64 i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        u32 mask = (u32) _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*) (ptr + i)));
+        if (mask) { return i + str8_ctz32(mask); }
+    }
+    return i + str8_skip_ascii_sse2(ptr + i, len - i);
+}
+
+/* only the byte scans, the wider compare doesn't pay off for the others */
+SIMD_TARGET_AVX512 static u64 str8_find_byte_avx512(const u8* ptr, u64 len, u8 c)
+{
+    __m512i needle = _mm512_set1_epi8((char) c);
+    u64 i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        u64 mask = (u64) _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) (ptr + i)), needle);
+        if (mask) { return i + str8_ctz64(mask); }
+    }
+    return i + str8_find_byte_avx2(ptr + i, len - i, c);
+}
+
+SIMD_TARGET_AVX512 static u64 str8_skip_ascii_avx512(const u8* ptr, u64 len)
+{
+    u64 i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        u64 mask = (u64) _mm512_movepi8_mask(_mm512_loadu_si512((const void*) (ptr + i)));
+        if (mask) { return i + str8_ctz64(mask); }
+    }
+    return i + str8_skip_ascii_avx2(ptr + i, len - i);
+}
+#endif // STR8_DISPATCH_AVX
+
+/* pick the widest kernels the cpu supports, once at runtime */
+#if defined(STR8_DISPATCH_AVX)
+  #define STR8_SELECT(kernel)                                     \
+      if (level >= PLATFORM_SIMD_AVX2) { return kernel##_avx2; } \
+      if (level >= PLATFORM_SIMD_SSE2) { return kernel##_sse2; } \
+      return kernel##_scalar;
+#elif defined(SIMD_SSE2)
+  #define STR8_SELECT(kernel) (void) level; return kernel##_sse2;
+#else
+  #define STR8_SELECT(kernel) (void) level; return kernel##_scalar;
+#endif
+
+SIMD_DISPATCH(u64, str8_find_byte_kernel, (const u8* ptr, u64 len, u8 c), (ptr, len, c))
+{
+#if defined(STR8_DISPATCH_AVX)
+    if (level >= PLATFORM_SIMD_AVX512) { return str8_find_byte_avx512; }
+#endif
+    STR8_SELECT(str8_find_byte)
+}
+SIMD_DISPATCH(u64, str8_find_any_kernel, (const u8* ptr, u64 len, const u8* set, u64 set_len), (ptr, len, set, set_len))
+{
+    STR8_SELECT(str8_find_any)
+}
+SIMD_DISPATCH(u64, str8_find_kernel, (const u8* ptr, u64 len, const u8* needle, u64 needle_len), (ptr, len, needle, needle_len))
+{
+    STR8_SELECT(str8_find)
+}
+SIMD_DISPATCH(u64, str8_count_byte_kernel, (const u8* ptr, u64 len, u8 c), (ptr, len, c))
+{
+    STR8_SELECT(str8_count_byte)
+}
+SIMD_DISPATCH(u64, str8_skip_ascii_kernel, (const u8* ptr, u64 len), (ptr, len))
+{
+#if defined(STR8_DISPATCH_AVX)
+    if (level >= PLATFORM_SIMD_AVX512) { return str8_skip_ascii_avx512; }
+#endif
+    STR8_SELECT(str8_skip_ascii)
+}
+#undef STR8_SELECT
+
+i64 str8_find_byte(str8 s, u8 c, u64 from)
+{
+    if (from >= s.len) { return -1; }
+    u64 idx = str8_find_byte_kernel(s.ptr + from, s.len - from, c);
+    return (idx == s.len - from) ? -1 : (i64) (from + idx);
+}
+
+i64 str8_rfind_byte(str8 s, u8 c)
+{
+    for (u64 i = s.len; i > 0; i--) { if (s.ptr[i - 1] == c) { return (i64) (i - 1); } }
+    return -1;
+}
+
+i64 str8_find(str8 s, str8 needle, u64 from)
+{
+    if (needle.len == 0)              { return (from <= s.len) ? (i64) from : -1; }
+    if (from > s.len || needle.len > s.len - from) { return -1; }
+    u64 idx = str8_find_kernel(s.ptr + from, s.len - from, needle.ptr, needle.len);
+    return (idx == s.len - from) ? -1 : (i64) (from + idx);
+}
+
+i64 str8_find_any(str8 s, str8 set, u64 from)
+{
+    if (from >= s.len || set.len == 0) { return -1; }
+    u64 idx = (set.len == 1) ? str8_find_byte_kernel(s.ptr + from, s.len - from, set.ptr[0])
+                             : str8_find_any_kernel (s.ptr + from, s.len - from, set.ptr, set.len);
+    return (idx == s.len - from) ? -1 : (i64) (from + idx);
+}
+
+u64 str8_count_byte(str8 s, u8 c)
+{
+    return str8_count_byte_kernel(s.ptr, s.len, c);
+}
+
+b32 str8_is_utf8(str8 s)
+{
+    u64 i = 0;
+    for (;;)
+    {
+        /* skip over ascii in bulk, only decode multi-byte sequences */
+        i += str8_skip_ascii_kernel(s.ptr + i, s.len - i);
+        if (i >= s.len) { return 1; }
+
+        u8  c     = s.ptr[i];
+        u64 count = 0;
+        u8  lo    = 0x80; /* valid range of the 2nd byte */
+        u8  hi    = 0xBF;
+        if      (c >= 0xC2 && c <= 0xDF) { count = 1; }
+        else if (c == 0xE0)              { count = 2; lo = 0xA0; } /* overlong */
+        else if (c == 0xED)              { count = 2; hi = 0x9F; } /* surrogates */
+        else if (c >= 0xE1 && c <= 0xEF) { count = 2; }
+        else if (c == 0xF0)              { count = 3; lo = 0x90; } /* overlong */
+        else if (c == 0xF4)              { count = 3; hi = 0x8F; } /* > U+10FFFF */
+        else if (c >= 0xF1 && c <= 0xF3) { count = 3; }
+        else                             { return 0; }
+
+        if (s.len - i <= count)                        { return 0; }
+        if (s.ptr[i + 1] < lo || s.ptr[i + 1] > hi)    { return 0; }
+        for (u64 j = 2; j <= count; j++)
+        {
+            if ((s.ptr[i + j] & 0xC0) != 0x80)         { return 0; }
+        }
+        i += count + 1;
+    }
+}
+
+b32 str8_contains(str8 s, str8 needle) { return str8_find(s, needle, 0) >= 0; }
+
+b32 str8_cut(str8 s, u8 delim, str8* before, str8* after)
+{
+    i64 idx = str8_find_byte(s, delim, 0);
+    if (idx < 0) { return 0; }
+    if (before) { *before = str8_slice(s, 0, idx);          }
+    if (after)  { *after  = str8_slice(s, idx + 1, s.len); }
+    return 1;
+}
+
+str8 str8_trim_left(str8 s)
+{
+    u64 i = 0;
+    while (i < s.len && str8_is_space(s.ptr[i])) { i++; }
+    return str8_skip(s, i);
+}
+
+str8 str8_trim_right(str8 s)
+{
+    u64 len = s.len;
+    while (len > 0 && str8_is_space(s.ptr[len - 1])) { len--; }
+    return str8_prefix(s, len);
+}
+
+str8 str8_trim(str8 s) { return str8_trim_right(str8_trim_left(s)); }
+
+str8_iter_t str8_split(str8 s, u8 delim)
+{
+    str8_iter_t it;
+    it.rest       = s;
+    it.delims     = str8_make(NULL, 0);
+    it.delim      = delim;
+    it.skip_empty = 0;
+    it.done       = 0;
+    return it;
+}
+
+str8_iter_t str8_tokenize(str8 s, str8 delims)
+{
+    str8_iter_t it = str8_split(s, 0);
+    it.delims      = delims;
+    it.skip_empty  = 1;
+    return it;
+}
+
+b32 str8_next(str8_iter_t* it, str8* token)
+{
+    for (;;)
+    {
+        if (it->done) { return 0; }
+
+        i64 idx = it->delims.len ? str8_find_any(it->rest, it->delims, 0) : str8_find_byte(it->rest, it->delim, 0);
+        u64 end = (idx < 0) ? it->rest.len : (u64) idx;
+
+        *token = str8_prefix(it->rest, end);
+        if (end == it->rest.len) { it->done = 1; it->rest = str8_skip(it->rest, end); }
+        else                     { it->rest = str8_skip(it->rest, end + 1);           }
+
+        if (!(it->skip_empty && token->len == 0)) { return 1; }
+    }
+}
+
+b32 str8_to_u64(str8 s, u64* out)
+{
+    u64 base = 10;
+    if (s.len > 2 && s.ptr[0] == '0' && (s.ptr[1] == 'x' || s.ptr[1] == 'X')) { base = 16; s = str8_skip(s, 2); }
+    else if (s.len > 2 && s.ptr[0] == '0' && (s.ptr[1] == 'b' || s.ptr[1] == 'B')) { base = 2; s = str8_skip(s, 2); }
+    if (s.len == 0) { return 0; }
+
+    u64 value = 0;
+    for (u64 i = 0; i < s.len; i++)
+    {
+        u8  c     = s.ptr[i];
+        u64 digit = 0;
+        if      (c >= '0' && c <= '9') { digit = c - '0';      }
+        else if (c >= 'a' && c <= 'f') { digit = c - 'a' + 10; }
+        else if (c >= 'A' && c <= 'F') { digit = c - 'A' + 10; }
+        else                           { return 0;             }
+        if (digit >= base)                              { return 0; }
+        if (value > (((u64) -1) - digit) / base)        { return 0; } /* overflow */
+        value = (value * base) + digit;
+    }
+    *out = value;
+    return 1;
+}
+
+b32 str8_to_i64(str8 s, i64* out)
+{
+    b32 negative = 0;
+    if (s.len && (s.ptr[0] == '-' || s.ptr[0] == '+')) { negative = (s.ptr[0] == '-'); s = str8_skip(s, 1); }
+
+    u64 magnitude = 0;
+    if (!str8_to_u64(s, &magnitude)) { return 0; }
+
+    u64 limit = ((u64) 1) << 63; /* == -INT64_MIN */
+    if (negative) { if (magnitude > limit)  { return 0; } *out = (magnitude == limit) ? (i64) (-(i64) (limit - 1) - 1) : -(i64) magnitude; }
+    else          { if (magnitude >= limit) { return 0; } *out = (i64) magnitude; }
+    return 1;
+}
+
+b32 str8_to_f64(str8 s, f64* out)
+{
+    /* exact powers of 10 for the fast path */
+    static const f64 pow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    b32  negative = 0;
+    if (s.len && (s.ptr[0] == '-' || s.ptr[0] == '+')) { negative = (s.ptr[0] == '-'); s = str8_skip(s, 1); }
+    if (s.len == 0) { return 0; }
+
+    /* special values */
+    u8 lower[3] = {0};
+    for (u64 i = 0; i < 3 && i < s.len; i++) { lower[i] = s.ptr[i] | 0x20; }
+    if (s.len == 3 && lower[0] == 'i' && lower[1] == 'n' && lower[2] == 'f') { f64 big = 1e308; *out = negative ? -(big * 10) : (big * 10); return 1; }
+    if (s.len == 3 && lower[0] == 'n' && lower[1] == 'a' && lower[2] == 'n') { f64 zero = 0.0; *out = zero / zero; return 1; }
+
+    u64 mantissa = 0;
+    i32 digits   = 0; /* significant digits in mantissa */
+    i32 exponent = 0;
+    i32 exp      = 0; /* the part after the 'e' */
+    b32 any      = 0;
+    b32 exact    = 1; /* no digits dropped */
+    u64 i        = 0;
+
+    for (; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++, any = 1)
+    {
+        if (digits < 19)              { mantissa = mantissa * 10 + (s.ptr[i] - '0'); digits += (mantissa != 0); }
+        else                          { exponent += 1; exact &= (s.ptr[i] == '0'); }
+    }
+    if (i < s.len && s.ptr[i] == '.')
+    {
+        for (i++; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++, any = 1)
+        {
+            if (digits < 19)          { mantissa = mantissa * 10 + (s.ptr[i] - '0'); digits += (mantissa != 0); exponent -= 1; }
+            else                      { exact &= (s.ptr[i] == '0'); }
+        }
+    }
+    if (!any) { return 0; }
+    if (i < s.len && (s.ptr[i] == 'e' || s.ptr[i] == 'E'))
+    {
+        b32 exp_negative = 0;
+        i++;
+        if (i < s.len && (s.ptr[i] == '-' || s.ptr[i] == '+')) { exp_negative = (s.ptr[i] == '-'); i++; }
+        if (i == s.len) { return 0; }
+        for (; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++)
+        {
+            if (exp < 100000) { exp = exp * 10 + (s.ptr[i] - '0'); }
+        }
+        if (exp_negative) { exp = -exp; }
+        exponent += exp;
+    }
+    if (i != s.len) { return 0; }
+
+    /* fast path: mantissa and power of 10 are exactly representable, so a single
+     * multiplication/division is correctly rounded (Clinger) */
+    if (exact && mantissa <= (((u64) 1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        f64 value = (f64) mantissa;
+        value     = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+        *out      = negative ? -value : value;
+        return 1;
+    }
+
+    /* slow path: let the c library do the correctly rounded conversion from a
+     * stack copy in the form "<digits>e<exp>". Without a decimal point the locale
+     * doesn't matter, and 768 significant digits decide the rounding of any
+     * double, later ones only count as a nonzero (sticky) digit */
+    enum { MAX_DIGITS = 768 };
+    char buf[MAX_DIGITS + 32];
+    u64  n        = 0;
+    i64  exp10    = exp;
+    b32  fraction = 0;
+    b32  sticky   = 0;
+    for (u64 j = 0; j < s.len && s.ptr[j] != 'e' && s.ptr[j] != 'E'; j++)
+    {
+        u8 c = s.ptr[j];
+        if      (c == '.')           { fraction = 1; }
+        else if (n == 0 && c == '0') { exp10 -= fraction; } /* leading zero */
+        else if (n < MAX_DIGITS)     { buf[n++] = (char) c; exp10 -= fraction; }
+        else                         { sticky |= (c != '0'); exp10 += !fraction; }
+    }
+    if (sticky) { buf[n++] = '1'; exp10 -= 1; }
+    if (n == 0) { buf[n++] = '0'; }
+
+    /* exponent digits, written backwards */
+    buf[n++] = 'e';
+    if (exp10 < 0) { buf[n++] = '-'; exp10 = -exp10; }
+    u64 start = n;
+    do { buf[n++] = (char) ('0' + (exp10 % 10)); exp10 /= 10; } while (exp10);
+    for (u64 a = start, b = n - 1; a < b; a++, b--) { char t = buf[a]; buf[a] = buf[b]; buf[b] = t; }
+    buf[n] = '\0';
+
+    f64 value = strtod(buf, NULL);
+    *out      = negative ? -value : value;
+    return 1;
+}
+
+str8 str8_copy(mem_arena_t* arena, str8 s)
+{
+    u8* ptr = (u8*) mem_arena_push(arena, s.len + 1);
+    if (s.len) { memcpy(ptr, s.ptr, s.len); }
+    ptr[s.len] = '\0';
+    return str8_make(ptr, s.len);
+}
+
+char* str8_to_cstr(mem_arena_t* arena, str8 s) { return (char*) str8_copy(arena, s).ptr; }
+
+str8 str8_concat(mem_arena_t* arena, str8 a, str8 b)
+{
+    str8 parts[2] = { a, b };
+    return str8_join(arena, parts, 2, str8_make(NULL, 0));
+}
+
+str8 str8_join(mem_arena_t* arena, const str8* parts, u64 count, str8 separator)
+{
+    u64 len = 0;
+    for (u64 i = 0; i < count; i++) { len += parts[i].len; }
+    if (count > 1) { len += separator.len * (count - 1); }
+
+    u8* ptr = (u8*) mem_arena_push(arena, len + 1);
+    u8* at  = ptr;
+    for (u64 i = 0; i < count; i++)
+    {
+        if (i && separator.len) { memcpy(at, separator.ptr, separator.len); at += separator.len; }
+        if (parts[i].len)       { memcpy(at, parts[i].ptr, parts[i].len);   at += parts[i].len;   }
+    }
+    *at = '\0';
+    return str8_make(ptr, len);
+}
+
+#endif // BASIC_IMPLEMENTATION
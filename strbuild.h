@@ -0,0 +1,593 @@
+#pragma once
+
+/* string builder that appends into a list of chunks pushed onto a mem_arena_t.
+ * As long as the last chunk sits on top of the arena it is grown in place, so
+ * most builders end up as a single contiguous chunk and strbuild_finish()
+ * doesn't need to copy anything.
+ *
+ * strbuild_printf() formats straight into the chunk memory (no size-probing
+ * vsnprintf pass, no temporary heap buffers) and doesn't depend on the locale,
+ * i.e. the decimal separator is always '.'. Supported: flags "-+ #0", width
+ * and precision (also '*'), length modifiers "hh h l ll z j t L" and the
+ * conversions "d i u o x X c s p f F e E g G %".
+ *
+ * NOTE: floats >= 2^64 are printed with 17 significant digits, the digits
+ * after that are zero. Fractions have at most 17 digits, values are rounded
+ * half away from zero and very large/small exponents can be off by one in the
+ * last significant digit.
+ */
+
+/* Example usage code:
+
+       strbuild_t sb = strbuild_create(arena);
+       strbuild_append(&sb, S("frame "));
+       strbuild_append_u64(&sb, frame_index);
+       strbuild_printf(&sb, ": %.2f ms (%s)", frame_ms, status);
+       str8 line = strbuild_finish(&sb); // NUL-terminated
+*/
+
+#include <stdarg.h> /* for va_list */
+#include <stddef.h> /* for ptrdiff_t */
+#include <stdint.h> /* for intmax_t */
+
+#ifndef STRBUILD_CHUNK_SIZE
+  #define STRBUILD_CHUNK_SIZE 256 /* minimum size of a chunk, chunks grow with the builder */
+#endif
+
+typedef struct strbuild_chunk_t
+{
+    struct strbuild_chunk_t* next;
+    u8*                      data;
+    u64                      len;
+    u64                      cap;
+} strbuild_chunk_t;
+
+typedef struct strbuild_t
+{
+    mem_arena_t*      arena;
+    strbuild_chunk_t* first;
+    strbuild_chunk_t* last;
+    u64               len; /* over all chunks */
+} strbuild_t;
+
+/* api */
+strbuild_t strbuild_create     (mem_arena_t* arena);
+str8       strbuild_finish     (strbuild_t* sb);  /* contiguous & NUL-terminated, no copy for a single chunk */
+
+void       strbuild_append     (strbuild_t* sb, str8 s);
+void       strbuild_append_cstr(strbuild_t* sb, const char* s);
+void       strbuild_append_char(strbuild_t* sb, char c);
+void       strbuild_append_u64 (strbuild_t* sb, u64 value);
+void       strbuild_append_i64 (strbuild_t* sb, i64 value);
+void       strbuild_append_hex (strbuild_t* sb, u64 value); /* lowercase, no 0x prefix */
+void       strbuild_append_f64 (strbuild_t* sb, f64 value, u32 precision); /* same as %.*f */
+void       strbuild_printf     (strbuild_t* sb, const char* fmt, ...) PRINTF_FORMAT(2, 3);
+void       strbuild_vprintf    (strbuild_t* sb, const char* fmt, va_list args);
+
+/* low-level: get a pointer to at least size writable bytes, then commit what was written */
+u8*        strbuild_reserve    (strbuild_t* sb, u64 size);
+void       strbuild_commit     (strbuild_t* sb, u64 size);
+
+/* helper: format into a string on the arena (goes through a strbuild_t) */
+str8       str8_fmt            (mem_arena_t* arena, const char* fmt, ...) PRINTF_FORMAT(2, 3);
+str8       str8_fmtv           (mem_arena_t* arena, const char* fmt, va_list args);
+
+#ifdef BASIC_IMPLEMENTATION
+static const char strbuild_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const u64 strbuild_pow10[] =
+{
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull,
+};
+
+strbuild_t strbuild_create(mem_arena_t* arena)
+{
+    strbuild_t sb;
+    sb.arena = arena;
+    sb.first = NULL;
+    sb.last  = NULL;
+    sb.len   = 0;
+    return sb;
+}
+
+u8* strbuild_reserve(strbuild_t* sb, u64 size)
+{
+    strbuild_chunk_t* last = sb->last;
+    if (last && (last->cap - last->len) >= size) { return last->data + last->len; }
+
+    /* grow the last chunk in place if nothing else was pushed onto the arena since */
+    if (last && (last->data + last->cap) == (u8*) sb->arena->pos &&
+        (u64) (sb->arena->end - sb->arena->pos) >= size - (last->cap - last->len))
+    {
+        u64 grow_by = size - (last->cap - last->len);
+        if (grow_by < last->cap && (u64) (sb->arena->end - sb->arena->pos) >= last->cap) { grow_by = last->cap; }
+        mem_arena_push(sb->arena, grow_by);
+        last->cap += grow_by;
+        return last->data + last->len;
+    }
+
+    /* new chunk, header is aligned to 8 bytes */
+    u64 cap = (sb->len > STRBUILD_CHUNK_SIZE) ? sb->len : STRBUILD_CHUNK_SIZE;
+    if (cap < size) { cap = size; }
+    u64 pad = NEXT_ALIGN_POW2((uintptr_t) sb->arena->pos, 8) - (uintptr_t) sb->arena->pos;
+    u8* mem = (u8*) mem_arena_push(sb->arena, pad + sizeof(strbuild_chunk_t) + cap);
+
+    strbuild_chunk_t* chunk = (strbuild_chunk_t*) (mem + pad);
+    chunk->next = NULL;
+    chunk->data = (u8*) (chunk + 1);
+    chunk->len  = 0;
+    chunk->cap  = cap;
+    if (last) { last->next = chunk; }
+    else      { sb->first  = chunk; }
+    sb->last = chunk;
+    return chunk->data;
+}
+
+void strbuild_commit(strbuild_t* sb, u64 size)
+{
+    MEM_ASSERT(sb->last && sb->last->len + size <= sb->last->cap);
+    sb->last->len += size;
+    sb->len       += size;
+}
+
+str8 strbuild_finish(strbuild_t* sb)
+{
+    /* NUL-terminate without counting it */
+    u8* end = strbuild_reserve(sb, 1);
+    *end    = '\0';
+    if (sb->first == sb->last) { return str8_make(sb->first->data, sb->len); }
+
+    u8* ptr = (u8*) mem_arena_push(sb->arena, sb->len + 1);
+    u8* at  = ptr;
+    for (strbuild_chunk_t* chunk = sb->first; chunk; chunk = chunk->next)
+    {
+        memcpy(at, chunk->data, chunk->len);
+        at += chunk->len;
+    }
+    *at = '\0';
+    return str8_make(ptr, sb->len);
+}
+
+void strbuild_append(strbuild_t* sb, str8 s)
+{
+    if (!s.len) { return; }
+    memcpy(strbuild_reserve(sb, s.len), s.ptr, s.len);
+    strbuild_commit(sb, s.len);
+}
+
+void strbuild_append_cstr(strbuild_t* sb, const char* s) { strbuild_append(sb, str8_cstr(s)); }
+
+void strbuild_append_char(strbuild_t* sb, char c)
+{
+    *strbuild_reserve(sb, 1) = (u8) c;
+    strbuild_commit(sb, 1);
+}
+
+/* writes the number backwards ending at end, returns the nr of chars written */
+static u32 strbuild_u64_to_dec(char* end, u64 value)
+{
+    char* at = end;
+    while (value >= 100)
+    {
+        u64 pair = (value % 100) * 2;
+        value   /= 100;
+        *--at    = strbuild_digit_pairs[pair + 1];
+        *--at    = strbuild_digit_pairs[pair];
+    }
+    if (value >= 10) { *--at = strbuild_digit_pairs[value * 2 + 1]; *--at = strbuild_digit_pairs[value * 2]; }
+    else             { *--at = (char) ('0' + value); }
+    return (u32) (end - at);
+}
+
+static u32 strbuild_u64_to_base(char* end, u64 value, u32 base, b32 upper)
+{
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* at = end;
+    do { *--at = digits[value % base]; value /= base; } while (value);
+    return (u32) (end - at);
+}
+
+void strbuild_append_u64(strbuild_t* sb, u64 value)
+{
+    char buf[24];
+    u32  len = strbuild_u64_to_dec(buf + sizeof(buf), value);
+    strbuild_append(sb, str8_make((u8*) buf + sizeof(buf) - len, len));
+}
+
+void strbuild_append_i64(strbuild_t* sb, i64 value)
+{
+    if (value < 0) { strbuild_append_char(sb, '-'); strbuild_append_u64(sb, (u64) 0 - (u64) value); }
+    else           { strbuild_append_u64(sb, (u64) value); }
+}
+
+void strbuild_append_hex(strbuild_t* sb, u64 value)
+{
+    char buf[24];
+    u32  len = strbuild_u64_to_base(buf + sizeof(buf), value, 16, 0);
+    strbuild_append(sb, str8_make((u8*) buf + sizeof(buf) - len, len));
+}
+
+/* scales v (> 0) into [1,10) and returns the decimal exponent */
+static i32 strbuild_f64_normalize(f64* v)
+{
+    i32 exp = 0;
+    while (*v >= 1e16)  { *v /= 1e16; exp += 16; }
+    while (*v >= 10.0)  { *v /= 10.0; exp += 1;  }
+    while (*v <  1e-15) { *v *= 1e16; exp -= 16; }
+    while (*v <  1.0)   { *v *= 10.0; exp -= 1;  }
+    return exp;
+}
+
+/* writes count digits of value (zero-padded) to at */
+static char* strbuild_write_digits(char* at, u64 value, u32 count)
+{
+    for (u32 i = count; i > 0; i--) { at[i - 1] = (char) ('0' + (value % 10)); value /= 10; }
+    return at + count;
+}
+
+static char* strbuild_write_zeros(char* at, i32 count)
+{
+    for (i32 i = 0; i < count; i++) { *at++ = '0'; }
+    return at;
+}
+
+/* %f for finite v >= 0 */
+static char* strbuild_fmt_fixed(char* at, f64 v, i32 prec, b32 alt)
+{
+    i32 frac_digits = (prec > 17) ? 17 : prec;
+    if (v < 1e17)
+    {
+        u64 int_part = (u64) v;
+        u64 scale    = strbuild_pow10[frac_digits];
+        u64 frac     = (u64) (((v - (f64) int_part) * (f64) scale) + 0.5);
+        if (frac >= scale) { int_part += 1; frac -= scale; }
+
+        char digits[24];
+        u32  len = strbuild_u64_to_dec(digits + sizeof(digits), int_part);
+        memcpy(at, digits + sizeof(digits) - len, len);
+        at += len;
+        if (prec > 0 || alt) { *at++ = '.'; }
+        at = strbuild_write_digits(at, frac, frac_digits);
+    }
+    else if (v < 18446744073709551616.0)
+    {
+        /* integral and fits into an u64, i.e. exact */
+        char digits[24];
+        u32  len = strbuild_u64_to_dec(digits + sizeof(digits), (u64) v);
+        memcpy(at, digits + sizeof(digits) - len, len);
+        at += len;
+        if (prec > 0 || alt) { *at++ = '.'; }
+        frac_digits = 0;
+    }
+    else
+    {
+        /* 17 significant digits, then zeros */
+        i32 exp = strbuild_f64_normalize(&v);
+        u64 m   = (u64) ((v * 1e16) + 0.5);
+        if (m >= strbuild_pow10[17]) { m /= 10; exp += 1; }
+        at = strbuild_write_digits(at, m, 17);
+        at = strbuild_write_zeros(at, exp - 16);
+        if (prec > 0 || alt) { *at++ = '.'; }
+        frac_digits = 0;
+    }
+    return strbuild_write_zeros(at, prec - frac_digits);
+}
+
+/* %e for finite v >= 0 */
+static char* strbuild_fmt_exp(char* at, f64 v, i32 prec, b32 alt, char e)
+{
+    i32 digits = (prec > 16) ? 16 : prec;
+    i32 exp    = 0;
+    u64 m      = 0;
+    if (v != 0.0)
+    {
+        exp = strbuild_f64_normalize(&v);
+        m   = (u64) ((v * (f64) strbuild_pow10[digits]) + 0.5);
+        if (m >= strbuild_pow10[digits + 1]) { m /= 10; exp += 1; }
+    }
+
+    char mantissa[24];
+    strbuild_write_digits(mantissa, m, digits + 1);
+    *at++ = mantissa[0];
+    if (prec > 0 || alt) { *at++ = '.'; }
+    memcpy(at, mantissa + 1, digits);
+    at += digits;
+    at  = strbuild_write_zeros(at, prec - digits);
+
+    *at++ = e;
+    *at++ = (exp < 0) ? '-' : '+';
+    u32 abs_exp = (u32) ((exp < 0) ? -exp : exp);
+    at = strbuild_write_digits(at, abs_exp, (abs_exp >= 100) ? 3 : 2);
+    return at;
+}
+
+/* %g for finite v >= 0 */
+static char* strbuild_fmt_general(char* at, f64 v, i32 prec, b32 alt, b32 upper)
+{
+    i32 p   = (prec == 0) ? 1 : ((prec > 17) ? 17 : prec);
+    i32 exp = 0;
+    if (v != 0.0)
+    {
+        /* exponent after rounding to p significant digits */
+        f64 tmp = v;
+        exp     = strbuild_f64_normalize(&tmp);
+        if ((u64) ((tmp * (f64) strbuild_pow10[p - 1]) + 0.5) >= strbuild_pow10[p]) { exp += 1; }
+    }
+
+    char* start = at;
+    b32   fixed = (p > exp && exp >= -4);
+    at = fixed ? strbuild_fmt_fixed(at, v, p - 1 - exp, alt)
+               : strbuild_fmt_exp(at, v, p - 1, alt, upper ? 'E' : 'e');
+
+    if (!alt)
+    {
+        /* strip trailing zeros of the fraction (and the '.' if nothing is left) */
+        char* exp_start = at;
+        if (!fixed) { while (*(exp_start - 1) != 'e' && *(exp_start - 1) != 'E') { exp_start--; } exp_start--; }
+        char* frac_end = exp_start;
+        b32   has_dot  = 0;
+        for (char* c = start; c < exp_start; c++) { if (*c == '.') { has_dot = 1; } }
+        if (has_dot)
+        {
+            while (*(frac_end - 1) == '0') { frac_end--; }
+            if (*(frac_end - 1) == '.')    { frac_end--; }
+            memmove(frac_end, exp_start, at - exp_start);
+            at -= (exp_start - frac_end);
+        }
+    }
+    return at;
+}
+
+void strbuild_append_f64(strbuild_t* sb, f64 value, u32 precision)
+{
+    strbuild_printf(sb, "%.*f", (int) precision, value);
+}
+
+enum
+{
+    STRBUILD_FLAG_LEFT  = (1 << 0), /* '-' */
+    STRBUILD_FLAG_PLUS  = (1 << 1), /* '+' */
+    STRBUILD_FLAG_SPACE = (1 << 2), /* ' ' */
+    STRBUILD_FLAG_ALT   = (1 << 3), /* '#' */
+    STRBUILD_FLAG_ZERO  = (1 << 4), /* '0' */
+};
+
+enum { STRBUILD_LEN_INT, STRBUILD_LEN_CHAR, STRBUILD_LEN_SHORT, STRBUILD_LEN_LONG, STRBUILD_LEN_LLONG,
+       STRBUILD_LEN_SIZE, STRBUILD_LEN_MAX, STRBUILD_LEN_PTRDIFF, STRBUILD_LEN_LONG_DOUBLE };
+
+/* emits [spaces] prefix [zeros] body [spaces] */
+static void strbuild_emit_padded(strbuild_t* sb, u32 flags, i32 width, const char* prefix, u32 prefix_len,
+                                 i32 zeros, const char* body, u64 body_len)
+{
+    i64 total  = (i64) prefix_len + zeros + (i64) body_len;
+    i64 spaces = (width > total) ? width - total : 0;
+    if ((flags & STRBUILD_FLAG_ZERO) && !(flags & STRBUILD_FLAG_LEFT)) { zeros += (i32) spaces; spaces = 0; }
+
+    u8* at = strbuild_reserve(sb, (u64) (spaces + prefix_len + zeros) + body_len);
+    u8* start = at;
+    if (!(flags & STRBUILD_FLAG_LEFT)) { memset(at, ' ', spaces); at += spaces; }
+    memcpy(at, prefix, prefix_len);  at += prefix_len;
+    memset(at, '0', zeros);          at += zeros;
+    if (body_len) { memcpy(at, body, body_len); at += body_len; }
+    if (flags & STRBUILD_FLAG_LEFT)    { memset(at, ' ', spaces); at += spaces; }
+    strbuild_commit(sb, at - start);
+}
+
+void strbuild_vprintf(strbuild_t* sb, const char* fmt, va_list args)
+{
+    const char* p = fmt;
+    for (;;)
+    {
+        /* copy everything up to the next conversion */
+        const char* literal = p;
+        while (*p && *p != '%') { p++; }
+        if (p > literal) { strbuild_append(sb, str8_make((u8*) literal, p - literal)); }
+        if (!*p) { break; }
+        p++;
+
+        /* flags */
+        u32 flags = 0;
+        for (;; p++)
+        {
+            if      (*p == '-') { flags |= STRBUILD_FLAG_LEFT;  }
+            else if (*p == '+') { flags |= STRBUILD_FLAG_PLUS;  }
+            else if (*p == ' ') { flags |= STRBUILD_FLAG_SPACE; }
+            else if (*p == '#') { flags |= STRBUILD_FLAG_ALT;   }
+            else if (*p == '0') { flags |= STRBUILD_FLAG_ZERO;  }
+            else                { break; }
+        }
+
+        /* width & precision */
+        i32 width = 0;
+        if (*p == '*') { width = va_arg(args, int); p++; if (width < 0) { flags |= STRBUILD_FLAG_LEFT; width = -width; } }
+        else           { while (*p >= '0' && *p <= '9') { width = width * 10 + (*p++ - '0'); } }
+        i32 prec = -1;
+        if (*p == '.')
+        {
+            p++;
+            prec = 0;
+            if (*p == '*') { prec = va_arg(args, int); p++; if (prec < 0) { prec = -1; } }
+            else           { while (*p >= '0' && *p <= '9') { prec = prec * 10 + (*p++ - '0'); } }
+        }
+
+        /* length modifier */
+        i32 length = STRBUILD_LEN_INT;
+        switch (*p)
+        {
+            case 'h': { p++; length = STRBUILD_LEN_SHORT; if (*p == 'h') { p++; length = STRBUILD_LEN_CHAR;  } } break;
+            case 'l': { p++; length = STRBUILD_LEN_LONG;  if (*p == 'l') { p++; length = STRBUILD_LEN_LLONG; } } break;
+            case 'z': { p++; length = STRBUILD_LEN_SIZE;    } break;
+            case 'j': { p++; length = STRBUILD_LEN_MAX;     } break;
+            case 't': { p++; length = STRBUILD_LEN_PTRDIFF; } break;
+            case 'L': { p++; length = STRBUILD_LEN_LONG_DOUBLE; } break; /* long double is printed as double */
+            default: break;
+        }
+
+        char conv = *p;
+        if (!conv) { break; }
+        p++;
+
+        char buf[512]; /* numbers are formatted into this */
+        char prefix[3];
+        u32  prefix_len = 0;
+        switch (conv)
+        {
+            case '%': { strbuild_append_char(sb, '%'); } break;
+
+            case 'c':
+            {
+                char c = (char) va_arg(args, int);
+                strbuild_emit_padded(sb, flags & ~STRBUILD_FLAG_ZERO, width, "", 0, 0, &c, 1);
+            } break;
+
+            case 's':
+            {
+                const char* s = va_arg(args, const char*);
+                if (!s) { s = "(null)"; }
+                u64 len = 0;
+                if (prec >= 0) { while (len < (u64) prec && s[len]) { len++; } }
+                else           { len = strlen(s); }
+                strbuild_emit_padded(sb, flags & ~STRBUILD_FLAG_ZERO, width, "", 0, 0, s, len);
+            } break;
+
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'p':
+            {
+                u64 value    = 0;
+                b32 negative = 0;
+                if (conv == 'd' || conv == 'i')
+                {
+                    i64 v = 0;
+                    switch (length)
+                    {
+                        case STRBUILD_LEN_CHAR:    { v = (signed char) va_arg(args, int); } break;
+                        case STRBUILD_LEN_SHORT:   { v = (short)       va_arg(args, int); } break;
+                        case STRBUILD_LEN_LONG:    { v = va_arg(args, long);              } break;
+                        case STRBUILD_LEN_LLONG:   { v = va_arg(args, long long);         } break;
+                        case STRBUILD_LEN_SIZE:    { v = va_arg(args, ptrdiff_t);         } break;
+                        case STRBUILD_LEN_MAX:     { v = va_arg(args, intmax_t);          } break;
+                        case STRBUILD_LEN_PTRDIFF: { v = va_arg(args, ptrdiff_t);         } break;
+                        default:                   { v = va_arg(args, int);               } break;
+                    }
+                    negative = (v < 0);
+                    value    = negative ? (u64) 0 - (u64) v : (u64) v;
+                }
+                else if (conv == 'p')
+                {
+                    value  = (u64) (uintptr_t) va_arg(args, void*);
+                    flags |= STRBUILD_FLAG_ALT;
+                }
+                else
+                {
+                    switch (length)
+                    {
+                        case STRBUILD_LEN_CHAR:    { value = (unsigned char)  va_arg(args, unsigned int); } break;
+                        case STRBUILD_LEN_SHORT:   { value = (unsigned short) va_arg(args, unsigned int); } break;
+                        case STRBUILD_LEN_LONG:    { value = va_arg(args, unsigned long);                 } break;
+                        case STRBUILD_LEN_LLONG:   { value = va_arg(args, unsigned long long);            } break;
+                        case STRBUILD_LEN_SIZE:    { value = va_arg(args, size_t);                        } break;
+                        case STRBUILD_LEN_MAX:     { value = va_arg(args, uintmax_t);                     } break;
+                        case STRBUILD_LEN_PTRDIFF: { value = (u64) va_arg(args, ptrdiff_t);               } break;
+                        default:                   { value = va_arg(args, unsigned int);                  } break;
+                    }
+                }
+
+                if      (negative)                    { prefix[prefix_len++] = '-'; }
+                else if (flags & STRBUILD_FLAG_PLUS)  { if (conv == 'd' || conv == 'i') { prefix[prefix_len++] = '+'; } }
+                else if (flags & STRBUILD_FLAG_SPACE) { if (conv == 'd' || conv == 'i') { prefix[prefix_len++] = ' '; } }
+
+                char* end = buf + sizeof(buf);
+                u32   len = 0;
+                if (prec != 0 || value != 0)
+                {
+                    if      (conv == 'x' || conv == 'p') { len = strbuild_u64_to_base(end, value, 16, 0); }
+                    else if (conv == 'X')                { len = strbuild_u64_to_base(end, value, 16, 1); }
+                    else if (conv == 'o')                { len = strbuild_u64_to_base(end, value,  8, 0); }
+                    else                                 { len = strbuild_u64_to_dec(end, value);         }
+                }
+                if ((flags & STRBUILD_FLAG_ALT) && value != 0)
+                {
+                    if (conv == 'x' || conv == 'p') { prefix[prefix_len++] = '0'; prefix[prefix_len++] = 'x'; }
+                    if (conv == 'X')                { prefix[prefix_len++] = '0'; prefix[prefix_len++] = 'X'; }
+                    if (conv == 'o' && prec <= (i32) len) { prec = len + 1; }
+                }
+
+                i32 zeros = (prec > (i32) len) ? prec - (i32) len : 0;
+                if (prec >= 0) { flags &= ~STRBUILD_FLAG_ZERO; } /* precision overrides '0' flag */
+                strbuild_emit_padded(sb, flags, width, prefix, prefix_len, zeros, end - len, len);
+            } break;
+
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            {
+                f64 value = (length == STRBUILD_LEN_LONG_DOUBLE) ? (f64) va_arg(args, long double) : va_arg(args, f64);
+                b32 upper = (conv == 'F' || conv == 'E' || conv == 'G');
+                if (prec < 0)   { prec = 6;   }
+                if (prec > 100) { prec = 100; }
+
+                u64 bits; memcpy(&bits, &value, sizeof(bits)); /* sign bit, also set for -0.0 */
+                if      (bits >> 63)                  { prefix[prefix_len++] = '-'; value = -value; }
+                else if (flags & STRBUILD_FLAG_PLUS)  { prefix[prefix_len++] = '+'; }
+                else if (flags & STRBUILD_FLAG_SPACE) { prefix[prefix_len++] = ' '; }
+
+                const char* body = buf;
+                u64         len  = 0;
+                if (value != value)
+                {
+                    body   = upper ? "NAN" : "nan"; len = 3;
+                    flags &= ~STRBUILD_FLAG_ZERO;
+                }
+                else if (value > 1.7976931348623157e308)
+                {
+                    body   = upper ? "INF" : "inf"; len = 3;
+                    flags &= ~STRBUILD_FLAG_ZERO;
+                }
+                else
+                {
+                    b32   alt = (flags & STRBUILD_FLAG_ALT) != 0;
+                    char* end = buf;
+                    if      (conv == 'f' || conv == 'F') { end = strbuild_fmt_fixed  (buf, value, prec, alt);                     }
+                    else if (conv == 'e' || conv == 'E') { end = strbuild_fmt_exp    (buf, value, prec, alt, upper ? 'E' : 'e'); }
+                    else                                 { end = strbuild_fmt_general(buf, value, prec, alt, upper);              }
+                    len = end - buf;
+                }
+                strbuild_emit_padded(sb, flags, width, prefix, prefix_len, 0, body, len);
+            } break;
+
+            default: /* unknown conversion, print it as is */
+            {
+                strbuild_append_char(sb, '%');
+                strbuild_append_char(sb, conv);
+            } break;
+        }
+    }
+}
+
+void strbuild_printf(strbuild_t* sb, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    strbuild_vprintf(sb, fmt, args);
+    va_end(args);
+}
+
+str8 str8_fmtv(mem_arena_t* arena, const char* fmt, va_list args)
+{
+    strbuild_t sb = strbuild_create(arena);
+    strbuild_vprintf(&sb, fmt, args);
+    return strbuild_finish(&sb);
+}
+
+str8 str8_fmt(mem_arena_t* arena, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    str8 result = str8_fmtv(arena, fmt, args);
+    va_end(args);
+    return result;
+}
+#endif // BASIC_IMPLEMENTATION
@@ -1,48 +1,233 @@
+#pragma once
+
 #include "basic.h"
 
+/* owning string with small string optimization (SSO):
+ *
+ * - short mode: up to STRING_SSO_CAP (23 on 64bit, 11 on 32bit) chars are
+ *   stored inline, nothing gets allocated. The last byte holds the remaining
+ *   capacity, which doubles as the NUL terminator when the buffer is full.
+ * - long mode: ptr/len/cap, memory comes from either a mem_arena_t (pass one
+ *   to any function that can allocate) or from STRING_OS_ALLOC (malloc) when
+ *   NULL is passed instead. The MSB of the last byte flags long mode.
+ *
+ * Strings need to be initialized (string_empty(), string_from(), ...), a
+ * zeroed string_t is not valid. Only malloc'ed strings need string_free(),
+ * but calling it on short or arena-backed strings is fine as well.
+ *
+ * NOTE: the layout assumes a little-endian architecture (x86, arm).
+ */
+
+/* Example usage code:
+
+       string_t name = string_from_cstr("player", NULL); // short mode, no allocation
+       string_append_cstr(&name, "_01", NULL);           // still short mode
+       string_append_cstr(&name, "_with_a_much_longer_suffix", arena); // moves into arena memory
+       printf("%s\n", string_cstr(&name));
+       string_free(&name);
+*/
+
 /* see https://joellaity.com/2020/01/31/string.html */
-typedef struct string_t
+
+/* NOTE: used for long mode strings when no arena is passed */
+#ifndef STRING_OS_ALLOC
+  #include <stdlib.h>
+  #define STRING_OS_ALLOC(size) malloc(size)
+  #define STRING_OS_FREE(ptr)   free(ptr)
+#endif
+
+#include <string.h> /* for memcpy, memcmp, strlen */
+
+#define STRING_SSO_CAP      ((sizeof(size_t) * 3) - 1)
+#define STRING_FLAG_LONG    0x80 /* flags in the last byte */
+#define STRING_FLAG_ARENA   0x40
+#define STRING_CAP_MASK     (~(((size_t) (STRING_FLAG_LONG | STRING_FLAG_ARENA)) << ((sizeof(size_t) - 1) * 8)))
+
+typedef union string_t
 {
-    #define SHORT_MODE  ((len_ss & (u8(1)<<7)) == 0)
-    #define LONG_MODE   ((cap & (u64(1)<<63)) == 1)
+    struct /* long string */
+    {
+        char*  ptr;
+        size_t len;
+        size_t cap;    /* flags live in the most significant byte */
+    } ls;
+    struct /* small string */
+    {
+        char   buf[STRING_SSO_CAP];
+        u8     remaining; /* STRING_SSO_CAP - len, also acts as NUL when full */
+    } ss;
 
-    union {
-        struct /* small string */
-        {
-            u8   len_ss;  // MSB is a flag
-            char buf[16];
-        };
-        struct /* long string */
-        {
-            u64   cap;    // MSB is a flag; real capacity goes up to 127
-            u64   len_ls;
-            char* ptr;
-        };
-    };
+#if defined(LANGUAGE_CPP)
+    inline u64   len();
+    inline char* c_str();
+    inline char& operator[](u64 idx);
+#endif
+} string_t;
+
+inline static b32   string_is_long (const string_t* s) { return (s->ss.remaining & STRING_FLAG_LONG) != 0; }
+inline static u64   string_len     (const string_t* s) { return string_is_long(s) ? s->ls.len : (STRING_SSO_CAP - s->ss.remaining); }
+inline static u64   string_cap     (const string_t* s) { return string_is_long(s) ? (s->ls.cap & STRING_CAP_MASK) : STRING_SSO_CAP; }
+inline static char* string_cstr    (string_t* s)       { return string_is_long(s) ? s->ls.ptr : s->ss.buf; }
+inline static string_t string_empty()                  { string_t s; s.ss.buf[0] = '\0'; s.ss.remaining = STRING_SSO_CAP; return s; }
+inline static str8  string_view    (string_t* s)       { return str8_make((u8*) string_cstr(s), string_len(s)); } /* invalidated by appending */
 
-    u64   len()   { if (SHORT_MODE) { return len_ss; } else { return len_ls; } }
-    char* c_str() { if (SHORT_MODE) { return buf; } else { return ptr; } }
+#if defined(LANGUAGE_CPP)
+    inline u64   string_t::len()   { return string_len(this);  }
+    inline char* string_t::c_str() { return string_cstr(this); }
+    inline char& string_t::operator[](u64 idx) { ASSERT(idx < string_len(this)); return string_cstr(this)[idx]; }
+#endif
 
-    char& operator[](u32 idx)
+/* api: functions that can allocate take an arena, pass NULL to use STRING_OS_ALLOC */
+string_t string_from       (const char* str, u64 len, mem_arena_t* arena);
+string_t string_from_cstr  (const char* str,          mem_arena_t* arena);
+void     string_free       (string_t* s);
+
+void     string_reserve    (string_t* s, u64 cap,               mem_arena_t* arena);
+void     string_append     (string_t* s, const char* str, u64 len, mem_arena_t* arena);
+void     string_append_cstr(string_t* s, const char* str,      mem_arena_t* arena);
+void     string_push       (string_t* s, char c,                mem_arena_t* arena);
+void     string_clear      (string_t* s); /* keeps the capacity */
+
+string_t string_substr     (const string_t* s, u64 from, u64 len, mem_arena_t* arena);
+i64      string_find       (const string_t* s, const char* needle, u64 needle_len, u64 from); /* -1 if not found */
+b32      string_equal      (const string_t* a, const string_t* b);
+
+#ifdef BASIC_IMPLEMENTATION
+static void string_set_len(string_t* s, u64 len)
+{
+    if (string_is_long(s)) { s->ls.len = len; s->ls.ptr[len] = '\0'; }
+    else
     {
-        if (true /* check for short string mode */)
+        s->ss.remaining = (u8) (STRING_SSO_CAP - len); /* 0 doubles as NUL when full */
+        if (len < STRING_SSO_CAP) { s->ss.buf[len] = '\0'; }
+    }
+}
+
+/* moves the string into a long mode buffer that fits at least cap chars (+ NUL) */
+static void string_grow(string_t* s, u64 cap, mem_arena_t* arena)
+{
+    u64   len     = string_len(s);
+    u64   old_cap = string_cap(s);
+    char* old_ptr = string_cstr(s);
+
+    /* grow geometrically, but at least to the requested size */
+    u64 new_cap = (old_cap * 2 > cap) ? old_cap * 2 : cap;
+
+    char* ptr   = NULL;
+    u8    flags = STRING_FLAG_LONG;
+    if (arena)
+    {
+        flags |= STRING_FLAG_ARENA;
+
+        /* arena strings at the top of the arena are extended in place */
+        if (string_is_long(s) && (s->ss.remaining & STRING_FLAG_ARENA) && ((old_ptr + old_cap + 1) == arena->pos))
         {
-            if (idx < (sizeof(buf)/sizeof(char))) { /* reallocate into long string */ }
-            return buf[idx];
+            mem_arena_push(arena, new_cap - old_cap);
+            ptr = old_ptr;
         }
         else
         {
-            /* ASSERT(idx < cap) */
-            return ptr[idx];
+            ptr = (char*) mem_arena_push(arena, new_cap + 1);
+            memcpy(ptr, old_ptr, len + 1);
         }
     }
-} string_t;
+    else
+    {
+        ptr = (char*) STRING_OS_ALLOC(new_cap + 1);
+        MEM_ASSERT(ptr);
+        memcpy(ptr, old_ptr, len + 1);
+    }
+
+    if (ptr != old_ptr) { string_free(s); }
+
+    s->ls.ptr = ptr;
+    s->ls.len = len;
+    s->ls.cap = new_cap;
+    s->ss.remaining |= flags; /* sets the flags in the MSB of cap */
+}
+
+string_t string_from(const char* str, u64 len, mem_arena_t* arena)
+{
+    string_t s = string_empty();
+    string_append(&s, str, len, arena);
+    return s;
+}
+
+string_t string_from_cstr(const char* str, mem_arena_t* arena)
+{
+    return string_from(str, strlen(str), arena);
+}
+
+void string_free(string_t* s)
+{
+    if (string_is_long(s) && !(s->ss.remaining & STRING_FLAG_ARENA)) { STRING_OS_FREE(s->ls.ptr); }
+    *s = string_empty();
+}
+
+void string_reserve(string_t* s, u64 cap, mem_arena_t* arena)
+{
+    if (cap > string_cap(s)) { string_grow(s, cap, arena); }
+}
+
+void string_append(string_t* s, const char* str, u64 len, mem_arena_t* arena)
+{
+    u64 old_len = string_len(s);
+    if (old_len + len > string_cap(s))
+    {
+        /* NOTE: str is allowed to point into s, which can move when growing */
+        const char* old_ptr = string_cstr(s);
+        b32 aliases         = (str >= old_ptr) && (str <= old_ptr + old_len);
+        u64 offset          = aliases ? (u64) (str - old_ptr) : 0;
+        string_grow(s, old_len + len, arena);
+        if (aliases) { str = string_cstr(s) + offset; }
+    }
+    memmove(string_cstr(s) + old_len, str, len);
+    string_set_len(s, old_len + len);
+}
 
-// NOTE: not valid in MSVC C++
-#define S(str) (string_t) { (sizeof(str)/sizeof(str[0])) - 1, str }
+void string_append_cstr(string_t* s, const char* str, mem_arena_t* arena)
+{
+    string_append(s, str, strlen(str), arena);
+}
 
-//string_t string_string0_to_string(char* str) { return {str, strlen(str)}; };
-//string_t string_slice(string_t string, u32 from, u32 to);
+void string_push(string_t* s, char c, mem_arena_t* arena)
+{
+    string_append(s, &c, 1, arena);
+}
 
-// usage example:
-// string_t hello_world = S("Hello World!");
+void string_clear(string_t* s)
+{
+    string_set_len(s, 0);
+}
+
+string_t string_substr(const string_t* s, u64 from, u64 len, mem_arena_t* arena)
+{
+    u64 s_len = string_len(s);
+    if (from > s_len)       { from = s_len;        }
+    if (len > s_len - from) { len  = s_len - from; }
+    return string_from(string_cstr((string_t*) s) + from, len, arena);
+}
+
+i64 string_find(const string_t* s, const char* needle, u64 needle_len, u64 from)
+{
+    u64         len      = string_len(s);
+    const char* haystack = string_cstr((string_t*) s);
+    if (needle_len == 0)              { return (from <= len) ? (i64) from : -1; }
+    if (needle_len > len)             { return -1; }
+    for (u64 i = from; i <= len - needle_len; i++)
+    {
+        /* look for the first char with memchr, then compare the rest */
+        const char* hit = (const char*) memchr(haystack + i, needle[0], (len - needle_len) - i + 1);
+        if (!hit) { break; }
+        i = hit - haystack;
+        if (memcmp(hit, needle, needle_len) == 0) { return (i64) i; }
+    }
+    return -1;
+}
+
+b32 string_equal(const string_t* a, const string_t* b)
+{
+    u64 len = string_len(a);
+    return (len == string_len(b)) && (memcmp(string_cstr((string_t*) a), string_cstr((string_t*) b), len) == 0);
+}
+#endif // BASIC_IMPLEMENTATION
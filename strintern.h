@@ -0,0 +1,269 @@
+#pragma once
+
+/* string interning: every distinct string is stored exactly once inside a
+ * mem_arena_t and identified by a compact u32 id, i.e. comparing two interned
+ * strings becomes an integer compare and interning a string that is already
+ * in the table doesn't allocate anything.
+ *
+ * The id -> string table reserves STRINTERN_MAX_COUNT entries up front and
+ * commits them as the table grows (same trick as in dynarr.h). Entries never
+ * move, so strintern_get() is O(1) and doesn't need to take the lock even for
+ * thread-safe tables (the count is published with a release store once the
+ * entry is written). The hash index (id lookup by string) is a linear probing
+ * table that is rehashed on growth.
+ *
+ * Id 0 is always the empty string, so zero-initialized ids are valid.
+ */
+
+/* Example usage code:
+
+       mem_arena_t* arena  = mem_arena_create(MEGABYTES(1));
+       strintern_t* names  = strintern_create(arena, 0); // 1 for a thread-safe table
+       strintern_id_t a    = strintern_cstr(names, "player");
+       strintern_id_t b    = strintern(names, "player_01", 6);
+       ASSERT(a == b);
+       printf("%s\n", strintern_get(names, a));
+*/
+
+#ifndef STRINTERN_MAX_COUNT
+  #define STRINTERN_MAX_COUNT   (1 << 22) /* nr of id's that are reserved (not committed) */
+#endif
+#define STRINTERN_INITIAL_SLOTS 256       /* initial size of the hash index, has to be a power of 2 */
+
+typedef u32 strintern_id_t;
+#define STRINTERN_ID_INVALID U32_MAX      /* returned by strintern() when the table can't grow */
+
+struct strintern_t;
+typedef struct strintern_t strintern_t;
+
+/* api */
+strintern_t*   strintern_create (mem_arena_t*  arena, b32 thread_safe); /* string bytes are pushed onto the arena */
+void           strintern_destroy(strintern_t** table);                  /* NOTE: doesn't pop the arena */
+
+strintern_id_t strintern        (strintern_t*  table, const char* str, u64 len); /* STRINTERN_ID_INVALID if out of memory */
+strintern_id_t strintern_cstr   (strintern_t*  table, const char* str);
+b32            strintern_lookup (strintern_t*  table, const char* str, u64 len, strintern_id_t* id); /* doesn't insert */
+
+const char*    strintern_get    (strintern_t*  table, strintern_id_t id); /* NUL-terminated */
+u64            strintern_len    (strintern_t*  table, strintern_id_t id);
+u32            strintern_count  (strintern_t*  table);
+
+u32            strintern_hash   (const char* str, u64 len);
+
+#ifdef BASIC_IMPLEMENTATION
+#if defined(_WIN32)
+  #include <windows.h>
+  typedef SRWLOCK strintern_lock_t;
+  #define STRINTERN_LOCK_INIT(lock)    InitializeSRWLock(lock)
+  #define STRINTERN_LOCK(lock)         AcquireSRWLockExclusive(lock)
+  #define STRINTERN_UNLOCK(lock)       ReleaseSRWLockExclusive(lock)
+  #define STRINTERN_LOCK_DESTROY(lock)
+#else
+  #include <pthread.h>
+  typedef pthread_mutex_t strintern_lock_t;
+  #define STRINTERN_LOCK_INIT(lock)    pthread_mutex_init(lock, NULL)
+  #define STRINTERN_LOCK(lock)         pthread_mutex_lock(lock)
+  #define STRINTERN_UNLOCK(lock)       pthread_mutex_unlock(lock)
+  #define STRINTERN_LOCK_DESTROY(lock) pthread_mutex_destroy(lock)
+#endif
+
+typedef struct strintern_slot_t
+{
+    u32 hash;
+    u32 id_plus_one; /* 0 == empty slot */
+} strintern_slot_t;
+
+struct strintern_t
+{
+    mem_arena_t*      arena;
+    const char**      strings;     /* id -> string, string length is stored as u32 right before it */
+    u32               count;
+    u32               committed;   /* nr of committed entries in strings */
+
+    strintern_slot_t* slots;       /* hash index */
+    u32               slot_mask;   /* slot count - 1 */
+
+    b32               thread_safe;
+    strintern_lock_t  lock;
+};
+
+u32 strintern_hash(const char* str, u64 len)
+{
+    /* multiply-xorshift over 8 bytes at a time */
+    u64 h = 0x9E3779B97F4A7C15ull ^ len;
+    while (len >= 8)
+    {
+        u64 k; memcpy(&k, str, 8);
+        h    = (h ^ k) * 0xFF51AFD7ED558CCDull;
+        h   ^= h >> 32;
+        str += 8;
+        len -= 8;
+    }
+    u64 k = 0; memcpy(&k, str, len);
+    h  = (h ^ k) * 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 29;
+    return (u32) (h ^ (h >> 32));
+}
+
+static u64 strintern_entry_len(const char* string)
+{
+    u32 len; memcpy(&len, string - sizeof(u32), sizeof(u32));
+    return len;
+}
+
+static void strintern_index_insert(strintern_slot_t* slots, u32 slot_mask, u32 hash, u32 id)
+{
+    u32 idx = hash & slot_mask;
+    while (slots[idx].id_plus_one) { idx = (idx + 1) & slot_mask; }
+    slots[idx].hash        = hash;
+    slots[idx].id_plus_one = id + 1;
+}
+
+static b32 strintern_index_grow(strintern_t* table)
+{
+    u32 old_mask = table->slot_mask;
+    u32 new_mask = (old_mask << 1) | 1;
+    strintern_slot_t* slots = (strintern_slot_t*) mem_alloc(sizeof(strintern_slot_t) * (new_mask + 1));
+    MEM_ASSERT(slots);
+    if (!slots) { return 0; }
+    for (u32 i = 0; i <= old_mask; i++)
+    {
+        if (table->slots[i].id_plus_one)
+        {
+            strintern_index_insert(slots, new_mask, table->slots[i].hash, table->slots[i].id_plus_one - 1);
+        }
+    }
+    mem_free(table->slots);
+    table->slots     = slots;
+    table->slot_mask = new_mask;
+    return 1;
+}
+
+/* returns the slot the string is in or the empty slot it would go into */
+static strintern_slot_t* strintern_index_find(strintern_t* table, const char* str, u64 len, u32 hash)
+{
+    u32 idx = hash & table->slot_mask;
+    for (;;)
+    {
+        strintern_slot_t* slot = &table->slots[idx];
+        if (!slot->id_plus_one) { return slot; }
+        if (slot->hash == hash)
+        {
+            const char* string = table->strings[slot->id_plus_one - 1];
+            if (strintern_entry_len(string) == len && memcmp(string, str, len) == 0) { return slot; }
+        }
+        idx = (idx + 1) & table->slot_mask;
+    }
+}
+
+static strintern_id_t strintern_insert(strintern_t* table, const char* str, u64 len, u32 hash)
+{
+    MEM_ASSERT(len <= U32_MAX);
+    MEM_ASSERT(table->count < STRINTERN_MAX_COUNT && "Ran out of interned string ids");
+    if (len > U32_MAX || table->count >= STRINTERN_MAX_COUNT) { return STRINTERN_ID_INVALID; }
+
+    /* commit more of the id table if needed */
+    if (table->count == table->committed)
+    {
+        u32 grow_by   = (u32) (mem_pagesize() / sizeof(char*));
+        int committed = mem_commit((void*) (table->strings + table->committed), grow_by * sizeof(char*));
+        MEM_ASSERT(committed);
+        if (!committed) { return STRINTERN_ID_INVALID; }
+        table->committed += grow_by;
+    }
+
+    /* keep load factor below 3/4 */
+    if (((table->count + 1) * 4) >= ((table->slot_mask + 1) * 3) && !strintern_index_grow(table)) { return STRINTERN_ID_INVALID; }
+
+    /* string bytes: u32 length + string + NUL */
+    char* entry = (char*) mem_arena_push(table->arena, sizeof(u32) + len + 1);
+    if (!entry) { return STRINTERN_ID_INVALID; }
+    u32 len_u32 = (u32) len;
+    memcpy(entry, &len_u32, sizeof(u32));
+    memcpy(entry + sizeof(u32), str, len);
+    entry[sizeof(u32) + len] = '\0';
+
+    strintern_id_t id   = table->count;
+    table->strings[id]  = entry + sizeof(u32);
+    atomic_store_u32(&table->count, id + 1, ATOMIC_RELEASE); /* lock-free readers see the entry first */
+    strintern_index_insert(table->slots, table->slot_mask, hash, id);
+
+    return id;
+}
+
+strintern_t* strintern_create(mem_arena_t* arena, b32 thread_safe)
+{
+    /* NOTE: not pushed onto the arena, string bytes leave it unaligned */
+    strintern_t* table = (strintern_t*) mem_alloc(sizeof(strintern_t));
+    MEM_ASSERT(table);
+    table->arena       = arena;
+    table->strings     = (const char**) mem_reserve(NULL, STRINTERN_MAX_COUNT * sizeof(char*));
+    table->count       = 0;
+    table->committed   = 0;
+    table->slots       = (strintern_slot_t*) mem_alloc(sizeof(strintern_slot_t) * STRINTERN_INITIAL_SLOTS);
+    table->slot_mask   = STRINTERN_INITIAL_SLOTS - 1;
+    table->thread_safe = thread_safe;
+    MEM_ASSERT(table->strings && table->slots);
+    if (thread_safe) { STRINTERN_LOCK_INIT(&table->lock); }
+
+    /* id 0 is the empty string */
+    strintern_insert(table, "", 0, strintern_hash("", 0));
+
+    return table;
+}
+
+void strintern_destroy(strintern_t** table)
+{
+    if ((*table)->thread_safe) { STRINTERN_LOCK_DESTROY(&(*table)->lock); }
+    mem_release((void*) (*table)->strings, STRINTERN_MAX_COUNT * sizeof(char*));
+    mem_free((*table)->slots);
+    mem_free(*table);
+    *table = NULL;
+}
+
+strintern_id_t strintern(strintern_t* table, const char* str, u64 len)
+{
+    u32 hash = strintern_hash(str, len);
+    if (table->thread_safe) { STRINTERN_LOCK(&table->lock); }
+
+    strintern_id_t id;
+    strintern_slot_t* slot = strintern_index_find(table, str, len, hash);
+    if (slot->id_plus_one) { id = slot->id_plus_one - 1;                        }
+    else                   { id = strintern_insert(table, str, len, hash); }
+
+    if (table->thread_safe) { STRINTERN_UNLOCK(&table->lock); }
+    return id;
+}
+
+strintern_id_t strintern_cstr(strintern_t* table, const char* str)
+{
+    return strintern(table, str, strlen(str));
+}
+
+b32 strintern_lookup(strintern_t* table, const char* str, u64 len, strintern_id_t* id)
+{
+    u32 hash = strintern_hash(str, len);
+    if (table->thread_safe) { STRINTERN_LOCK(&table->lock); }
+
+    strintern_slot_t* slot = strintern_index_find(table, str, len, hash);
+    b32 found = (slot->id_plus_one != 0);
+    if (found && id) { *id = slot->id_plus_one - 1; }
+
+    if (table->thread_safe) { STRINTERN_UNLOCK(&table->lock); }
+    return found;
+}
+
+const char* strintern_get(strintern_t* table, strintern_id_t id)
+{
+    u32 count = atomic_load_u32(&table->count, ATOMIC_ACQUIRE);
+    MEM_ASSERT(id < count); (void) count;
+    return table->strings[id];
+}
+
+u64 strintern_len(strintern_t* table, strintern_id_t id)
+{
+    return strintern_entry_len(strintern_get(table, id));
+}
+
+u32 strintern_count(strintern_t* table) { return atomic_load_u32(&table->count, ATOMIC_ACQUIRE); }
+#endif // BASIC_IMPLEMENTATION
@@ -0,0 +1,14 @@
+#!/bin/bash
+# builds & runs the benchmarks (optimized, with asserts), pass an item count
+# to override the default, e.g.: ./bench.sh 100000
+
+INCLUDES="-I ./ -I .."
+
+set -e
+mkdir -p bin
+
+printf "\nqueue.h:\n"
+gcc -O2 -DBUILD_DEBUG ${INCLUDES} -std=gnu11 bench_queue.c -o bin/bench_queue -lm -lpthread && ./bin/bench_queue "$@"
+
+printf "\nplatform/aio.h:\n"
+gcc -O2 -DBUILD_DEBUG ${INCLUDES} -std=gnu11 bench_io.c -o bin/bench_io -lm -lpthread && ./bin/bench_io "$@"
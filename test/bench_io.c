@@ -0,0 +1,226 @@
+/* platform/aio.h benchmarks: loading many small files & one large file with
+ * blocking fread vs. io_uring vs. the thread pool fallback. On linux the page
+ * cache is dropped for the files before every run (posix_fadvise) so the reads
+ * actually go to the disk. Build & run with bench.sh, pass a file count & the
+ * size of the large file in MB to override the defaults */
+#define LOG_USE_DEF_FILE
+#define LOG_ENTRY_FILE "log_entries.h"
+#define BASIC_IMPLEMENTATION
+#include "../basic/basic.h"
+
+#include <stdlib.h> /* for atoi */
+#if defined(PLATFORM_WIN32)
+  #include <direct.h> /* for _mkdir, _rmdir */
+  #define bench_mkdir(path) _mkdir(path)
+  #define bench_rmdir(path) _rmdir(path)
+#else
+  #include <sys/stat.h> /* for mkdir */
+  #define bench_mkdir(path) mkdir(path, 0755)
+  #define bench_rmdir(path) rmdir(path)
+#endif
+
+#define BENCH_DIR        "bench_io_data"
+#define BENCH_SMALL_MAX  KILOBYTES(16) /* small files are 512B-16KB */
+#define BENCH_CHUNK      MEGABYTES(1)  /* large file read size */
+#define BENCH_DEPTH      256
+
+typedef struct bench_files_t
+{
+    u32   count;
+    char  (*paths)[64];
+    u32*  sizes;
+    u8*   buffers;     /* count * BENCH_SMALL_MAX, page aligned */
+    u64   large_size;
+    u8*   large_buffer;
+} bench_files_t;
+
+static void* bench_alloc(u64 size) /* page aligned, for O_DIRECT */
+{
+    void* mem = mem_reserve(NULL, size);
+    ASSERT(mem && mem_commit(mem, size));
+    return mem;
+}
+
+/* evicts the files from the page cache, so the next run reads from disk */
+static void bench_drop_cache(const char* path)
+{
+#if defined(PLATFORM_LINUX)
+    platform_aio_file_t file = platform_aio_open(path, 0);
+    if (file == PLATFORM_AIO_INVALID_FILE) { return; }
+    posix_fadvise((int) file, 0, 0, POSIX_FADV_DONTNEED);
+    platform_aio_close(file);
+#else
+    (void) path;
+#endif
+}
+
+static void bench_drop_caches(bench_files_t* f)
+{
+    for (u32 i = 0; i < f->count; i++) { bench_drop_cache(f->paths[i]); }
+    bench_drop_cache(BENCH_DIR "/large.bin");
+}
+
+static void bench_create_files(bench_files_t* f)
+{
+    bench_mkdir(BENCH_DIR);
+    u8* data = f->buffers; /* contents don't matter */
+    for (u32 i = 0; i < BENCH_SMALL_MAX; i++) { data[i] = (u8) i; }
+    u64 rng = 0x9E3779B97F4A7C15ull;
+    for (u32 i = 0; i < f->count; i++)
+    {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        f->sizes[i] = 512 + (u32) (rng % (BENCH_SMALL_MAX - 512));
+        snprintf(f->paths[i], sizeof(f->paths[i]), BENCH_DIR "/small_%05u.bin", i);
+        FILE* file = fopen(f->paths[i], "wb");
+        ASSERT(file && fwrite(data, 1, f->sizes[i], file) == f->sizes[i]);
+        fclose(file);
+    }
+    FILE* file = fopen(BENCH_DIR "/large.bin", "wb");
+    ASSERT(file);
+    for (u64 written = 0; written < f->large_size; written += BENCH_SMALL_MAX) { fwrite(data, 1, BENCH_SMALL_MAX, file); }
+    fclose(file);
+}
+
+static void bench_remove_files(bench_files_t* f)
+{
+    for (u32 i = 0; i < f->count; i++) { remove(f->paths[i]); }
+    remove(BENCH_DIR "/large.bin");
+    bench_rmdir(BENCH_DIR);
+}
+
+static void bench_report(const char* name, u64 files, u64 bytes, u64 ns)
+{
+    printf("%-28s %6llu files, %8.2f MB in %8.2f ms: %9.0f files/s, %8.2f MB/s\n", name, (unsigned long long) files,
+           (f64) bytes / (1024.0 * 1024.0), (f64) ns / 1e6, (f64) files * 1e9 / (f64) ns, (f64) bytes * 1e9 / (1024.0 * 1024.0 * (f64) ns));
+}
+
+/* what the asset loader does today: fopen, fread, fclose per file */
+static void bench_small_fread(bench_files_t* f)
+{
+    bench_drop_caches(f);
+    u64 bytes = 0, start = platform_time_ns();
+    for (u32 i = 0; i < f->count; i++)
+    {
+        FILE* file = fopen(f->paths[i], "rb");
+        bytes += fread(f->buffers + (u64) i * BENCH_SMALL_MAX, 1, BENCH_SMALL_MAX, file);
+        fclose(file);
+    }
+    bench_report("small, fread", f->count, bytes, platform_time_ns() - start);
+}
+
+/* keeps BENCH_DEPTH reads in flight, files are closed as their read completes */
+static void bench_small_aio(bench_files_t* f, u32 flags, const char* name)
+{
+    platform_aio_t aio;
+    ASSERT(platform_aio_init(&aio, BENCH_DEPTH, flags));
+    platform_aio_file_t* files = (platform_aio_file_t*) calloc(f->count, sizeof(platform_aio_file_t));
+    bench_drop_caches(f);
+
+    u64 bytes = 0, start = platform_time_ns();
+    u32 next  = 0, done = 0;
+    platform_aio_completion_t completions[BENCH_DEPTH];
+    while (done < f->count)
+    {
+        platform_aio_request_t reqs[BENCH_DEPTH];
+        u32 count = 0;
+        for (; next + count < f->count && count < BENCH_DEPTH - aio.in_flight; count++)
+        {
+            u32 i    = next + count;
+            files[i] = platform_aio_open(f->paths[i], 0);
+            reqs[count] = platform_aio_read(files[i], f->buffers + (u64) i * BENCH_SMALL_MAX, BENCH_SMALL_MAX, 0, i);
+        }
+        next += platform_aio_submit(&aio, reqs, count);
+        u32 n = platform_aio_wait(&aio, completions, BENCH_DEPTH, 1);
+        for (u32 j = 0; j < n; j++)
+        {
+            ASSERT(completions[j].result == f->sizes[completions[j].user_data]);
+            bytes += (u64) completions[j].result;
+            platform_aio_close(files[completions[j].user_data]);
+        }
+        done += n;
+    }
+    bench_report(name, f->count, bytes, platform_time_ns() - start);
+    platform_aio_destroy(&aio);
+    free(files);
+}
+
+static void bench_large_fread(bench_files_t* f)
+{
+    bench_drop_caches(f);
+    u64 bytes = 0, start = platform_time_ns();
+    FILE* file = fopen(BENCH_DIR "/large.bin", "rb");
+    for (u64 n; (n = fread(f->large_buffer + bytes, 1, BENCH_CHUNK, file)) > 0;) { bytes += n; }
+    fclose(file);
+    ASSERT(bytes == f->large_size);
+    bench_report("large, fread 1MB", 1, bytes, platform_time_ns() - start);
+}
+
+/* 1MB chunks, 32 in flight */
+static void bench_large_aio(bench_files_t* f, u32 flags, u32 open_flags, b32 registered, const char* name)
+{
+    platform_aio_t aio;
+    ASSERT(platform_aio_init(&aio, 32, flags));
+    if (registered)
+    {
+        void* buffers[1] = { f->large_buffer };
+        u64   sizes[1]   = { f->large_size + BENCH_CHUNK };
+        if (!platform_aio_register_buffers(&aio, buffers, sizes, 1)) { registered = 0; name = "large, aio direct (unpinned)"; }
+    }
+    bench_drop_caches(f);
+
+    u64 bytes = 0, start = platform_time_ns();
+    platform_aio_file_t file = platform_aio_open(BENCH_DIR "/large.bin", open_flags);
+    if (file == PLATFORM_AIO_INVALID_FILE) { printf("%-28s not supported here\n", name); platform_aio_destroy(&aio); return; }
+    u64 chunks = (f->large_size + BENCH_CHUNK - 1) / BENCH_CHUNK;
+    u64 next   = 0, done = 0;
+    platform_aio_completion_t completions[32];
+    while (done < chunks)
+    {
+        platform_aio_request_t reqs[32];
+        u32 count = 0;
+        for (; next + count < chunks && count < 32 - aio.in_flight; count++)
+        {
+            u64 offset  = (next + count) * BENCH_CHUNK;
+            reqs[count] = platform_aio_read(file, f->large_buffer + offset, BENCH_CHUNK, offset, next + count);
+            if (registered) { reqs[count].buffer_index = 0; }
+        }
+        next += platform_aio_submit(&aio, reqs, count);
+        u32 n = platform_aio_wait(&aio, completions, 32, 1);
+        for (u32 j = 0; j < n; j++) { ASSERT(completions[j].result > 0); bytes += (u64) completions[j].result; }
+        done += n;
+    }
+    platform_aio_close(file);
+    ASSERT(bytes == f->large_size);
+    bench_report(name, 1, bytes, platform_time_ns() - start);
+    platform_aio_destroy(&aio);
+}
+
+int main(int argc, char** argv)
+{
+    bench_files_t f = {0};
+    f.count        = (argc > 1) ? (u32) atoi(argv[1]) : 10000;
+    f.large_size   = (u64) ((argc > 2) ? atoi(argv[2]) : 256) * MEGABYTES(1);
+    f.paths        = (char (*)[64]) calloc(f.count, 64);
+    f.sizes        = (u32*) calloc(f.count, sizeof(u32));
+    f.buffers      = (u8*) bench_alloc((u64) f.count * BENCH_SMALL_MAX);
+    f.large_buffer = (u8*) bench_alloc(f.large_size + BENCH_CHUNK); /* the last chunk reads past the end */
+    printf("%u small files, large file: %llu MB\n", f.count, (unsigned long long) (f.large_size / MEGABYTES(1)));
+    bench_create_files(&f);
+
+    platform_aio_t probe;
+    platform_aio_init(&probe, 1, 0);
+    b32 uring = (probe.backend == PLATFORM_AIO_BACKEND_URING);
+    platform_aio_destroy(&probe);
+    if (!uring) { printf("io_uring not available, aio uses the thread pool\n"); }
+
+    bench_small_fread(&f);
+    bench_small_aio(&f, 0,                          uring ? "small, aio io_uring" : "small, aio threads");
+    bench_small_aio(&f, PLATFORM_AIO_FORCE_THREADS, "small, aio threads");
+    bench_large_fread(&f);
+    bench_large_aio(&f, 0,                          0, 0, uring ? "large, aio io_uring" : "large, aio threads");
+    bench_large_aio(&f, PLATFORM_AIO_FORCE_THREADS, 0, 0, "large, aio threads");
+    bench_large_aio(&f, 0, PLATFORM_AIO_OPEN_DIRECT, uring, uring ? "large, aio direct + pinned" : "large, aio direct");
+
+    bench_remove_files(&f);
+    return 0;
+}
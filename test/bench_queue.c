@@ -0,0 +1,216 @@
+/* queue.h benchmarks: throughput for 1-64 producers/consumers & round trip
+ * latency (ping-pong between two threads). Build & run with bench.sh */
+#define LOG_USE_DEF_FILE
+#define LOG_ENTRY_FILE "log_entries.h"
+#define BASIC_IMPLEMENTATION
+#include "../basic/basic.h"
+
+#include <stdlib.h> /* for atoi, calloc */
+
+#define BENCH_MAX_THREADS 64
+
+typedef struct bench_node_t { queue_node_t node; u64 value; } bench_node_t;
+
+typedef struct bench_t
+{
+    queue_spsc_t*     spsc;
+    queue_mpsc_t      mpsc;
+    queue_mpmc_t*     mpmc;
+    bench_node_t*     nodes;        /* mpsc: items_per_producer per producer */
+    u64               items_per_producer;
+    u32               producers;
+    u32               next_id;
+    u64               consumed;
+    platform_event_t  start;
+} bench_t;
+
+static void bench_spsc_producer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    platform_event_wait(&b->start);
+    u64 batch[16];
+    for (u64 i = 0; i < b->items_per_producer;)
+    {
+        u64 n = 0;
+        for (; n < 16 && i + n < b->items_per_producer; n++) { batch[n] = i + n; }
+        u64 pushed = queue_spsc_push_n(b->spsc, batch, n);
+        if (!pushed) { platform_yield(); }
+        i += pushed;
+    }
+}
+
+static void bench_spsc_consumer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    platform_event_wait(&b->start);
+    u64 batch[16];
+    for (u64 total = 0; total < b->items_per_producer;)
+    {
+        u64 n = queue_spsc_pop_n(b->spsc, batch, 16);
+        if (!n) { platform_yield(); }
+        total += n;
+    }
+}
+
+static void bench_mpsc_producer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    u32 id = atomic_fetch_add_u32(&b->next_id, 1, ATOMIC_RELAXED);
+    bench_node_t* nodes = b->nodes + id * b->items_per_producer;
+    platform_event_wait(&b->start);
+    for (u64 i = 0; i < b->items_per_producer; i++) { queue_mpsc_push(&b->mpsc, &nodes[i].node); }
+}
+
+static void bench_mpsc_consumer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    platform_event_wait(&b->start);
+    for (u64 total = 0; total < b->items_per_producer * b->producers;)
+    {
+        if (queue_mpsc_pop(&b->mpsc)) { total++; }
+        else                          { platform_yield(); }
+    }
+}
+
+static void bench_mpmc_producer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    platform_event_wait(&b->start);
+    for (u64 i = 0; i < b->items_per_producer; i++)
+    {
+        while (!queue_mpmc_push(b->mpmc, &i)) { platform_yield(); }
+    }
+}
+
+static void bench_mpmc_consumer(void* arg)
+{
+    bench_t* b = (bench_t*) arg;
+    u64 total = b->items_per_producer * b->producers;
+    platform_event_wait(&b->start);
+    while (atomic_load_u64(&b->consumed, ATOMIC_RELAXED) < total)
+    {
+        u64 vals[16];
+        u64 n = queue_mpmc_pop_n(b->mpmc, vals, 16);
+        if (n) { atomic_fetch_add_u64(&b->consumed, n, ATOMIC_RELAXED); }
+        else   { platform_yield(); }
+    }
+}
+
+/* starts all threads, releases them at once & returns the elapsed ns */
+static u64 bench_run(bench_t* b, platform_thread_func_t producer, u32 producers, platform_thread_func_t consumer, u32 consumers)
+{
+    platform_thread_t threads[BENCH_MAX_THREADS];
+    u32 count = 0;
+    for (u32 i = 0; i < producers; i++) { ASSERT(platform_thread_create(&threads[count++], producer, b, NULL)); }
+    for (u32 i = 0; i < consumers; i++) { ASSERT(platform_thread_create(&threads[count++], consumer, b, NULL)); }
+    u64 start = platform_time_ns();
+    platform_event_set(&b->start);
+    for (u32 i = 0; i < count; i++) { platform_thread_join(&threads[i]); }
+    return platform_time_ns() - start;
+}
+
+static void bench_report(const char* name, u32 producers, u32 consumers, u64 items, u64 ns)
+{
+    printf("%-5s %2uP x %2uC: %10llu items in %8.2f ms, %8.2f Mitems/s\n", name, producers, consumers,
+           (unsigned long long) items, (f64) ns / 1e6, (f64) items * 1e3 / (f64) ns);
+}
+
+/* spin first (latency), yield once the other side looks descheduled (fewer cpus than threads) */
+static void bench_backoff(u32* spins)
+{
+    if (++*spins < 1000) { platform_cpu_relax(); }
+    else                 { platform_yield(); }
+}
+
+/* latency: ping-pong one value through two queues, round trip time per message */
+typedef struct bench_pingpong_t
+{
+    queue_spsc_t* spsc[2];
+    queue_mpmc_t* mpmc[2];
+    b32           use_mpmc;
+    u64           rounds;
+} bench_pingpong_t;
+
+static void bench_pong(void* arg)
+{
+    bench_pingpong_t* p = (bench_pingpong_t*) arg;
+    for (u64 i = 0; i < p->rounds; i++)
+    {
+        u64 v;
+        u32 spins = 0;
+        if (p->use_mpmc) { while (!queue_mpmc_pop(p->mpmc[0], &v)) { bench_backoff(&spins); } queue_mpmc_push(p->mpmc[1], &v); }
+        else             { while (!queue_spsc_pop(p->spsc[0], &v)) { bench_backoff(&spins); } queue_spsc_push(p->spsc[1], &v); }
+    }
+}
+
+static void bench_latency(const char* name, bench_pingpong_t* p, metrics_histogram_t* hist)
+{
+    platform_thread_t pong;
+    ASSERT(platform_thread_create(&pong, bench_pong, p, NULL));
+    for (u64 i = 0; i < p->rounds; i++)
+    {
+        u64 v = i, start = platform_time_ns();
+        u32 spins = 0;
+        if (p->use_mpmc) { queue_mpmc_push(p->mpmc[0], &v); while (!queue_mpmc_pop(p->mpmc[1], &v)) { bench_backoff(&spins); } }
+        else             { queue_spsc_push(p->spsc[0], &v); while (!queue_spsc_pop(p->spsc[1], &v)) { bench_backoff(&spins); } }
+        metrics_histogram_record(hist, platform_time_ns() - start);
+    }
+    platform_thread_join(&pong);
+    printf("%-5s round trip: p50 %6llu ns, p99 %6llu ns, p999 %6llu ns\n", name,
+           (unsigned long long) metrics_histogram_percentile(hist, 50.0),
+           (unsigned long long) metrics_histogram_percentile(hist, 99.0),
+           (unsigned long long) metrics_histogram_percentile(hist, 99.9));
+}
+
+int main(int argc, char** argv)
+{
+    u64 items = (argc > 1) ? (u64) atoi(argv[1]) : 1000000; /* per run, split over the producers */
+    mem_arena_t* arena = mem_arena_create(MEGABYTES(64));
+    printf("%llu items per run\n", (unsigned long long) items);
+
+    /* throughput */
+    {
+        bench_t* b = (bench_t*) calloc(1, sizeof(bench_t));
+        b->items_per_producer = items;
+        b->spsc               = queue_spsc_create(4096, sizeof(u64), arena);
+        bench_report("spsc", 1, 1, items, bench_run(b, bench_spsc_producer, 1, bench_spsc_consumer, 1));
+        free(b);
+    }
+    for (u32 producers = 1; producers < BENCH_MAX_THREADS; producers *= 2)
+    {
+        bench_t* b = (bench_t*) calloc(1, sizeof(bench_t));
+        b->items_per_producer = items / producers;
+        b->producers          = producers;
+        b->nodes              = (bench_node_t*) calloc(b->items_per_producer * producers, sizeof(bench_node_t));
+        queue_mpsc_init(&b->mpsc);
+        u64 ns = bench_run(b, bench_mpsc_producer, producers, bench_mpsc_consumer, 1);
+        bench_report("mpsc", producers, 1, b->items_per_producer * producers, ns);
+        free(b->nodes);
+        free(b);
+    }
+    for (u32 threads = 1; threads <= BENCH_MAX_THREADS / 2; threads *= 2)
+    {
+        bench_t* b = (bench_t*) calloc(1, sizeof(bench_t));
+        b->items_per_producer = items / threads;
+        b->producers          = threads;
+        b->mpmc               = queue_mpmc_create(4096, sizeof(u64), NULL);
+        u64 ns = bench_run(b, bench_mpmc_producer, threads, bench_mpmc_consumer, threads);
+        bench_report("mpmc", threads, threads, b->items_per_producer * threads, ns);
+        queue_mpmc_destroy(&b->mpmc);
+        free(b);
+    }
+
+    /* latency */
+    bench_pingpong_t p = {0};
+    p.rounds  = (items < 100000) ? items : 100000;
+    p.spsc[0] = queue_spsc_create(16, sizeof(u64), arena);
+    p.spsc[1] = queue_spsc_create(16, sizeof(u64), arena);
+    p.mpmc[0] = queue_mpmc_create(16, sizeof(u64), arena);
+    p.mpmc[1] = queue_mpmc_create(16, sizeof(u64), arena);
+    bench_latency("spsc", &p, metrics_histogram("bench.spsc.rtt_ns"));
+    p.use_mpmc = 1;
+    bench_latency("mpmc", &p, metrics_histogram("bench.mpmc.rtt_ns"));
+
+    mem_arena_destroy(&arena);
+    return 0;
+}
@@ -37,6 +37,9 @@ clang -g ${INCLUDES} -std=c11 test.c -o bin/test_clang && ./bin/test_clang
 printf "\ngcc c99 (32bit):\n"
 gcc -g ${INCLUDES} -m32 -DBUILD_DEBUG -std=c99 -O2 test.c -o bin/test_gcc && ./bin/test_gcc
 
+printf "\ngcc c11 (NDEBUG, MEM_ASSERT compiled out):\n"
+gcc -g ${INCLUDES} -DBUILD_DEBUG -DNDEBUG -std=c11 -O2 test.c -o bin/test_gcc_ndebug && ./bin/test_gcc_ndebug
+
 printf "\nmingw-g++:\n"
 x86_64-w64-mingw32-g++ -g ${INCLUDES} test.c -o bin/test_mingwxx && WINEDEBUG=-all wine ./bin/test_mingwxx.exe
 
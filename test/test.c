@@ -4,9 +4,21 @@
 #ifdef __MINGW32__
       #define LOG_USE_NO_COLOR
 #endif
+#define LOG_COMPILE_MASK (LOG_EVERYTHING & ~LOG_SEVERITY_TRACE)
+#ifndef __TINYC__
+      #define LOG_USE_ASYNC
+      #define LOG_USE_BINARY
+      #define LOG_USE_SINKS
+#endif
+#define ENABLE_PROFILING
 #define BASIC_IMPLEMENTATION
 #include "../basic/basic.h"
 #include "../basic/basic.h" // testing double include
+#if defined(LOG_USE_SINKS) && !defined(_WIN32)
+  #include <sys/socket.h> /* for testing the socket log sink */
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
 
 /* NOTE invalid sizes on 32bit arch */
 #define RES_MEM_ENTITIES    ALIGN_TO_NEXT_PAGE(GIGABYTES(4))
@@ -43,6 +55,204 @@ const u64 MEMORY_OVERALL = MEMORY_GAME MEMORY_RENDERER + 0;
 int log_verbosity_level = LOG_EVERYTHING;
 
 
+typedef struct test_atomics_t
+{
+    u64   counter;                  /* fetch_add */
+    u32   cas_counter;              /* cas loop */
+    u32   flags;                    /* fetch_or, one bit per thread */
+    CACHE_LINE_PAD(sizeof(u64) + 2 * sizeof(u32));
+    u64   payload;                  /* plain write, published through ready */
+    void* ready;
+} test_atomics_t;
+
+static void test_atomics_thread(void* arg)
+{
+    static u32 next_bit = 0;
+    test_atomics_t* t = (test_atomics_t*) arg;
+    u32 bit = atomic_fetch_add_u32(&next_bit, 1, ATOMIC_RELAXED);
+    for (u32 i = 0; i < 10000; i++)
+    {
+        atomic_fetch_add_u64(&t->counter, 1, ATOMIC_RELAXED);
+        u32 expected = atomic_load_u32(&t->cas_counter, ATOMIC_RELAXED);
+        while (!atomic_cas_weak_u32(&t->cas_counter, &expected, expected + 1, ATOMIC_RELAXED)) {}
+    }
+    atomic_fetch_or_u32(&t->flags, 1u << bit, ATOMIC_RELEASE);
+
+    /* message passing: acquire load sees the payload written before the release store */
+    if (bit == 0) { t->payload = 42; atomic_store_ptr(&t->ready, t, ATOMIC_RELEASE); }
+    else
+    {
+        while (!atomic_load_ptr(&t->ready, ATOMIC_ACQUIRE)) { platform_yield(); }
+        ASSERT(t->payload == 42);
+    }
+}
+
+typedef struct test_jobs_t
+{
+    u32  ran;          /* nr of leaf jobs that ran */
+    u32  nested;       /* nr of jobs that spawned & waited for children */
+    u8*  visited;      /* parallel_for: every index exactly once */
+    u64  sum;
+} test_jobs_t;
+
+static void test_job_leaf(void* arg)
+{
+    test_jobs_t* t = (test_jobs_t*) arg;
+    ASSERT(job_scratch_arena() != NULL);
+    u64* tmp = ARENA_PUSH_ARRAY(job_scratch_arena(), u64, 16); /* popped after the job */
+    tmp[0] = 1;
+    atomic_fetch_add_u32(&t->ran, (u32) tmp[0], ATOMIC_RELAXED);
+}
+
+static void test_job_nested(void* arg)
+{
+    test_jobs_t* t = (test_jobs_t*) arg;
+    job_counter_t children = {0};
+    for (int i = 0; i < 8; i++) { job_run(test_job_leaf, t, &children); }
+    job_wait(&children);
+    atomic_fetch_add_u32(&t->nested, 1, ATOMIC_RELAXED);
+}
+
+static void test_job_range(void* arg, u64 begin, u64 end)
+{
+    test_jobs_t* t = (test_jobs_t*) arg;
+    ASSERT(end - begin <= 1000);
+    u64 sum = 0;
+    for (u64 i = begin; i < end; i++) { t->visited[i]++; sum += i; }
+    atomic_fetch_add_u64(&t->sum, sum, ATOMIC_RELAXED);
+}
+
+typedef struct test_queue_msg_t
+{
+    queue_node_t node;  /* for the mpsc queue */
+    u32          producer;
+    u32          seq;
+} test_queue_msg_t;
+
+typedef struct test_queues_t
+{
+    queue_spsc_t*    spsc;
+    queue_mpsc_t     mpsc;
+    queue_mpmc_t*    mpmc;
+    test_queue_msg_t msgs[4][1000]; /* mpsc nodes, one array per producer */
+    u32              producer_idx;
+    u64              mpmc_sum;      /* consumed by the mpmc consumers */
+    u32              mpmc_popped;
+} test_queues_t;
+
+static void test_queue_spsc_producer(void* arg)
+{
+    test_queues_t* t = (test_queues_t*) arg;
+    u32 batch[7];
+    for (u32 i = 0; i < 20000;)
+    {
+        u32 n = 0;
+        for (; n < 7 && i + n < 20000; n++) { batch[n] = i + n; }
+        u64 pushed = queue_spsc_push_n(t->spsc, batch, n);
+        if (!pushed) { platform_yield(); }
+        i += (u32) pushed;
+    }
+}
+
+static void test_queue_mpsc_producer(void* arg)
+{
+    test_queues_t* t = (test_queues_t*) arg;
+    u32 idx = atomic_fetch_add_u32(&t->producer_idx, 1, ATOMIC_RELAXED);
+    for (u32 i = 0; i < 1000; i++)
+    {
+        test_queue_msg_t* msg = &t->msgs[idx][i];
+        msg->producer = idx;
+        msg->seq      = i;
+        queue_mpsc_push(&t->mpsc, &msg->node);
+    }
+}
+
+static void test_queue_mpmc_producer(void* arg)
+{
+    test_queues_t* t = (test_queues_t*) arg;
+    for (u64 i = 1; i <= 5000; i++)
+    {
+        while (!queue_mpmc_push(t->mpmc, &i)) { platform_yield(); }
+    }
+}
+
+static void test_queue_mpmc_consumer(void* arg)
+{
+    test_queues_t* t = (test_queues_t*) arg;
+    while (atomic_load_u32(&t->mpmc_popped, ATOMIC_ACQUIRE) < 2 * 5000)
+    {
+        u64 vals[4];
+        u64 n = queue_mpmc_pop_n(t->mpmc, vals, 4);
+        for (u64 i = 0; i < n; i++) { atomic_fetch_add_u64(&t->mpmc_sum, vals[i], ATOMIC_RELAXED); }
+        if (n) { atomic_fetch_add_u32(&t->mpmc_popped, (u32) n, ATOMIC_RELEASE); }
+        else   { platform_yield(); }
+    }
+}
+
+#if defined(LOG_USE_BINARY)
+static void test_log_binary_thread(void* arg)
+{
+    u32* started = (u32*) arg;
+    atomic_fetch_add_u32(started, 1, ATOMIC_RELEASE);
+    for (int i = 0; i < 50; i++) { LOG(INFO|MEMORY, "binary from a thread %d", i); }
+}
+#endif
+
+#if defined(LOG_USE_ASYNC)
+static void test_log_async_thread(void* arg)
+{
+    u32* started = (u32*) arg;
+    atomic_fetch_add_u32(started, 1, ATOMIC_RELEASE);
+    for (int i = 0; i < 50; i++) { LOG(INFO|MEMORY, "async from a thread %d", i); }
+}
+#endif
+
+static void test_strintern_thread(void* arg)
+{
+    strintern_t* table = (strintern_t*) arg;
+    char name[32];
+    for (int i = 0; i < 1000; i++) { strintern(table, name, (u64) snprintf(name, sizeof(name), "tag_%d", i)); }
+}
+
+static void test_thread_arena(void* arg)
+{
+    mem_arena_t* arena = mem_arena_thread();
+    ASSERT(arena == mem_arena_thread() && arena != mem_arena_default());
+    ARENA_PUSH_ARRAY(arena, u64, 1024);
+    *(mem_arena_t**) arg = arena;
+}
+
+typedef struct test_walk_t
+{
+    mem_arena_t* arena; /* for the file contents */
+    mem_arena_t* keep;  /* optional: a copy of every directory's name is pushed here */
+    u32          files;
+    u32          dirs;
+    u64          bytes;
+    b32          skip_b;
+    u32          stop_after;
+} test_walk_t;
+
+static file_walk_e test_walk_entry(void* user, str8 path, const file_dir_entry_t* entry)
+{
+    test_walk_t* t = (test_walk_t*) user;
+    ASSERT(str8_ends_with(path, entry->name) && path.ptr[path.len] == 0);
+    if (entry->type == FILE_TYPE_DIRECTORY)
+    {
+        t->dirs++;
+        if (t->keep) { str8_copy(t->keep, entry->name); }
+        if (t->skip_b && str8_equal(entry->name, S("b"))) { return FILE_WALK_SKIP; }
+    }
+    if (entry->type == FILE_TYPE_REGULAR)
+    {
+        str8 contents = file_read_all(t->arena, (const char*) path.ptr);
+        ASSERT(contents.ptr);
+        t->files++;
+        t->bytes += contents.len;
+    }
+    return (t->stop_after && t->files == t->stop_after) ? FILE_WALK_STOP : FILE_WALK_CONTINUE;
+}
+
 void test_math();
 int main(int argc, char** argv)
 {
@@ -55,6 +265,340 @@ int main(int argc, char** argv)
         LOG(INFO|PLATFORM, "BUILD_TYPE:...%s", BUILD_TYPE_STRING);
     }
 
+    /* TEST COMPILE-TIME LOG FILTERING */
+    {
+        /* TRACE is enabled at runtime, but not compiled in (see LOG_COMPILE_MASK) */
+        int evaluated = 0;
+        ASSERT(log_verbosity_level & TRACE);
+        LOG(TRACE|MATH, "never printed %d", evaluated++);
+        ASSERT(evaluated == 0);
+        LOG(INFO|MATH, "printed %d", evaluated++);
+        ASSERT(evaluated == 1);
+        STATIC_ASSERT(!LOG_COMPILED_IN(TRACE|MATH) && LOG_COMPILED_IN(INFO|MATH) && LOG_COMPILED_IN(MATH), "compile mask");
+    }
+
+    /* TEST LOG TIMESTAMPS */
+    {
+        /* monotonic timestamps are seconds since boot (+ LOG_TIME_PRECISION digits) */
+        ASSERT(strcmp(_log_time_string(5ull * 1000000000ull + 999999999ull, 1), "5 ") == 0);
+        ASSERT(strcmp(_log_time_string(6ull * 1000000000ull, 1), "6 ") == 0);
+
+        /* wall clock: the cached prefix is refreshed when the second changes */
+        char first[64];
+        unsigned long long now = _log_time_ns();
+        strcpy(first, _log_time_string(now, 0));
+        ASSERT(strcmp(first, _log_time_string(now, 0)) == 0);
+        ASSERT(strcmp(first, _log_time_string(now + 3600ull * 1000000000ull, 0)) != 0);
+        ASSERT(strcmp(first, _log_time_string(now, 0)) == 0);
+    }
+
+    /* TEST LOG RATE LIMITING */
+    {
+        /* arguments of suppressed messages are not evaluated */
+        int every = 0, first = 0, throttled = 0;
+        for (int i = 0; i < 25; i++)  { LOG_EVERY_N(INFO|MATH, 10, "every 10th %d", every++); }
+        for (int i = 0; i < 25; i++)  { LOG_FIRST_N(INFO|MATH, 3, "first 3 %d", first++); }
+        for (int i = 0; i < 100; i++) { LOG_THROTTLED(INFO|MATH, 1000, "throttled %d", throttled++); }
+        ASSERT(every == 3 && first == 3 && throttled == 1);
+
+#if defined(LOG_USE_SINKS)
+        /* the next message after a burst reports how many were suppressed */
+        FILE* dump = tmpfile();
+        log_sink_t* ring = log_sink_crash_ring(1024, 0, NULL, LOG_EVERYTHING);
+        ASSERT(ring && log_sink_add(ring));
+        for (int round = 0; round < 2; round++)
+        {
+            for (int i = 0; i < 100; i++) { LOG_THROTTLED(WARN|MATH, 20, "burst %d", i); }
+            unsigned long long wait_until = _log_time_ns() + 25ull * 1000000ull;
+            while (_log_time_ns() < wait_until) {}
+        }
+        log_sink_remove(ring);
+        log_sink_crash_ring_dump(ring, dump);
+        ring->close(ring);
+
+        char line[256];
+        int  bursts = 0, repeated = 0;
+        rewind(dump);
+        while (fgets(line, sizeof(line), dump))
+        {
+            bursts   += (strstr(line, "burst 0") != NULL);
+            repeated += (strstr(line, "last message repeated 99 times") != NULL);
+        }
+        ASSERT(bursts == 2 && repeated == 1);
+        fclose(dump);
+#endif
+    }
+
+    /* TEST STRUCTURED LOGGING */
+    {
+        char   line[512];
+        size_t len;
+        const log_kv_t kvs[] = { LOG_KV_STR("msg", "hello world"), LOG_KV_INT("n", -42), LOG_KV_UINT("u", ~0ull),
+                                 LOG_KV_FLOAT("f", 0.1), LOG_KV_BOOL("ok", 1), LOG_KV_STR("s", "a\"b\n\x01"),
+                                 LOG_KV_STR("null", NULL), LOG_KV_STRN("empty", "xyz", 0) };
+        int count = (int) (sizeof(kvs) / sizeof(kvs[0]));
+
+        /* the value is evaluated once */
+        const char* names[] = { "first", "second" };
+        int         next    = 0;
+        log_kv_t    kv      = LOG_KV_STR("name", names[next++]);
+        ASSERT(next == 1 && kv.len == 5 && strcmp(kv.value.s, "first") == 0);
+
+        len = _log_kv_serialize(line, sizeof(line), WARN|MEMORY, "f.c", 7, 123, kvs, count);
+        ASSERT(len == strlen("time=123 level=WARN subsystem=MEMORY file=f.c line=7 msg=\"hello world\" n=-42 "
+                             "u=18446744073709551615 f=0.1 ok=true s=\"a\\\"b\\n\\u0001\" null=null empty=\"\"\n"));
+        ASSERT(memcmp(line, "time=123 level=WARN subsystem=MEMORY file=f.c line=7 msg=\"hello world\" n=-42 "
+                            "u=18446744073709551615 f=0.1 ok=true s=\"a\\\"b\\n\\u0001\" null=null empty=\"\"\n", len) == 0);
+
+        log_kv_set_format(LOG_KV_JSON);
+        len = _log_kv_serialize(line, sizeof(line), WARN|MEMORY, "f.c", 7, 123, kvs, count);
+        line[len] = '\0';
+        ASSERT(strcmp(line, "{\"time\":123,\"level\":\"WARN\",\"subsystem\":\"MEMORY\",\"file\":\"f.c\",\"line\":7,"
+                            "\"msg\":\"hello world\",\"n\":-42,\"u\":18446744073709551615,\"f\":0.1,\"ok\":true,"
+                            "\"s\":\"a\\\"b\\n\\u0001\",\"null\":null,\"empty\":\"\"}\n") == 0);
+
+        /* fields that don't fit get dropped, the line stays valid */
+        len = _log_kv_serialize(line, 64, INFO, "f.c", 7, 123, kvs, count);
+        line[len] = '\0';
+        ASSERT(strcmp(line, "{\"time\":123,\"level\":\"INFO\",\"file\":\"f.c\",\"line\":7}\n") == 0);
+
+#if defined(LOG_USE_ASYNC)
+        /* the writer thread serializes the fields */
+        FILE* out = tmpfile();
+        ASSERT(log_async_start(out, 8, LOG_OVERFLOW_BLOCK, 0));
+        char name[8] = "player";
+        LOG_KV(INFO|PLATFORM, "async kv", LOG_KV_STR("name", name), LOG_KV_FLOAT("x", 1.5));
+        name[0] = 'P'; /* strings are copied */
+        log_async_stop();
+        rewind(out);
+        ASSERT(fgets(line, sizeof(line), out));
+        ASSERT(strstr(line, "\"level\":\"INFO\",\"subsystem\":\"PLATFORM\","));
+        ASSERT(strstr(line, "\"msg\":\"async kv\",\"name\":\"player\",\"x\":1.5}\n"));
+        fclose(out);
+#endif
+        log_kv_set_format(LOG_KV_LOGFMT);
+        LOG_KV(INFO|PLATFORM, "structured", LOG_KV_INT("answer", 42));
+    }
+
+#if defined(LOG_USE_ASYNC)
+    /* TEST ASYNC LOGGING */
+    {
+        FILE* out = tmpfile();
+        ASSERT(out);
+
+        /* tiny ring buffer, so the blocking overflow policy gets exercised */
+        ASSERT(log_async_start(out, 4, LOG_OVERFLOW_BLOCK, FATAL));
+        ASSERT(!log_async_start(out, 4, LOG_OVERFLOW_BLOCK, FATAL)); /* already running */
+        char temp_name[16] = "temporary";
+        for (int i = 0; i < 1000; i++)
+        {
+            LOG(INFO|MEMORY, "msg %i %s %.2f %5.1s|%-*d|%c%%%llx", i, temp_name, 0.5, "xyz", 4, 7, 'q', 255ull);
+            temp_name[0] = 'T'; /* strings are copied at the call site */
+        }
+        LOG(FATAL|MEMORY, "flushed right away");
+
+        /* the FATAL message blocked until everything was written */
+        char line[256];
+        int  lines = 0;
+        rewind(out);
+        while (fgets(line, sizeof(line), out)) { lines++; }
+        ASSERT(lines == 1001);
+        ASSERT(strstr(line, "flushed right away"));
+        log_async_stop();
+
+        rewind(out);
+        ASSERT(fgets(line, sizeof(line), out));
+        ASSERT(strstr(line, "msg 0 temporary 0.50     x|7   |q%ff"));
+        ASSERT(fgets(line, sizeof(line), out));
+        ASSERT(strstr(line, "msg 1 Temporary 0.50     x|7   |q%ff"));
+        ASSERT(log_async_dropped() == 0);
+        fclose(out);
+
+        LOG(INFO|PLATFORM, "Logging synchronously again after log_async_stop()");
+
+        /* stopping while other threads log (& block on the full ring): they
+         * finish into the ring or fall back to logging synchronously */
+        out = tmpfile();
+        ASSERT(log_async_start(out, 4, LOG_OVERFLOW_BLOCK, 0));
+        platform_thread_t threads[2];
+        u32 started = 0;
+        for (int i = 0; i < 2; i++) { ASSERT(platform_thread_create(&threads[i], test_log_async_thread, &started, NULL)); }
+        while (atomic_load_u32(&started, ATOMIC_ACQUIRE) < 2) { platform_yield(); }
+        log_async_stop();
+        for (int i = 0; i < 2; i++) { platform_thread_join(&threads[i]); }
+        fclose(out);
+    }
+#endif
+
+#if defined(LOG_USE_SINKS)
+    /* TEST LOG SINKS */
+    {
+        /* file sink: warnings and worse, rotated every ~1KB, keeps 2 old files */
+        const char* path = "test_log_sink.txt";
+        remove(path); remove("test_log_sink.txt.1"); remove("test_log_sink.txt.2");
+        log_sink_t* file = log_sink_file(path, 1024, 2, WARN | ERROR | FATAL | LOG_SUBSYSTEMS | LOG_CATEGORIES);
+        ASSERT(file && log_sink_add(file));
+
+        /* crash ring: everything, dumped when a FATAL message comes in */
+        FILE* dump = tmpfile();
+        log_sink_t* ring = log_sink_crash_ring(512, FATAL, dump, LOG_EVERYTHING);
+        ASSERT(ring && log_sink_add(ring));
+
+        for (int i = 0; i < 50; i++)
+        {
+            LOG(INFO|MEMORY, "sink info %d", i);
+            LOG(WARN|MEMORY, "sink warning %d", i);
+        }
+        log_sinks_flush();
+
+        char  line[256];
+        FILE* check = fopen(path, "rb");
+        ASSERT(check);
+        int warnings = 0;
+        while (fgets(line, sizeof(line), check)) { ASSERT(!strstr(line, "sink info")); warnings += (strstr(line, "sink warning") != NULL); }
+        fclose(check);
+        ASSERT(warnings > 0 && warnings < 50);
+        ASSERT((check = fopen("test_log_sink.txt.2", "rb")) != NULL); fclose(check);
+        ASSERT((check = fopen("test_log_sink.txt.3", "rb")) == NULL);
+
+        /* lines are batched until a flush, unless they match the flush mask */
+        long size = 0;
+        ASSERT((check = fopen(path, "rb")) != NULL);
+        fseek(check, 0, SEEK_END); size = ftell(check); fclose(check);
+        LOG(ERROR|MEMORY, "sink batched");
+        ASSERT((check = fopen(path, "rb")) != NULL);
+        fseek(check, 0, SEEK_END); ASSERT(ftell(check) == size); fclose(check);
+        log_sinks_set_flush_mask(ERROR);
+        LOG(ERROR|MEMORY, "sink flushed");
+        log_sinks_set_flush_mask(0);
+        ASSERT((check = fopen(path, "rb")) != NULL);
+        fseek(check, 0, SEEK_END); ASSERT(ftell(check) > size); fclose(check);
+
+        /* the ring only holds the most recent lines */
+        rewind(dump);
+        ASSERT(!fgets(line, sizeof(line), dump));
+        LOG(FATAL|MEMORY, "sink fatal");
+        rewind(dump);
+        int dumped = 0;
+        while (fgets(line, sizeof(line), dump)) { dumped++; ASSERT(!strstr(line, "sink info 0 ")); }
+        ASSERT(dumped > 1 && strstr(line, "sink fatal"));
+        fclose(dump);
+
+        /* a ring that is exactly full dumps all of it */
+        log_sink_t* tiny = log_sink_crash_ring(10, 0, NULL, LOG_EVERYTHING);
+        ASSERT(tiny && (dump = tmpfile()) != NULL);
+        tiny->write(tiny, 0, "abcd\nefgh\n", 10);
+        log_sink_crash_ring_dump(tiny, dump);
+        rewind(dump);
+        ASSERT(fread(line, 1, sizeof(line), dump) == 10 && memcmp(line, "abcd\nefgh\n", 10) == 0);
+        tiny->write(tiny, 0, "ij\n", 3); /* wrapped: the partial oldest line is skipped */
+        rewind(dump);
+        log_sink_crash_ring_dump(tiny, dump);
+        rewind(dump);
+        ASSERT(fread(line, 1, 8, dump) == 8 && memcmp(line, "efgh\nij\n", 8) == 0);
+        fclose(dump);
+        tiny->close(tiny);
+
+#if defined(LOG_USE_ASYNC)
+        /* the async writer thread hands its lines to the sinks as well */
+        log_sink_remove(ring);
+        ring->close(ring);
+        ASSERT(log_async_start(NULL, 64, LOG_OVERFLOW_BLOCK, 0));
+        LOG(ERROR|MEMORY, "sink from writer thread");
+        log_async_stop();
+        check = fopen(path, "rb");
+        int found = 0;
+        while (fgets(line, sizeof(line), check)) { found += (strstr(line, "sink from writer thread") != NULL); }
+        fclose(check);
+        ASSERT(found == 1);
+#endif
+
+#if !defined(_WIN32)
+        /* socket sink: a collector listening on a unix domain socket */
+        const char* sock_path = "test_log.sock";
+        remove(sock_path);
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {0};
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, sock_path);
+        ASSERT(bind(listener, (struct sockaddr*) &addr, sizeof(addr)) == 0 && listen(listener, 1) == 0);
+
+        log_sink_t* sock = log_sink_socket(sock_path, LOG_EVERYTHING);
+        ASSERT(sock && log_sink_add(sock));
+        ASSERT(!log_sink_socket("does_not_exist.sock", LOG_EVERYTHING));
+        int collector = accept(listener, NULL, NULL);
+        LOG(INFO|PLATFORM, "over the socket");
+        log_sinks_flush();
+        char received[512] = {0};
+        ASSERT(recv(collector, received, sizeof(received) - 1, 0) > 0);
+        ASSERT(strstr(received, "over the socket"));
+        close(collector);
+        close(listener);
+        remove(sock_path);
+#endif
+
+        log_sinks_close();
+        remove(path); remove("test_log_sink.txt.1"); remove("test_log_sink.txt.2");
+        LOG(INFO|PLATFORM, "Back to stdout after log_sinks_close()");
+    }
+#endif
+
+#if defined(LOG_USE_BINARY)
+    /* TEST BINARY LOGGING */
+    {
+        const char* path = "test_log.bin";
+        for (int run = 0; run < 2; run++) /* 2nd run: call sites need to register again */
+        {
+            ASSERT(log_binary_open(path, MEGABYTES(1)));
+            ASSERT(!log_binary_open(path, MEGABYTES(1))); /* already open */
+            for (int i = 0; i < 100; i++)
+            {
+                LOG(WARN|MEMORY, "binary %d %s %.3f %hhd|%5s|%-3c|%llu", i, (i & 1) ? "odd" : "even", 1.25, 300, "ab", 'z', 1ull << 40);
+            }
+            LOG(INFO|MATH, "no arguments");
+            log_binary_close();
+            ASSERT(log_binary_dropped() == 0);
+
+            FILE* out = tmpfile();
+            ASSERT(log_binary_decode(path, out) == 101);
+            char line[256];
+            rewind(out);
+            ASSERT(fgets(line, sizeof(line), out));
+            ASSERT(strstr(line, "[WARN ]") && strstr(line, "[MEMORY]") && strstr(line, "test.c:"));
+            ASSERT(strstr(line, "binary 0 even 1.250 44|   ab|z  |1099511627776"));
+            ASSERT(fgets(line, sizeof(line), out));
+            ASSERT(strstr(line, "binary 1 odd 1.250"));
+            for (int i = 2; i < 101; i++) { ASSERT(fgets(line, sizeof(line), out)); }
+            ASSERT(strstr(line, "[INFO ]") && strstr(line, "no arguments"));
+            ASSERT(!fgets(line, sizeof(line), out));
+            fclose(out);
+        }
+
+        /* messages that don't fit anymore are dropped */
+        ASSERT(log_binary_open(path, 256));
+        for (int i = 0; i < 10; i++) { LOG(WARN|MEMORY, "dropped eventually %d", i); }
+        log_binary_close();
+        ASSERT(log_binary_dropped() > 0);
+        ASSERT(log_binary_decode(path, NULL) < 10); /* prints the ones that fit */
+
+        ASSERT(log_binary_decode("does_not_exist.bin", NULL) == -1);
+
+        /* closing while other threads log: their messages are in the file or
+         * went through the regular path, nobody writes to the unmapped file */
+        ASSERT(log_binary_open(path, MEGABYTES(1)));
+        platform_thread_t threads[2];
+        u32 started = 0;
+        for (int i = 0; i < 2; i++) { ASSERT(platform_thread_create(&threads[i], test_log_binary_thread, &started, NULL)); }
+        while (atomic_load_u32(&started, ATOMIC_ACQUIRE) < 2) { platform_yield(); }
+        log_binary_close();
+        for (int i = 0; i < 2; i++) { platform_thread_join(&threads[i]); }
+        FILE* decoded = tmpfile();
+        ASSERT(log_binary_decode(path, decoded) >= 0);
+        fclose(decoded);
+        remove(path);
+    }
+#endif
+
     /* TEST DEBUG FUNCTIONS */
     {
         STATIC_ASSERT((2+2==4), "All good");
@@ -114,6 +658,37 @@ int main(int argc, char** argv)
         #endif
     }
 
+    /* TEST ATOMICS */
+    {
+        u32 value = 5;
+        ASSERT(atomic_load_u32(&value, ATOMIC_SEQ_CST) == 5);
+        atomic_store_u32(&value, 6, ATOMIC_RELEASE);
+        ASSERT(atomic_exchange_u32(&value, 7, ATOMIC_ACQ_REL) == 6);
+        u32 expected = 1;
+        ASSERT(!atomic_cas_u32(&value, &expected, 8, ATOMIC_ACQ_REL) && expected == 7); /* fails, reports current */
+        ASSERT(atomic_cas_u32(&value, &expected, 8, ATOMIC_ACQ_REL) && value == 8);
+        ASSERT(atomic_fetch_sub_u32(&value, 3, ATOMIC_RELAXED) == 8 && value == 5);
+        ASSERT(atomic_fetch_and_u32(&value, 4, ATOMIC_RELAXED) == 5 && value == 4);
+        u64 big = ~0ull - 1;
+        ASSERT(atomic_fetch_add_u64(&big, 1, ATOMIC_SEQ_CST) == ~0ull - 1 && big == ~0ull);
+        void* ptr = NULL;
+        void* expected_ptr = NULL;
+        ASSERT(atomic_cas_ptr(&ptr, &expected_ptr, &value, ATOMIC_RELEASE) && ptr == &value);
+        ASSERT(atomic_exchange_ptr(&ptr, NULL, ATOMIC_ACQ_REL) == &value);
+        #if !defined(__SANITIZE_THREAD__) /* tsan doesn't model fences (and warns about them) */
+        atomic_fence(ATOMIC_SEQ_CST);
+        #endif
+        atomic_compiler_barrier();
+
+        STATIC_ASSERT(OFFSET_OF(test_atomics_t, payload) == CACHE_LINE_SIZE, "padding to the next cache line");
+        test_atomics_t t = {0};
+        platform_thread_t threads[4];
+        for (int i = 0; i < 4; i++) { ASSERT(platform_thread_create(&threads[i], test_atomics_thread, &t, NULL)); }
+        for (int i = 0; i < 4; i++) { platform_thread_join(&threads[i]); }
+        ASSERT(t.counter == 4 * 10000 && t.cas_counter == 4 * 10000);
+        ASSERT(t.flags == 0xF);
+    }
+
     /* TEST MATH FUNCTIONS  */
     test_math();
 
@@ -153,6 +728,23 @@ int main(int argc, char** argv)
         #endif
     }
 
+    /* TEST DEFAULT ARENAS */
+    {
+        ASSERT(mem_arena_default() == mem_arena_default());
+        size_t count_before = 0;
+        mem_arena_stats_total(&count_before);
+
+        /* thread defaults are registered while their thread runs & destroyed when it exits */
+        mem_arena_t*      thread_arenas[2] = {0};
+        platform_thread_t threads[2];
+        for (u32 i = 0; i < 2; i++) { ASSERT(platform_thread_create(&threads[i], test_thread_arena, &thread_arenas[i], NULL)); }
+        for (u32 i = 0; i < 2; i++) { platform_thread_join(&threads[i]); }
+        ASSERT(thread_arenas[0] && thread_arenas[1]);
+        size_t count_after = 0;
+        mem_arena_stats_total(&count_after);
+        ASSERT(count_after == count_before);
+    }
+
     /* TEST COMMON MACROS */
     {
         /* test scoped_begin_end */
@@ -198,6 +790,385 @@ int main(int argc, char** argv)
         POP_WARNINGS()
     }
 
+    /* TEST PROFILER */
+    {
+        profile_clear();
+        profile_thread_name("main");
+        PROFILE_SCOPE("outer")
+        {
+            for (int i = 0; i < 3; i++) { PROFILE_SCOPE("inner") { volatile int x = i; (void) x; } }
+        }
+        PROFILE_BEGIN("manual");
+        PROFILE_END();
+
+        /* zones nest: outer begins first and ends last */
+        profile_thread_t* t = profile_thread();
+        ASSERT(t->head == 10);
+        ASSERT(strcmp(t->events[0].name, "outer") == 0 && strcmp(t->events[1].name, "inner") == 0);
+        ASSERT(t->events[2].name == NULL && t->events[7].name == NULL);
+        for (int i = 1; i < 10; i++) { ASSERT(t->events[i].ticks >= t->events[i - 1].ticks); }
+        ASSERT(profile_ticks_per_us() > 0.0);
+
+        char  line[256];
+        int   begins = 0, ends = 0;
+        FILE* trace = tmpfile();
+        ASSERT(profile_dump_chrome(trace) == 11); /* + thread name */
+        rewind(trace);
+        ASSERT(fgets(line, sizeof(line), trace) && strstr(line, "\"traceEvents\":["));
+        ASSERT(fgets(line, sizeof(line), trace) && strstr(line, "\"name\":\"thread_name\",\"args\":{\"name\":\"main\"}"));
+        while (fgets(line, sizeof(line), trace))
+        {
+            begins += (strstr(line, "\"ph\":\"B\"") != NULL);
+            ends   += (strstr(line, "\"ph\":\"E\"") != NULL);
+        }
+        ASSERT(begins == 5 && ends == 5);
+        fclose(trace);
+
+        /* full ring buffer: end events whose begin got overwritten are skipped */
+        profile_clear();
+        PROFILE_BEGIN("overwritten");
+        for (int i = 0; i < PROFILE_RING_SIZE / 2; i++) { PROFILE_SCOPE("spin") {} }
+        PROFILE_END();
+        trace = tmpfile();
+        ASSERT(profile_dump_chrome(trace) == PROFILE_RING_SIZE - 2 + 1);
+        fclose(trace);
+
+        #if defined(LANGUAGE_CPP) && (STANDARD_VERSION >= 2011)
+        profile_clear();
+        {
+            PROFILE_FUNCTION();
+            ASSERT(t->head == 1 && strcmp(t->events[0].name, "main") == 0);
+        }
+        ASSERT(t->head == 2);
+        #endif
+        profile_clear();
+    }
+
+    /* TEST METRICS */
+    {
+        for (int i = 0; i < 10; i++) { METRIC_COUNT("test.count", 2); }
+        ASSERT(metrics_counter_value(metrics_counter("test.count")) == 20);
+
+        METRIC_GAUGE_SET("test.gauge", 5);
+        METRIC_GAUGE_ADD("test.gauge", -7);
+        ASSERT(metrics_gauge_value(metrics_gauge("test.gauge")) == -2);
+
+        /* buckets are exact below 16, then 16 per power of 2 */
+        for (u64 v = 1; v < 100000; v++) { ASSERT(metrics_histogram_bucket(v) >= metrics_histogram_bucket(v - 1)); }
+        ASSERT(metrics_histogram_bucket(15) == 15 && metrics_histogram_bucket(16) == 16 && metrics_histogram_bucket(32) == 32);
+        ASSERT(metrics_histogram_bucket(~0ull) == METRICS_HISTOGRAM_BUCKETS - 1);
+
+        metrics_histogram_t* hist = metrics_histogram("test.latency");
+        for (u64 v = 1; v <= 1000; v++) { METRIC_RECORD("test.latency", v); }
+        u64 p50 = metrics_histogram_percentile(hist, 50.0);
+        u64 p99 = metrics_histogram_percentile(hist, 99.0);
+        ASSERT(p50 >= 500 && p50 <= 500 + 500 / 16);
+        ASSERT(p99 >= 990 && p99 <= 1000);
+        ASSERT(metrics_histogram_percentile(hist, 100.0) == 1000 && metrics_histogram_percentile(hist, 0.0) == 1);
+        ASSERT(hist->min == 1 && hist->max == 1000 && hist->count == 1000 && hist->sum == 500500);
+
+        /* snapshot includes arena stats */
+        mem_arena_t* arena = mem_arena_create(KILOBYTES(64));
+        mem_arena_push(arena, KILOBYTES(4));
+        metrics_track_arena("test.arena", arena);
+
+        char  line[METRICS_LINE_SIZE];
+        int   found = 0;
+        FILE* out   = tmpfile();
+        metrics_snapshot(out);
+        rewind(out);
+        while (fgets(line, sizeof(line), out))
+        {
+            found += (strcmp(line, "counter   test.count 20\n") == 0);
+            found += (strcmp(line, "gauge     test.gauge -2\n") == 0);
+            found += (strstr(line, "histogram test.latency count=1000 min=1 p50=") == line);
+            found += (strcmp(line, "arena     test.arena used=4096 peak=4096 committed=4096 capacity=65536\n") == 0);
+        }
+        ASSERT(found == 4);
+        fclose(out);
+        METRICS_LOG(INFO|MEMORY);
+
+        /* periodic snapshots from a background thread, arenas get destroyed meanwhile */
+        out = tmpfile();
+        ASSERT(metrics_periodic_start(out, 10));
+        ASSERT(!metrics_periodic_start(out, 10));
+        u64 wait_until = platform_time_ns() + 50ull * 1000000ull;
+        while (platform_time_ns() < wait_until)
+        {
+            METRIC_COUNT("test.count", 1);
+            mem_arena_t* churn = mem_arena_create(KILOBYTES(64));
+            metrics_track_arena("test.arena.churn", churn);
+            metrics_untrack_arena(churn);
+            mem_arena_destroy(&churn);
+        }
+        metrics_periodic_stop();
+        rewind(out);
+        int snapshots = 0;
+        while (fgets(line, sizeof(line), out)) { snapshots += (strncmp(line, "# metrics ", 10) == 0); }
+        ASSERT(snapshots >= 1);
+        fclose(out);
+
+        metrics_untrack_arena(arena);
+        ASSERT(metrics_snapshot_line(3, line, sizeof(line)) && line[0] == '\0');
+        mem_arena_destroy(&arena);
+    }
+
+    /* TEST JOB SYSTEM */
+    {
+        ASSERT(job_worker_index() == U32_MAX);
+        ASSERT(job_system_init(3, KILOBYTES(64)));
+        ASSERT(job_worker_count() == 4 && job_worker_index() == 0);
+
+        test_jobs_t t = {0};
+        job_counter_t counter = {0};
+        for (int i = 0; i < 5000; i++) { job_run(test_job_leaf, &t, &counter); } /* more than fit into a deque */
+        for (int i = 0; i < 100;  i++) { job_run(test_job_nested, &t, &counter); }
+        job_wait(&counter);
+        ASSERT(counter.value == 0);
+        ASSERT(t.ran == 5000 + 100 * 8 && t.nested == 100);
+
+        u64 count = 100000;
+        t.visited = (u8*) calloc(count, 1);
+        job_parallel_for(count, 1000, test_job_range, &t);
+        for (u64 i = 0; i < count; i++) { ASSERT(t.visited[i] == 1); }
+        ASSERT(t.sum == count * (count - 1) / 2);
+        free(t.visited);
+
+        job_run(test_job_leaf, &t, NULL); /* fire & forget */
+        job_system_shutdown();
+        ASSERT(job_scratch_arena() == NULL);
+    }
+
+    /* TEST QUEUES */
+    {
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+        test_queues_t* t   = (test_queues_t*) calloc(1, sizeof(test_queues_t));
+
+        /* spsc: capacity gets rounded up, batches wrap around */
+        t->spsc = queue_spsc_create(6, sizeof(u32), arena);
+        u32 in[5] = { 1, 2, 3, 4, 5 }, out[8];
+        ASSERT(((uintptr_t) t->spsc % CACHE_LINE_SIZE) == 0);
+        ASSERT(queue_spsc_push_n(t->spsc, in, 5) == 5 && queue_spsc_count(t->spsc) == 5);
+        ASSERT(queue_spsc_pop_n(t->spsc, out, 3) == 3 && out[0] == 1 && out[2] == 3);
+        ASSERT(queue_spsc_push_n(t->spsc, in, 5) == 5);  /* wraps */
+        ASSERT(queue_spsc_push(t->spsc, in) && !queue_spsc_push(t->spsc, in)); /* 8 slots, full */
+        ASSERT(queue_spsc_pop_n(t->spsc, out, 8) == 8 && out[0] == 4 && out[2] == 1 && out[7] == 1);
+        ASSERT(!queue_spsc_pop(t->spsc, out));           /* empty */
+
+        /* os memory: committed even with asserts compiled out (NDEBUG) */
+        queue_spsc_t* os_queue = queue_spsc_create(64, sizeof(u32), NULL);
+        ASSERT(os_queue && queue_spsc_push(os_queue, in) && queue_spsc_pop(os_queue, out) && out[0] == 1);
+        queue_spsc_destroy(&os_queue);
+
+        platform_thread_t producer;
+        ASSERT(platform_thread_create(&producer, test_queue_spsc_producer, t, NULL));
+        for (u32 expected = 0; expected < 20000;)
+        {
+            u64 n = queue_spsc_pop_n(t->spsc, out, 8);
+            for (u64 i = 0; i < n; i++) { ASSERT(out[i] == expected); expected++; }
+            if (!n) { platform_yield(); }
+        }
+        platform_thread_join(&producer);
+
+        /* mpsc: per producer order is kept */
+        queue_mpsc_init(&t->mpsc);
+        ASSERT(queue_mpsc_empty(&t->mpsc) && !queue_mpsc_pop(&t->mpsc));
+        platform_thread_t producers[4];
+        for (int i = 0; i < 4; i++) { ASSERT(platform_thread_create(&producers[i], test_queue_mpsc_producer, t, NULL)); }
+        u32 next_seq[4] = {0};
+        for (u32 popped = 0; popped < 4 * 1000;)
+        {
+            queue_node_t* node = queue_mpsc_pop(&t->mpsc);
+            if (!node) { platform_yield(); continue; }
+            test_queue_msg_t* msg = (test_queue_msg_t*) node; /* node is the first member */
+            ASSERT(msg->seq == next_seq[msg->producer]);
+            next_seq[msg->producer]++;
+            popped++;
+        }
+        for (int i = 0; i < 4; i++) { platform_thread_join(&producers[i]); }
+        ASSERT(!queue_mpsc_pop(&t->mpsc));
+
+        /* mpmc: nothing gets lost or duplicated (os memory) */
+        t->mpmc = queue_mpmc_create(64, sizeof(u64), NULL);
+        u64 vals[3] = { 7, 8, 9 }, got[3];
+        ASSERT(queue_mpmc_push_n(t->mpmc, vals, 3) == 3 && queue_mpmc_pop_n(t->mpmc, got, 3) == 3 && got[2] == 9);
+        platform_thread_t threads[4];
+        for (int i = 0; i < 2; i++) { ASSERT(platform_thread_create(&threads[i],     test_queue_mpmc_producer, t, NULL)); }
+        for (int i = 0; i < 2; i++) { ASSERT(platform_thread_create(&threads[i + 2], test_queue_mpmc_consumer, t, NULL)); }
+        for (int i = 0; i < 4; i++) { platform_thread_join(&threads[i]); }
+        ASSERT(t->mpmc_sum == 2 * (5000ull * 5001 / 2));
+        queue_mpmc_destroy(&t->mpmc);
+        ASSERT(t->mpmc == NULL);
+
+        free(t);
+        mem_arena_destroy(&arena);
+    }
+
+    /* TEST MEMORY MAPPED FILES */
+    {
+        const char* path = "test_file_map.bin";
+        u64 size = 3 * mem_pagesize() + 100; /* not a multiple of the page size */
+        file_map_t map;
+        ASSERT(file_map_create(&map, path, size));
+        ASSERT(map.ptr && map.size == size);
+        for (u64 i = 0; i < size; i++) { map.ptr[i] = (u8) (i * 31); }
+        ASSERT(file_map_sync(&map, 10, 100, 1));
+        file_unmap(&map);
+        ASSERT(!map.ptr);
+
+        /* read-only sees the written bytes, copy-on-write doesn't change the file, shared does */
+        ASSERT(file_map(&map, path, FILE_MAPPING_READONLY, FILE_HINT_SEQUENTIAL | FILE_HINT_WILLNEED));
+        ASSERT(map.size == size && map.ptr[size - 1] == (u8) ((size - 1) * 31));
+        ASSERT(!file_map_sync(&map, 0, size, 0)); /* only shared mappings */
+        file_unmap(&map);
+        ASSERT(file_map(&map, path, FILE_MAPPING_PRIVATE, FILE_HINT_RANDOM));
+        map.ptr[0] = 0xAA;
+        file_unmap(&map);
+        ASSERT(file_map(&map, path, FILE_MAPPING_SHARED, FILE_HINT_NONE));
+        ASSERT(map.ptr[0] == 0);
+        map.ptr[1] = 0xBB;
+        ASSERT(file_map_sync(&map, 0, 1, 0));
+        file_unmap(&map);
+        ASSERT(file_map(&map, path, FILE_MAPPING_READONLY, FILE_HINT_NONE));
+        ASSERT(map.ptr[0] == 0 && map.ptr[1] == 0xBB);
+        file_unmap(&map);
+
+        /* sliding window: a view of one page, ranges crossing the view get remapped */
+        file_window_t w;
+        ASSERT(file_window_open(&w, path, 1, FILE_HINT_SEQUENTIAL));
+        ASSERT(w.file_size == size && w.window_size == mem_pagesize());
+        u64 available = 0;
+        u64 checked   = 0;
+        for (u64 offset = 2; offset < size; offset += available)
+        {
+            u8* ptr = file_window_map(&w, offset, 1, &available);
+            ASSERT(ptr && available >= 1 && offset + available <= size);
+            for (u64 i = 0; i < available; i++) { ASSERT(ptr[i] == (u8) ((offset + i) * 31)); }
+            checked += available;
+        }
+        ASSERT(checked == size - 2);
+        u8* straddle = file_window_map(&w, mem_pagesize() - 8, 64, &available);
+        ASSERT(straddle && available >= 64 && straddle[8] == (u8) (mem_pagesize() * 31));
+        ASSERT(!file_window_map(&w, size, 1, &available) && available == 0);
+        file_window_close(&w);
+
+        ASSERT(file_map_create(&map, path, 0) && !map.ptr); /* empty files map to nothing */
+        file_unmap(&map);
+        ASSERT(file_map(&map, path, FILE_MAPPING_READONLY, FILE_HINT_NONE) && !map.ptr && map.size == 0);
+        file_unmap(&map);
+        remove(path);
+        ASSERT(!file_map(&map, path, FILE_MAPPING_READONLY, FILE_HINT_NONE));
+        ASSERT(!file_window_open(&w, path, 1, FILE_HINT_NONE));
+    }
+
+    /* TEST READ FILES & WALK DIRECTORIES */
+    {
+    #if defined(PLATFORM_WIN32)
+        #define TEST_MKDIR(path) CreateDirectoryA(path, NULL)
+        #define TEST_RMDIR(path) RemoveDirectoryA(path)
+    #else
+        #define TEST_MKDIR(path) mkdir(path, 0755)
+        #define TEST_RMDIR(path) rmdir(path)
+    #endif
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+        const char*  path  = "test_file_read.txt";
+        FILE* f = fopen(path, "wb");
+        ASSERT(f && fwrite("hello, file", 1, 11, f) == 11);
+        fclose(f);
+
+        u64  used = mem_arena_stats(arena).used;
+        str8 text = file_read_all(arena, path);
+        ASSERT(str8_equal(text, S("hello, file")) && text.ptr[text.len] == 0);
+        ASSERT(mem_arena_stats(arena).used == used + 12); /* contents & NUL, nothing else */
+
+        mem_arena_t* small = mem_arena_create(8); /* doesn't fit: fails, arena untouched */
+        ASSERT(!file_read_all(small, path).ptr && mem_arena_stats(small).used == 0);
+        mem_arena_destroy(&small);
+
+        f = fopen(path, "wb");
+        fclose(f);
+        text = file_read_all(arena, path);
+        ASSERT(text.ptr && text.len == 0 && text.ptr[0] == 0); /* empty isn't an error */
+        remove(path);
+        ASSERT(!file_read_all(arena, path).ptr);
+    #if defined(PLATFORM_LINUX)
+        text = file_read_all(arena, "/proc/self/smaps"); /* size 0 in fstat, read in chunks */
+        ASSERT(text.ptr && text.len > FILE_READ_CHUNK && text.ptr[text.len] == 0 && strlen((char*) text.ptr) == text.len);
+    #endif
+
+        /* test_dir_walk/{f0, a/{f1, f2, b/{f3, c/}}, many/{0..1199}}, "many" takes more than one getdents64() */
+        const char* dirs[]  = { "test_dir_walk", "test_dir_walk/a", "test_dir_walk/a/b", "test_dir_walk/a/b/c", "test_dir_walk/many" };
+        const char* files[] = { "test_dir_walk/f0", "test_dir_walk/a/f1", "test_dir_walk/a/f2", "test_dir_walk/a/b/f3" };
+        u32 many = 1200;
+        for (u32 i = 0; i < ARRAY_COUNT(dirs); i++)  { TEST_MKDIR(dirs[i]); }
+        for (u32 i = 0; i < ARRAY_COUNT(files); i++) { f = fopen(files[i], "wb"); ASSERT(f); fwrite("0123456789", 1, i + 1, f); fclose(f); }
+        char name[64];
+        for (u32 i = 0; i < many; i++)
+        {
+            snprintf(name, sizeof(name), "test_dir_walk/many/%u", i);
+            f = fopen(name, "wb");
+            ASSERT(f);
+            fclose(f);
+        }
+
+        file_dir_t dir;
+        file_dir_entry_t entry;
+        u8* buffer = (u8*) mem_arena_push(arena, FILE_DIR_BUFFER_SIZE);
+        ASSERT(file_dir_open(&dir, "test_dir_walk", buffer, FILE_DIR_BUFFER_SIZE));
+        u32 count = 0;
+        while (file_dir_next(&dir, &entry))
+        {
+            count++;
+            ASSERT(entry.type == (str8_equal(entry.name, S("f0")) ? FILE_TYPE_REGULAR : FILE_TYPE_DIRECTORY));
+        }
+        ASSERT(count == 3); /* no "." & ".." */
+        file_dir_close(&dir);
+
+        mem_arena_t* walk_arena = mem_arena_create(MEGABYTES(1));
+        test_walk_t t;
+        memset(&t, 0, sizeof(t));
+        t.arena = arena;
+        ASSERT(file_dir_walk(walk_arena, "test_dir_walk/", test_walk_entry, &t));
+        ASSERT(t.files == 4 + many && t.dirs == 4 && t.bytes == 1 + 2 + 3 + 4);
+        ASSERT(mem_arena_stats(walk_arena).used == 0); /* buffers are given back */
+
+        memset(&t, 0, sizeof(t));
+        t.arena  = arena;
+        t.skip_b = 1;
+        ASSERT(file_dir_walk(walk_arena, "test_dir_walk", test_walk_entry, &t));
+        ASSERT(t.files == 3 + many && t.dirs == 3); /* b is reported, not entered */
+
+        memset(&t, 0, sizeof(t));
+        t.arena      = arena;
+        t.stop_after = 1;
+        ASSERT(!file_dir_walk(walk_arena, "test_dir_walk", test_walk_entry, &t) && t.files == 1);
+        ASSERT(!file_dir_walk(walk_arena, "test_dir_walk/missing", test_walk_entry, &t));
+
+        /* func pushes onto the walk arena, right before the next depth's buffer: its data stays */
+        memset(&t, 0, sizeof(t));
+        t.arena = arena;
+        t.keep  = walk_arena;
+        ASSERT(file_dir_walk(walk_arena, "test_dir_walk", test_walk_entry, &t) && t.dirs == 4);
+        ASSERT(mem_arena_stats(walk_arena).used >= FILE_PATH_MAX + FILE_DIR_BUFFER_SIZE);
+        mem_arena_destroy(&walk_arena);
+
+        /* room for the root's buffer only: the walk can't enter a subdirectory & fails */
+        walk_arena = mem_arena_create(FILE_PATH_MAX + FILE_DIR_BUFFER_SIZE + 64);
+        memset(&t, 0, sizeof(t));
+        t.arena = arena;
+        ASSERT(!file_dir_walk(walk_arena, "test_dir_walk", test_walk_entry, &t) && t.dirs >= 1);
+        ASSERT(mem_arena_stats(walk_arena).used == 0);
+        mem_arena_destroy(&walk_arena);
+
+        for (u32 i = 0; i < many; i++) { snprintf(name, sizeof(name), "test_dir_walk/many/%u", i); remove(name); }
+        for (u32 i = 0; i < ARRAY_COUNT(files); i++) { remove(files[i]); }
+        for (u32 i = ARRAY_COUNT(dirs); i > 0; i--)  { TEST_RMDIR(dirs[i - 1]); }
+        ASSERT(!file_dir_open(&dir, "test_dir_walk", buffer, FILE_DIR_BUFFER_SIZE));
+        mem_arena_destroy(&arena);
+        #undef TEST_MKDIR
+        #undef TEST_RMDIR
+    }
+
     /* TEST LINKED LIST MACROS */
     {
         PUSH_WARNINGS()
@@ -237,6 +1208,303 @@ int main(int argc, char** argv)
         ASSERT(arena == NULL);
     }
 
+    /* TEST STRING INTERNING */
+    {
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+        strintern_t* names = strintern_create(arena, 0);
+
+        strintern_id_t empty  = strintern_cstr(names, "");
+        strintern_id_t player = strintern_cstr(names, "player");
+        strintern_id_t enemy  = strintern_cstr(names, "enemy");
+        ASSERT(empty == 0);
+        ASSERT(player != enemy);
+        ASSERT(strintern(names, "player_01", 6) == player);
+        ASSERT(strintern_len(names, player) == 6);
+        ASSERT(mem_equal((void*) strintern_get(names, enemy), (void*) "enemy", 6));
+
+        strintern_id_t found = 0;
+        ASSERT(strintern_lookup(names, "enemy", 5, &found) && found == enemy);
+        ASSERT(!strintern_lookup(names, "npc", 3, NULL));
+
+        /* force the hash index to grow and check that id's stay stable */
+        char name[16];
+        for (i32 i = 0; i < 5000; i++)
+        {
+            i32 len = snprintf(name, sizeof(name), "asset_%i", i);
+            strintern_id_t id = strintern(names, name, len);
+            ASSERT(strintern(names, name, len) == id);
+        }
+        ASSERT(strintern_count(names) == 5000 + 3);
+        ASSERT(strintern_cstr(names, "player") == player);
+        ASSERT(mem_equal((void*) strintern_get(names, strintern_cstr(names, "asset_4711")), (void*) "asset_4711", 11));
+        strintern_destroy(&names);
+        ASSERT(names == NULL);
+
+        /* thread-safe variant has the same behaviour */
+        strintern_t* tags = strintern_create(arena, 1);
+        ASSERT(strintern_cstr(tags, "audio") == strintern_cstr(tags, "audio"));
+
+        /* ...and strings can be read without the lock while another thread inserts */
+        platform_thread_t inserter;
+        ASSERT(platform_thread_create(&inserter, test_strintern_thread, tags, NULL));
+        for (u32 count = 0; count < 1002; platform_yield())
+        {
+            count = strintern_count(tags);
+            ASSERT(strlen(strintern_get(tags, count - 1)) == strintern_len(tags, count - 1));
+        }
+        platform_thread_join(&inserter);
+        strintern_destroy(&tags);
+
+        mem_arena_destroy(&arena);
+    }
+
+    /* TEST STRING VIEWS */
+    {
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+
+        str8 hello = S("Hello World!");
+        ASSERT(hello.len == 12);
+        ASSERT(str8_equal(str8_prefix(hello, 5), S("Hello")));
+        ASSERT(str8_equal(str8_suffix(hello, 6), S("World!")));
+        ASSERT(str8_equal(str8_slice(hello, 6, 100), S("World!")));
+        ASSERT(str8_equal(str8_chop(hello, 7), S("Hello")));
+        ASSERT(str8_skip(hello, 100).len == 0);
+        ASSERT(str8_starts_with(hello, S("Hell")) && !str8_starts_with(S("He"), S("Hell")));
+        ASSERT(str8_ends_with(hello, S("ld!")) && !str8_ends_with(hello, S("ld")));
+        ASSERT(str8_find(hello, S("World"), 0) == 6);
+        ASSERT(str8_find(hello, S("o"), 5) == 7);
+        ASSERT(str8_find(hello, S("xyz"), 0) == -1);
+        ASSERT(str8_find_byte(hello, 'o', 0) == 4 && str8_rfind_byte(hello, 'o') == 7);
+        ASSERT(str8_equal(str8_trim(S(" \t key \n")), S("key")));
+        ASSERT(str8_trim(S("   ")).len == 0);
+
+        str8 key, value;
+        ASSERT(str8_cut(S("width = 1280"), '=', &key, &value));
+        ASSERT(str8_equal(str8_trim(key), S("width")));
+
+        /* split keeps empty fields, tokenize skips them */
+        str8 token;
+        u32 count = 0;
+        str8_iter_t it = str8_split(S("a,,b,"), ',');
+        while (str8_next(&it, &token)) { count++; }
+        ASSERT(count == 4);
+        count = 0;
+        it = str8_tokenize(S("  a, b,,c "), S(", "));
+        while (str8_next(&it, &token)) { count++; ASSERT(token.len == 1); }
+        ASSERT(count == 3);
+
+        /* parsing */
+        i64 i = 0; u64 u = 0; f64 f = 0;
+        ASSERT(str8_to_i64(str8_trim(value), &i) && i == 1280);
+        ASSERT(str8_to_i64(S("-9223372036854775808"), &i) && i == (-9223372036854775807LL - 1));
+        ASSERT(!str8_to_i64(S("9223372036854775808"), &i));
+        ASSERT(str8_to_u64(S("0xFF"), &u) && u == 255);
+        ASSERT(str8_to_u64(S("0b101"), &u) && u == 5);
+        ASSERT(!str8_to_u64(S("18446744073709551616"), &u));
+        ASSERT(!str8_to_u64(S("12a"), &u) && !str8_to_u64(S(""), &u));
+        ASSERT(str8_to_f64(S("1.5"), &f) && f == 1.5);
+        ASSERT(str8_to_f64(S("-0.125e1"), &f) && f == -1.25);
+        ASSERT(str8_to_f64(S("3"), &f) && f == 3.0);
+        ASSERT(str8_to_f64(S(".5"), &f) && f == 0.5);
+        ASSERT(str8_to_f64(S("1e-300"), &f) && f == 1e-300);
+        ASSERT(str8_to_f64(S("0.1"), &f) && f == 0.1);
+        ASSERT(!str8_to_f64(S("1.5x"), &f) && !str8_to_f64(S("e5"), &f) && !str8_to_f64(S("1e"), &f));
+        {
+            /* slow path: no length limit & no locale dependent decimal point */
+            char digits[301];
+            memset(digits, '0', sizeof(digits));
+            digits[0] = '0'; digits[1] = '.'; digits[300] = '1';
+            ASSERT(str8_to_f64(str8_make((u8*) digits, 301), &f) && f == 1e-299);
+            memcpy(digits, "12345678901234567890123", 23);
+            ASSERT(str8_to_f64(str8_make((u8*) digits, 23), &f) && f == 12345678901234567890123.0);
+            ASSERT(str8_to_f64(str8_make((u8*) digits, 300), &f) && f == 12345678901234567890123e277);
+            ASSERT(str8_to_f64(S("-123456789012345678901.5e-3"), &f) && f == -123456789012345678901.5e-3);
+            ASSERT(str8_to_f64(S("0.000000000000000000000000000001e-10"), &f) && f == 1e-40);
+        }
+
+        /* building strings */
+        str8 parts[] = { S("a"), S("b"), S("c") };
+        ASSERT(str8_equal(str8_join(arena, parts, 3, S(", ")), S("a, b, c")));
+        str8 concat = str8_concat(arena, S("foo"), S("bar"));
+        ASSERT(str8_equal(concat, S("foobar")) && concat.ptr[concat.len] == '\0');
+        ASSERT(str8_equal(str8_fmt(arena, "%s=%i", "x", 42), S("x=42")));
+
+        string_t owned = string_from_cstr("view", NULL);
+        ASSERT(str8_equal(string_view(&owned), S("view")));
+
+        mem_arena_destroy(&arena);
+    }
+
+    /* TEST STRING SEARCH & SCAN KERNELS */
+    {
+        /* long enough to go through simd blocks and scalar tails at every offset */
+        u8 buf[300];
+        for (u32 i = 0; i < sizeof(buf); i++) { buf[i] = 'a' + (i % 7); }
+        buf[130] = 'X'; buf[131] = 'Y'; buf[132] = 'Z';
+        buf[200] = '\n'; buf[250] = '\n'; buf[299] = '\n';
+        str8 text = str8_make(buf, sizeof(buf));
+
+        for (u64 from = 0; from <= 135; from++)
+        {
+            i64 expected = (from <= 130) ? 130 : -1;
+            ASSERT(str8_find_byte(text, 'X', from) == expected);
+            ASSERT(str8_find(text, S("XYZ"), from) == expected);
+            ASSERT(str8_find(text, S("XY"), from) == expected);
+            ASSERT(str8_find_any(text, S("ZYX"), from) == ((from <= 132) ? (i64) MAX(from, 130) : -1));
+        }
+        ASSERT(str8_find(text, S("gabcdefgab"), 0) == 6);
+        ASSERT(str8_find(text, S("Z\n"), 0) == -1);
+        ASSERT(str8_find(str8_prefix(text, 133), S("XYZ"), 0) == 130);
+        ASSERT(str8_find(str8_prefix(text, 132), S("XYZ"), 0) == -1);
+        ASSERT(str8_find_any(text, S("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"), 0) == 130); /* big set */
+        ASSERT(str8_find_any(text, S("#$"), 0) == -1);
+        ASSERT(str8_count_newlines(text) == 3);
+        ASSERT(str8_count_byte(text, 'a') == 43);
+        ASSERT(str8_count_newlines(str8_skip(text, 201)) == 2);
+
+        ASSERT(str8_is_utf8(text));
+        ASSERT(str8_is_utf8(S("gr\xC3\xBC\xC3\x9F dich \xE2\x82\xAC \xF0\x9F\x98\x80")));
+        ASSERT(!str8_is_utf8(S("\xC0\xAF")));         /* overlong */
+        ASSERT(!str8_is_utf8(S("\xED\xA0\x80")));     /* surrogate */
+        ASSERT(!str8_is_utf8(S("\xF4\x90\x80\x80"))); /* > U+10FFFF */
+        ASSERT(!str8_is_utf8(S("abc\xE2\x82")));       /* truncated */
+        buf[280] = 0xFF;
+        ASSERT(!str8_is_utf8(text));
+
+        /* every kernel the cpu supports agrees with the scalar one, for every length */
+        for (u32 level = PLATFORM_SIMD_SCALAR; level <= (u32) platform_simd_level(); level++)
+        {
+            platform_simd_e simd = (platform_simd_e) level;
+            for (u64 len = 0; len <= sizeof(buf); len++)
+            {
+                ASSERT(str8_find_byte_kernel_select(simd)(buf, len, 'X')      == str8_find_byte_scalar(buf, len, 'X'));
+                ASSERT(str8_find_any_kernel_select(simd)(buf, len, (const u8*) "ZY\n", 3) == str8_find_any_scalar(buf, len, (const u8*) "ZY\n", 3));
+                ASSERT(str8_find_kernel_select(simd)(buf, len, (const u8*) "XYZ", 3) == str8_find_scalar(buf, len, (const u8*) "XYZ", 3));
+                ASSERT(str8_count_byte_kernel_select(simd)(buf, len, 'a')     == str8_count_byte_scalar(buf, len, 'a'));
+                ASSERT(str8_skip_ascii_kernel_select(simd)(buf, len)          == str8_skip_ascii_scalar(buf, len));
+            }
+        }
+    }
+
+    /* TEST STRING BUILDER */
+    {
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+
+        strbuild_t sb = strbuild_create(arena);
+        strbuild_append(&sb, S("frame "));
+        strbuild_append_u64(&sb, 18446744073709551615ull);
+        strbuild_append_char(&sb, ' ');
+        strbuild_append_i64(&sb, -9223372036854775807LL - 1);
+        strbuild_append_char(&sb, ' ');
+        strbuild_append_hex(&sb, 0xdeadbeef);
+        strbuild_append_char(&sb, ' ');
+        strbuild_append_f64(&sb, 3.14159, 2);
+        str8 line = strbuild_finish(&sb);
+        ASSERT(str8_equal(line, S("frame 18446744073709551615 -9223372036854775808 deadbeef 3.14")));
+        ASSERT(line.ptr[line.len] == '\0');
+
+        /* printf conversions have to match the c library */
+        #define CHECK_PRINTF(fmt, ...)                                                 \
+        {                                                                              \
+            char expected[256];                                                        \
+            snprintf(expected, sizeof(expected), fmt, __VA_ARGS__);                    \
+            str8 formatted = str8_fmt(arena, fmt, __VA_ARGS__);                        \
+            if (!str8_equal(formatted, str8_cstr(expected))) {                         \
+                fprintf(stderr, "'%s' != '%.*s'\n", expected, STR8_FMT(formatted)); }  \
+            ASSERT(str8_equal(formatted, str8_cstr(expected)));                        \
+        }
+        CHECK_PRINTF("%d|%i|%u|%5d|%-5d|%05d|%+d|% d|%.3d", 42, -42, 7u, 42, 42, -42, 42, 42, 7);
+        CHECK_PRINTF("%x|%X|%#x|%o|%#o|%8.3x|%lld|%zu|%hhd", 255u, 255u, 255u, 8u, 8u, 255u, -1234567890123LL, (size_t) 99, 300);
+        const char* zero_with_precision = "%08.3x"; /* not a literal: -Wformat warns that '0' is ignored */
+        ASSERT(str8_equal(str8_fmt(arena, zero_with_precision, 255u), str8_cstr("     0ff")));
+        CHECK_PRINTF("%s|%10s|%-10s|%.2s|%c|%-3c|%%", "abc", "abc", "abc", "abc", 'z', 'y');
+        CHECK_PRINTF("%f|%.2f|%.0f|%#.0f|%10.3f|%-10.1f|%+f|%010.2f", 3.14159, -2.71828, 2.4, 2.4, 1234.5678, 0.26, 1.5, -3.75);
+        CHECK_PRINTF("%e|%.2e|%E|%.0e|%e", 12345.678, 0.000123, 1e100, 5e-10, 0.0);
+        CHECK_PRINTF("%g|%g|%g|%g|%g|%.3g|%G|%g", 100000.0, 1000000.0, 0.0001, 0.00001, 123.456, 3.14159, 1e-20, 0.0);
+        CHECK_PRINTF("%f|%f|%.1f|%f", 1e20, 123456789012345678.0, -0.0, 1.0 / 3.0);
+        /* long double is read as such (not compared against libc, msvcrt has no 80 bit long double) */
+        ASSERT(str8_equal(str8_fmt(arena, "[%Lf] [%.3Lf] %d", (long double) 1.5, (long double) 2.25, 7), str8_cstr("[1.500000] [2.250] 7")));
+        CHECK_PRINTF("%.*f|%*d|%-*d|%.*s", 3, 1.0, 6, 1, 6, 1, 2, "xyz");
+        #undef CHECK_PRINTF
+
+        /* builders grow in place while on top of the arena, otherwise they chain chunks */
+        strbuild_t a = strbuild_create(arena);
+        strbuild_t b = strbuild_create(arena);
+        for (i32 i = 0; i < 1000; i++)
+        {
+            strbuild_printf(&a, "%i,", i);
+            strbuild_printf(&b, "%i;", i);
+        }
+        ASSERT(a.first != a.last);
+        str8 a_str = strbuild_finish(&a);
+        str8 b_str = strbuild_finish(&b);
+        ASSERT(str8_count_byte(a_str, ',') == 1000 && str8_count_byte(b_str, ';') == 1000);
+        ASSERT(str8_starts_with(a_str, S("0,1,2,")) && str8_ends_with(a_str, S("998,999,")));
+
+        strbuild_t c = strbuild_create(arena);
+        for (i32 i = 0; i < 1000; i++) { strbuild_append(&c, S("0123456789")); }
+        ASSERT(c.first == c.last && strbuild_finish(&c).len == 10000);
+
+        mem_arena_destroy(&arena);
+    }
+
+    /* TEST SMALL STRING OPTIMIZATION */
+    {
+        mem_arena_t* arena = mem_arena_create(MEGABYTES(1));
+
+        string_t str = string_from_cstr("player", NULL);
+        ASSERT(!string_is_long(&str));
+        ASSERT(string_len(&str) == 6);
+        string_append_cstr(&str, "_01", NULL);
+        string_push(&str, '!', NULL);
+        ASSERT(string_len(&str) == 10);
+        ASSERT(string_find(&str, "_01", 3, 0) == 6);
+        ASSERT(string_find(&str, "_02", 3, 0) == -1);
+        ASSERT(string_find(&str, "", 0, 4) == 4);
+
+        /* exactly STRING_SSO_CAP chars fit inline */
+        string_t full = string_empty();
+        for (u32 i = 0; i < STRING_SSO_CAP; i++) { string_push(&full, 'a' + (i % 26), NULL); }
+        ASSERT(!string_is_long(&full));
+        ASSERT(string_len(&full) == STRING_SSO_CAP);
+        ASSERT(string_cstr(&full)[STRING_SSO_CAP] == '\0');
+        string_t sub = string_substr(&full, 2, 3, NULL);
+        ASSERT(!string_is_long(&sub) && mem_equal(string_cstr(&sub), (void*) "cde", 4));
+
+        /* spill into malloc'ed long mode */
+        string_push(&full, '#', NULL);
+        ASSERT(string_is_long(&full));
+        ASSERT(string_len(&full) == STRING_SSO_CAP + 1);
+        ASSERT(string_cstr(&full)[0] == 'a' && string_cstr(&full)[STRING_SSO_CAP] == '#');
+        string_reserve(&full, 1000, NULL);
+        ASSERT(string_cap(&full) >= 1000 && string_len(&full) == STRING_SSO_CAP + 1);
+        string_free(&full);
+        ASSERT(string_len(&full) == 0);
+
+        /* spill into arena memory, grows in place while it is on top of the arena */
+        string_t log_line = string_from_cstr("[INFO ]", arena);
+        for (i32 i = 0; i < 100; i++) { string_append_cstr(&log_line, " more text", arena); }
+        ASSERT(string_is_long(&log_line));
+        ASSERT(string_len(&log_line) == 7 + 100 * 10);
+        ASSERT(string_find(&log_line, "more", 4, 9) == 18);
+
+        string_t copy = string_from(string_cstr(&log_line), string_len(&log_line), NULL);
+        ASSERT(string_equal(&copy, &log_line));
+        ASSERT(!string_equal(&copy, &str));
+        string_free(&copy);
+        string_free(&log_line); /* no-op for arena strings */
+        string_free(&str);
+
+        #if defined(LANGUAGE_CPP)
+        string_t cpp_str = string_from_cstr("abc", NULL);
+        ASSERT(cpp_str.len() == 3);
+        cpp_str[1] = 'B';
+        ASSERT(cpp_str.c_str()[1] == 'B');
+        #endif
+
+        mem_arena_destroy(&arena);
+    }
+
     /* TEST DYNAMIC ARRAY */
     {
         i32* array              = (i32*) dynarr_create(sizeof(i32));